@@ -0,0 +1,57 @@
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+// Helpers shared by the sampler microbenchmarks
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+namespace bench {
+
+// Write a file in /proc/net/dev format with `count` interfaces: eth0
+// followed by veth1..veth<count-1>. Returns the path; the caller unlinks it.
+inline std::string writeSyntheticNetDev(int count) {
+    char path[] = "/tmp/bench_net_dev_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        std::perror("mkstemp");
+        std::exit(1);
+    }
+    close(fd);
+
+    std::ofstream out(path);
+    out << "Inter-|   Receive                                                |  Transmit\n"
+           " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed\n";
+    for (int i = 0; i < count; ++i) {
+        char line[256];
+        std::snprintf(line, sizeof(line),
+                      "%6s%d: %llu %llu 0 0 0 0 0 0 %llu %llu 0 0 0 0 0 0\n",
+                      i == 0 ? "eth" : "veth", i,
+                      1000000ULL + i, 1000ULL + i, 2000000ULL + i, 2000ULL + i);
+        out << line;
+    }
+    return path;
+}
+
+// Average wall time of fn() in nanoseconds. fn returns a value that is
+// accumulated so the work cannot be optimised away.
+template <typename Fn>
+double nsPerCall(int iterations, Fn&& fn) {
+    volatile uint64_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        sink = sink + static_cast<uint64_t>(fn());
+    }
+    auto end = std::chrono::steady_clock::now();
+    (void)sink;
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+} // namespace bench
+
+#endif // BENCH_COMMON_H
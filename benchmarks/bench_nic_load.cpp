@@ -0,0 +1,68 @@
+// Cost of one NicLoadSampler tick (/proc/softirqs, the NIC's lines in
+// /proc/interrupts and the ethtool queue counters) next to the main
+// sampler's own counter read, both through the real files of this host.
+//
+//   ./bench_nic_load [iterations] [interface]
+
+#include "../include/nic_load.h"
+#include "../include/counter_backend.h"
+#include "../include/proc_net_dev_reader.h"
+#include "bench_common.h"
+#include <memory>
+
+int main(int argc, char* argv[]) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 20000;
+    if (iterations <= 0) {
+        iterations = 20000;
+    }
+    std::string iface = argc > 2 ? argv[2] : "";
+
+    ProcNetDevReader reader;
+    if (iface.empty() && reader.refresh()) {
+        reader.forEach([&](const char* name, size_t len, const uint64_t*) {
+            std::string n(name, len);
+            if (iface.empty() && n != "lo") {
+                iface = n;
+            }
+        });
+    }
+    if (iface.empty()) {
+        std::fprintf(stderr, "no interface found\n");
+        return 1;
+    }
+
+    NicLoadSampler sampler;
+    if (!sampler.isOpen()) {
+        std::fprintf(stderr, "/proc/softirqs unavailable\n");
+        return 1;
+    }
+    sampler.setInterface(iface);
+    sampler.sample(0.0);
+    std::printf("iterations: %d  interface: %s  cpus: %zu  irq lines: %d  queues with bytes: %zu\n",
+                iterations, iface.c_str(), sampler.load().cpus.size(), sampler.load().nic_irq_lines,
+                sampler.load().queues.size());
+
+    const double procNetDev = bench::nsPerCall(iterations, [&]() {
+        NetStats stats{};
+        reader.read(iface, stats);
+        return stats.rx_bytes;
+    });
+    std::printf("%-34s %10.0f ns/sample\n", "main sampler: /proc/net/dev", procNetDev);
+
+    std::unique_ptr<CounterBackend> netlink = createNetlinkBackend(iface);
+    if (netlink) {
+        const double ns = bench::nsPerCall(iterations, [&]() {
+            NetStats stats{};
+            netlink->read(stats);
+            return stats.rx_bytes;
+        });
+        std::printf("%-34s %10.0f ns/sample\n", "main sampler: RTM_GETLINK", ns);
+    }
+
+    const double nicLoad = bench::nsPerCall(iterations, [&]() {
+        sampler.sample(1.0);
+        return sampler.load().cpus.size();
+    });
+    std::printf("%-34s %10.0f ns/sample\n", "NicLoadSampler (all sources)", nicLoad);
+    return 0;
+}
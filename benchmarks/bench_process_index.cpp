@@ -0,0 +1,142 @@
+// Cost of one per-process traffic refresh (sock_diag dump + inode->PID
+// index + per-PID aggregation) with many open TCP sockets.
+//
+// Opens `pairs` loopback connections in this process (two sockets each),
+// then times a cold refresh, which walks every fd of every process, a
+// steady refresh with no new sockets, and a refresh after a few new
+// connections, which only readlink()s the new fds.
+//
+//   ./bench_process_index [pairs]
+
+#include "../include/process_traffic.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+double cpuMs() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+int listenLoopback(sockaddr_in& addr) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    addr = sockaddr_in();
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(addr);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&addr), length) != 0 || listen(fd, 4096) != 0 ||
+        getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &length) != 0) {
+        std::perror("listen");
+        std::exit(1);
+    }
+    return fd;
+}
+
+// Connect/accept `count` pairs; returns false once fds run out
+bool openPairs(int listener, const sockaddr_in& addr, int count, std::vector<int>& fds) {
+    for (int i = 0; i < count; ++i) {
+        int client = socket(AF_INET, SOCK_STREAM, 0);
+        if (client < 0 || connect(client, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            if (client >= 0) close(client);
+            return false;
+        }
+        int server = accept(listener, nullptr, nullptr);
+        if (server < 0) {
+            close(client);
+            return false;
+        }
+        fds.push_back(client);
+        fds.push_back(server);
+    }
+    return true;
+}
+
+template <typename Fn>
+void report(const char* what, ProcessTraffic& traffic, Fn&& fn) {
+    const double cpu = cpuMs();
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    const double wall = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-28s %9.2f ms wall %9.2f ms cpu %8zu readlink %8zu sockets\n", what, wall, cpuMs() - cpu,
+                traffic.index().lastLinksRead(), traffic.socketCount());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int pairs = argc > 1 ? std::atoi(argv[1]) : 25000;
+
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    ProcessTraffic traffic; // opens its netlink socket before the fds run out
+    if (!traffic.isAvailable()) {
+        std::fprintf(stderr, "sock_diag unavailable\n");
+        return 1;
+    }
+
+    sockaddr_in addr;
+    const int listener = listenLoopback(addr);
+    std::vector<int> fds;
+    if (!openPairs(listener, addr, pairs, fds)) {
+        std::printf("fd limit reached after %zu sockets\n", fds.size());
+    }
+    // Leave room for the 20 sockets opened below
+    for (int i = 0; i < 32 && fds.size() >= 2; ++i) {
+        close(fds.back());
+        fds.pop_back();
+    }
+    if (fds.size() % 2) {
+        close(fds.back());
+        fds.pop_back();
+    }
+    report("baseline dump", traffic, [&] { traffic.refresh(1.0); });
+    // The first dump only sets baselines, so push a byte through each
+    // socket pair to make every socket unknown-with-traffic on the next one
+    for (size_t i = 0; i < fds.size(); i += 2) {
+        if (write(fds[i], "x", 1) != 1) break;
+    }
+    report("cold refresh (full scan)", traffic, [&] { traffic.refresh(1.0); });
+    report("steady refresh", traffic, [&] { traffic.refresh(1.0); });
+
+    // Kernel share of the above: the bare dump, no index or aggregation
+    SockDiag diag;
+    size_t dumped = 0;
+    const double dumpCpu = cpuMs();
+    diag.dumpTcp(tcpStateBit(TCP_ESTABLISHED), [&](const TcpSocketInfo&) { ++dumped; });
+    std::printf("%-28s %9s    %9.2f ms cpu %8s          %8zu sockets\n", "bare sock_diag dump", "", cpuMs() - dumpCpu,
+                "", dumped);
+
+    std::vector<int> extra;
+    openPairs(listener, addr, 10, extra);
+    for (size_t i = 0; i < extra.size(); i += 2) {
+        if (write(extra[i], "x", 1) != 1) break;
+    }
+    report("refresh, 20 new sockets", traffic, [&] { traffic.refresh(1.0); });
+    report("steady refresh", traffic, [&] { traffic.refresh(1.0); });
+
+    std::vector<ProcessRate> top;
+    traffic.top(5, top);
+    for (const ProcessRate& rate : top) {
+        std::printf("  %-16s %7d %12.0f B/s down %12.0f B/s up\n", rate.name.c_str(), rate.pid, rate.rx_rate,
+                    rate.tx_rate);
+    }
+
+    for (int fd : fds) close(fd);
+    for (int fd : extra) close(fd);
+    close(listener);
+    return 0;
+}
@@ -0,0 +1,114 @@
+// Microbenchmark for the rate-filter pipelines.
+//
+// Runs a synthetic rate stream (a stepped true rate with multiplicative
+// noise, occasional single-sample spikes and jittered intervals) through
+// every filter, both as a compile-time FilterChain and through the runtime
+// RateFilter selector. Reports the cost per sample and the RMS error
+// against the true rate, relative to the raw samples' error.
+//
+//   ./bench_rate_filter [iterations]
+
+#include "../include/rate_filter.h"
+#include "bench_common.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr size_t kSamples = 4096; // power of two, wraps with a mask
+
+struct Stream {
+    std::vector<double> truth;
+    std::vector<double> raw;
+    std::vector<double> dt;
+};
+
+Stream makeStream() {
+    Stream s;
+    std::mt19937_64 rng(42);
+    std::normal_distribution<double> noise(0.0, 0.15);
+    std::uniform_real_distribution<double> jitter(0.9, 1.3);
+    std::uniform_int_distribution<int> spike(0, 49);
+    const double levels[] = {2e3, 5e6, 1.2e7, 3e5, 8e6};
+    for (size_t i = 0; i < kSamples; ++i) {
+        const double truth = levels[(i / 256) % 5];
+        double raw = truth * std::max(0.0, 1.0 + noise(rng));
+        if (spike(rng) == 0) raw *= 6.0;
+        s.truth.push_back(truth);
+        s.raw.push_back(raw);
+        s.dt.push_back(jitter(rng));
+    }
+    return s;
+}
+
+// RMS error of filter output against the true rate over the whole
+// stream, relative to the RMS of the true rate
+template <typename Filter>
+double rmsError(Filter filter, const Stream& s) {
+    double err2 = 0.0;
+    double truth2 = 0.0;
+    for (size_t i = 0; i < kSamples; ++i) {
+        const double err = filter.apply(s.raw[i], s.dt[i]) - s.truth[i];
+        err2 += err * err;
+        truth2 += s.truth[i] * s.truth[i];
+    }
+    return std::sqrt(err2 / truth2);
+}
+
+template <typename Filter>
+void runChain(const char* name, const Stream& s, int iterations, double rawError) {
+    Filter filter;
+    size_t i = 0;
+    const double ns = bench::nsPerCall(iterations, [&]() {
+        const double out = filter.apply(s.raw[i], s.dt[i]);
+        i = (i + 1) & (kSamples - 1);
+        return static_cast<uint64_t>(out);
+    });
+    std::printf("%-22s %10.2f %14.3f\n", name, ns, rmsError(Filter(), s) / rawError);
+}
+
+void runSelector(const char* name, RateFilterKind kind, const Stream& s, int iterations) {
+    RateFilter filter(kind);
+    size_t i = 0;
+    const double ns = bench::nsPerCall(iterations, [&]() {
+        const double out = filter.update(s.raw[i], s.dt[i]);
+        i = (i + 1) & (kSamples - 1);
+        return static_cast<uint64_t>(out);
+    });
+    std::printf("%-22s %10.2f\n", name, ns);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 10000000;
+    if (iterations <= 0) {
+        iterations = 10000000;
+    }
+    using namespace rate_filter;
+
+    const Stream s = makeStream();
+    const double rawError = rmsError(FilterChain<>(), s);
+
+    std::printf("iterations: %d, raw RMS error %.3f\n", iterations, rawError);
+    std::printf("%-22s %10s %14s\n", "compile-time chain", "ns/sample", "error vs raw");
+    runChain<FilterChain<>>("none", s, iterations, rawError);
+    runChain<FilterChain<Ema>>("ema", s, iterations, rawError);
+    runChain<FilterChain<TimeConstantEma>>("ema-dt", s, iterations, rawError);
+    runChain<FilterChain<WindowMean<8>>>("mean(8)", s, iterations, rawError);
+    runChain<FilterChain<WindowMedian<5>>>("median(5)", s, iterations, rawError);
+    runChain<FilterChain<Kalman>>("kalman", s, iterations, rawError);
+    runChain<FilterChain<WindowMedian<5>, Ema>>("median(5)+ema", s, iterations, rawError);
+
+    std::printf("\n%-22s %10s\n", "runtime selector", "ns/sample");
+    runSelector("ema", RateFilterKind::Ema, s, iterations);
+    runSelector("ema-dt", RateFilterKind::TimeConstantEma, s, iterations);
+    runSelector("mean(8)", RateFilterKind::WindowMean, s, iterations);
+    runSelector("median(5)", RateFilterKind::Median, s, iterations);
+    runSelector("kalman", RateFilterKind::Kalman, s, iterations);
+    runSelector("median(5)+ema", RateFilterKind::MedianEma, s, iterations);
+    return 0;
+}
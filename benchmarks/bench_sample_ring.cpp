@@ -0,0 +1,191 @@
+// Stress benchmark for the shared-memory sample ring.
+//
+// Forks several reader processes that map the ring read-only, then writes
+// synthetic samples from the parent in two phases:
+//
+//   paced      one sample every 10 ms (the fastest sampler period) while
+//              readers poll every millisecond; nothing may be lost
+//   flat out   samples as fast as the writer can go into a small ring while
+//              readers spin, so they are lapped and must report the loss
+//
+// Every field of a synthetic sample is derived from its seq, so a reader
+// can tell a torn copy from a whole one. Reports per reader the samples
+// read, samples lost, torn copies (must be 0) and the cost of a read.
+//
+//   ./bench_sample_ring [readers] [paced seconds]
+
+#include "../include/sample_ring.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+struct ReaderResult {
+    uint64_t samples;
+    uint64_t lost;
+    uint64_t torn;
+    uint64_t out_of_order;
+    double ns_per_read;
+};
+
+MetricsSnapshot syntheticSample(uint64_t seq) {
+    MetricsSnapshot s;
+    std::memset(&s, 0, sizeof(s));
+    s.seq = seq;
+    s.sample_ns = static_cast<int64_t>(seq * 10000000);
+    s.total_rx_bytes = seq * 1500;
+    s.total_tx_bytes = seq * 700;
+    s.instant_rx_rate = static_cast<double>(seq) * 2.0;
+    s.instant_tx_rate = static_cast<double>(seq) * 3.0;
+    s.rx_rate = static_cast<double>(seq) * 4.0;
+    s.tx_rate = static_cast<double>(seq) * 5.0;
+    s.total_rx_packets = seq * 7;
+    s.total_tx_packets = seq * 11;
+    s.total_rx_dropped = seq * 13;
+    s.total_tx_dropped = seq * 17;
+    s.total_rx_errors = seq * 19;
+    s.total_tx_errors = seq * 23;
+    s.sample_period_ms = static_cast<int32_t>(seq % 1000);
+    std::snprintf(s.iface, sizeof(s.iface), "eth%u", static_cast<unsigned>(seq % 100));
+    return s;
+}
+
+bool consistent(const MetricsSnapshot& s) {
+    const MetricsSnapshot want = syntheticSample(s.seq);
+    return std::memcmp(&s, &want, sizeof(s)) == 0;
+}
+
+// Read until the writer closes the ring; `spin` polls without sleeping
+ReaderResult runReader(const std::string& name, bool spin) {
+    ReaderResult result = ReaderResult();
+    SampleRingReader reader;
+    if (!reader.open(name)) {
+        std::fprintf(stderr, "reader: cannot open %s\n", name.c_str());
+        std::exit(1);
+    }
+    reader.skipToEnd();
+    uint64_t last_seq = 0;
+    double read_ns = 0.0;
+    MetricsSnapshot sample;
+    for (;;) {
+        const bool gone = reader.writerGone();
+        const auto start = std::chrono::steady_clock::now();
+        bool got = reader.next(sample, &result.lost);
+        if (got) {
+            read_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            ++result.samples;
+            if (!consistent(sample)) {
+                ++result.torn;
+            }
+            if (last_seq != 0 && sample.seq <= last_seq) {
+                ++result.out_of_order;
+            }
+            last_seq = sample.seq;
+            continue;
+        }
+        if (gone) {
+            break; // drained after the writer closed
+        }
+        if (!spin) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    result.ns_per_read = result.samples ? read_ns / static_cast<double>(result.samples) : 0.0;
+    return result;
+}
+
+// Run one phase: fork the readers, let them attach, then write
+void runPhase(const char* title, const std::string& name, int readers, uint32_t capacity,
+              uint64_t samples, std::chrono::microseconds period) {
+    SampleRingWriter writer;
+    if (!writer.open(name, capacity)) {
+        std::fprintf(stderr, "cannot create ring %s\n", name.c_str());
+        std::exit(1);
+    }
+
+    std::vector<pid_t> children;
+    std::vector<int> pipes;
+    for (int i = 0; i < readers; ++i) {
+        int fds[2];
+        if (::pipe(fds) != 0) {
+            std::perror("pipe");
+            std::exit(1);
+        }
+        const pid_t pid = ::fork();
+        if (pid == 0) {
+            ::close(fds[0]);
+            const ReaderResult result = runReader(name, period.count() == 0);
+            ssize_t ignored = ::write(fds[1], &result, sizeof(result));
+            (void)ignored;
+            ::_exit(0);
+        }
+        ::close(fds[1]);
+        children.push_back(pid);
+        pipes.push_back(fds[0]);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200)); // readers attach
+
+    const auto start = std::chrono::steady_clock::now();
+    auto next_due = start;
+    for (uint64_t seq = 1; seq <= samples; ++seq) {
+        writer.publish(syntheticSample(seq));
+        if (period.count() > 0) {
+            next_due += period;
+            std::this_thread::sleep_until(next_due);
+        }
+    }
+    const double write_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    writer.close();
+
+    std::printf("\n%s: %llu samples, ring of %u slots", title, static_cast<unsigned long long>(samples), capacity);
+    if (period.count() == 0) {
+        std::printf(", %.1f ns/publish", write_ns / static_cast<double>(samples));
+    }
+    std::printf("\n%-8s %10s %10s %6s %8s %10s\n", "reader", "samples", "lost", "torn", "reorder", "ns/read");
+    uint64_t torn = 0;
+    for (size_t i = 0; i < children.size(); ++i) {
+        ReaderResult result = ReaderResult();
+        if (::read(pipes[i], &result, sizeof(result)) != static_cast<ssize_t>(sizeof(result))) {
+            std::fprintf(stderr, "reader %zu failed\n", i);
+        }
+        ::close(pipes[i]);
+        ::waitpid(children[i], nullptr, 0);
+        torn += result.torn + result.out_of_order;
+        std::printf("%-8zu %10llu %10llu %6llu %8llu %10.1f\n", i,
+                    static_cast<unsigned long long>(result.samples),
+                    static_cast<unsigned long long>(result.lost),
+                    static_cast<unsigned long long>(result.torn),
+                    static_cast<unsigned long long>(result.out_of_order), result.ns_per_read);
+    }
+    if (torn != 0) {
+        std::printf("FAILED: torn or reordered samples\n");
+        std::exit(1);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int readers = argc > 1 ? std::atoi(argv[1]) : 4;
+    int seconds = argc > 2 ? std::atoi(argv[2]) : 5;
+    if (readers <= 0) readers = 4;
+    if (seconds <= 0) seconds = 5;
+    const std::string name = "/bench-sample-ring-" + std::to_string(::getpid());
+
+    std::printf("readers: %d, slot %zu bytes, payload %zu bytes\n", readers, sample_ring::kSlotStride,
+                sizeof(MetricsSnapshot));
+    runPhase("paced at 10 ms", name, readers, sample_ring::kDefaultCapacity,
+             static_cast<uint64_t>(seconds) * 100, std::chrono::milliseconds(10));
+    runPhase("flat out", name, readers, 64, 5000000, std::chrono::microseconds(0));
+    ::shm_unlink(name.c_str());
+    return 0;
+}
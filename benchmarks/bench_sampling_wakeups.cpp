@@ -0,0 +1,92 @@
+// Wakeups per hour of the sampler with a fixed period and with
+// AdaptiveSampling.
+//
+// The first table replays one simulated hour of three traffic patterns
+// against each policy. The second runs the real SampleScheduler on an idle
+// link for a few seconds, counts the timerfd wakeups and scales them to an
+// hour, so the simulation can be checked against the kernel timer.
+//
+//   ./bench_sampling_wakeups [live seconds]
+
+#include "../include/sample_scheduler.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using std::chrono::milliseconds;
+
+namespace {
+
+constexpr int64_t kHourMs = 3600 * 1000;
+
+// Traffic patterns: whether any byte moves at time t (ms into the hour)
+bool idleLink(int64_t) { return false; }
+bool bursty(int64_t t) { return t % (10 * 60 * 1000) < 30 * 1000; } // 30 s every 10 min
+bool busyLink(int64_t) { return true; }
+
+uint64_t fixedWakeups(milliseconds period) {
+    return static_cast<uint64_t>(kHourMs / period.count());
+}
+
+uint64_t adaptiveWakeups(milliseconds fast, milliseconds slow, bool (*traffic)(int64_t)) {
+    AdaptiveSampling policy(fast, slow);
+    uint64_t wakeups = 0;
+    for (int64_t t = 0; t < kHourMs;) {
+        ++wakeups;
+        t += policy.next(traffic(t) ? 1 : 0).count();
+    }
+    return wakeups;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int liveSeconds = argc > 1 ? std::atoi(argv[1]) : 15;
+    if (liveSeconds <= 0) {
+        liveSeconds = 15;
+    }
+
+    struct Pattern {
+        const char* name;
+        bool (*traffic)(int64_t);
+    };
+    const Pattern patterns[] = {{"idle", idleLink}, {"bursty", bursty}, {"busy", busyLink}};
+    const milliseconds fastPeriods[] = {milliseconds(500), milliseconds(1000)};
+    const milliseconds slow(5000);
+
+    std::printf("simulated hour, idle cap %lld ms\n", static_cast<long long>(slow.count()));
+    std::printf("%8s %8s %12s %12s %10s\n", "pattern", "fast ms", "fixed/h", "adaptive/h", "saved");
+    for (const Pattern& pattern : patterns) {
+        for (milliseconds fast : fastPeriods) {
+            const uint64_t fixed = fixedWakeups(fast);
+            const uint64_t adaptive = adaptiveWakeups(fast, slow, pattern.traffic);
+            std::printf("%8s %8lld %12llu %12llu %9.1f%%\n", pattern.name,
+                        static_cast<long long>(fast.count()),
+                        static_cast<unsigned long long>(fixed),
+                        static_cast<unsigned long long>(adaptive),
+                        100.0 * (1.0 - static_cast<double>(adaptive) / fixed));
+        }
+    }
+
+    // Live run on an idle link, with periods scaled down 10x so the back-off
+    // is reached within a few seconds
+    const milliseconds liveFast(100);
+    const milliseconds liveSlow(500);
+    SampleScheduler scheduler(liveFast);
+    AdaptiveSampling policy(liveFast, liveSlow);
+    SampleTick tick;
+    uint64_t wakeups = 0;
+    const int64_t start = SampleScheduler::monotonicNs();
+    const int64_t end = start + static_cast<int64_t>(liveSeconds) * 1000000000LL;
+    while (scheduler.wait(tick) && tick.monotonic_ns < end) {
+        ++wakeups;
+        scheduler.setPeriod(policy.next(0));
+    }
+    const double elapsed = static_cast<double>(tick.monotonic_ns - start) / 1e9;
+    std::printf("\nlive idle run: %llu wakeups in %.2f s (fast %lld ms, idle cap %lld ms)\n",
+                static_cast<unsigned long long>(wakeups), elapsed,
+                static_cast<long long>(liveFast.count()), static_cast<long long>(liveSlow.count()));
+    std::printf("  %.0f wakeups/h adaptive vs %.0f wakeups/h fixed\n",
+                wakeups * 3600.0 / elapsed, 3600.0 * 1000.0 / liveFast.count());
+    return 0;
+}
@@ -0,0 +1,118 @@
+// Microbenchmark for the usage prefix-sum index.
+//
+// Builds ten years of daily totals and ninety days of hourly totals
+// (grown one slot at a time, as DataManager does), then compares window
+// queries against summing the same slots in a loop: a calendar month, a
+// rolling 30 days, a whole year and the last 24 hours. Every answer is
+// checked against the loop, including after random updates, slots
+// prepended at the front and slots lowered back to zero. Exits non-zero on
+// a mismatch.
+//
+//   ./bench_usage_index [iterations]
+
+#include "../include/usage_index.h"
+#include "bench_common.h"
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr size_t kDays = 3653;
+constexpr size_t kHours = 90 * 24;
+
+ByteTotals scan(const std::vector<ByteTotals>& values, size_t from, size_t to) {
+    ByteTotals total = ByteTotals();
+    for (size_t i = from; i < to && i < values.size(); ++i) {
+        total.download_bytes += values[i].download_bytes;
+        total.upload_bytes += values[i].upload_bytes;
+    }
+    return total;
+}
+
+bool same(const ByteTotals& a, const ByteTotals& b) {
+    return a.download_bytes == b.download_bytes && a.upload_bytes == b.upload_bytes;
+}
+
+// Random windows of the index against the loop
+bool check(const UsageIndex& index, std::mt19937_64& rng, const char* stage) {
+    std::uniform_int_distribution<size_t> slot(0, index.size());
+    for (int i = 0; i < 20000; ++i) {
+        size_t from = slot(rng);
+        size_t to = slot(rng);
+        if (from > to) std::swap(from, to);
+        if (!same(index.sum(from, to), scan(index.values(), from, to))) {
+            std::fprintf(stderr, "mismatch %s: [%zu, %zu)\n", stage, from, to);
+            return false;
+        }
+    }
+    return true;
+}
+
+void fill(UsageIndex& index, size_t slots, std::mt19937_64& rng) {
+    std::uniform_int_distribution<uint64_t> bytes(0, 50ULL << 30);
+    for (size_t i = 0; i < slots; ++i) {
+        index.resize(i + 1);
+        index.add(i, bytes(rng), bytes(rng) / 8);
+    }
+}
+
+template <typename Query>
+void row(const char* name, int iterations, Query query) {
+    std::printf("%-18s %10.1f\n", name, bench::nsPerCall(iterations, query));
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    if (iterations <= 0) {
+        iterations = 1000000;
+    }
+
+    std::mt19937_64 rng(7);
+    UsageIndex days;
+    UsageIndex hours;
+    fill(days, kDays, rng);
+    fill(hours, kHours, rng);
+
+    if (!check(days, rng, "days") || !check(hours, rng, "hours")) {
+        return 1;
+    }
+
+    // Updates, front growth and resets keep the index consistent
+    std::uniform_int_distribution<size_t> anyDay(0, kDays - 1);
+    for (int i = 0; i < 1000; ++i) {
+        days.add(anyDay(rng), 12345, 678);
+    }
+    days.prepend(31);
+    days.add(0, 1, 2);
+    days.resize(days.size() + 40);
+    for (int i = 0; i < 100; ++i) {
+        days.set(anyDay(rng), ByteTotals());
+    }
+    if (!check(days, rng, "after updates")) {
+        return 1;
+    }
+
+    const size_t today = days.size() - 41;
+    const size_t monthStart = today - 16;
+    std::printf("iterations: %d, %zu day slots, %zu hour slots\n", iterations, days.size(), hours.size());
+    std::printf("%-18s %10s\n", "query", "ns/query");
+    row("month (index)", iterations, [&]() { return days.sum(monthStart, today + 1).total(); });
+    row("month (scan)", iterations, [&]() { return scan(days.values(), monthStart, today + 1).total(); });
+    row("30 days (index)", iterations, [&]() { return days.sum(today - 29, today + 1).total(); });
+    row("30 days (scan)", iterations, [&]() { return scan(days.values(), today - 29, today + 1).total(); });
+    row("year (index)", iterations, [&]() { return days.sum(today - 364, today + 1).total(); });
+    row("year (scan)", iterations, [&]() { return scan(days.values(), today - 364, today + 1).total(); });
+    row("24 hours (index)", iterations, [&]() { return hours.sum(kHours - 24, kHours).total(); });
+    row("24 hours (scan)", iterations, [&]() { return scan(hours.values(), kHours - 24, kHours).total(); });
+    size_t next = 0;
+    row("add", iterations, [&]() {
+        days.add(next, 1, 1);
+        next = (next + 7) % kDays;
+        return next;
+    });
+    return 0;
+}
@@ -15,8 +15,25 @@ echo "Building Windows executable directly with MinGW..."
 x86_64-w64-mingw32-g++ \
     ../src/main_windows.cpp \
     ../src/speed_monitor.cpp \
+    ../src/sample_engine.cpp \
+    ../src/proc_net_dev_reader.cpp \
+    ../src/counter_backend.cpp \
+    ../src/interface_table.cpp \
+    ../src/route_watcher.cpp \
+    ../src/sock_diag.cpp \
+    ../src/process_traffic.cpp \
+    ../src/nic_load.cpp \
+    ../src/rate_histogram.cpp \
+    ../src/rate_filter.cpp \
+    ../src/sample_scheduler.cpp \
+    ../src/label_renderer.cpp \
+    ../src/logger.cpp \
     ../src/helpers.cpp \
     ../src/data_manager.cpp \
+    ../src/usage_journal.cpp \
+    ../src/calendar_day.cpp \
+    ../src/usage_index.cpp \
+    ../src/usage_writer.cpp \
     ../src/speed_test.cpp \
     ../src/download_test.cpp \
     ../src/upload_test.cpp \
@@ -0,0 +1,49 @@
+#ifndef CALENDAR_DAY_H
+#define CALENDAR_DAY_H
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+// Local calendar days as integers: days since 1970-01-01 in the proleptic
+// Gregorian calendar. DataManager keys its history by day number, so
+// lookups and month grouping are arithmetic; "YYYY-MM-DD" text is made
+// only for files and for its string-based API.
+namespace calendar {
+
+int32_t daysFromCivil(int year, unsigned month, unsigned day);
+void civilFromDays(int32_t days, int& year, unsigned& month, unsigned& day);
+
+// "YYYY-MM-DD"; false if it is not a date
+bool parseDate(const std::string& date, int32_t& days);
+// "YYYY-MM" as the day range [first, end)
+bool parseMonth(const std::string& month, int32_t& first, int32_t& end);
+std::string formatDate(int32_t days);
+// "YYYY-MM" of the month holding days
+std::string formatMonth(int32_t days);
+
+int32_t firstOfMonth(int32_t days);
+int32_t firstOfNextMonth(int32_t days);
+
+// Today's local day number and hour. localtime runs once per hour: the
+// answer is kept until the next local hour starts (or until the clock is
+// set back before the current one).
+class LocalToday {
+public:
+    LocalToday();
+    int32_t day();
+    // 0-23
+    int hour();
+
+private:
+    void refresh();
+
+    int32_t day_;
+    int hour_;
+    std::time_t valid_from_;   // start of the local hour
+    std::time_t valid_until_;  // start of the next one
+};
+
+} // namespace calendar
+
+#endif // CALENDAR_DAY_H
@@ -0,0 +1,55 @@
+#ifndef COUNTER_BACKEND_H
+#define COUNTER_BACKEND_H
+
+#include <memory>
+#include <string>
+#include "net_stats.h"
+#include "proc_net_dev_reader.h"
+
+// Where interface counters are read from
+enum class CounterSource {
+    Netlink,     // RTM_GETLINK / IFLA_STATS64 (binary, one round-trip)
+    ProcNetDev   // text parsing of /proc/net/dev
+};
+
+// Source of raw counters for a single interface
+class CounterBackend {
+public:
+    virtual ~CounterBackend() = default;
+
+    virtual const char* name() const = 0;
+
+    // Select the interface whose counters read() returns
+    virtual bool setInterface(const std::string& iface) = 0;
+
+    virtual bool read(NetStats& stats) = 0;
+};
+
+// /proc/net/dev backend on top of ProcNetDevReader
+class ProcNetDevBackend : public CounterBackend {
+public:
+    explicit ProcNetDevBackend(const std::string& iface);
+
+    const char* name() const override { return "procfs"; }
+    bool setInterface(const std::string& iface) override;
+    bool read(NetStats& stats) override;
+
+private:
+    ProcNetDevReader reader_;
+    std::string iface_;
+};
+
+// Parse "netlink" / "procfs" (case-sensitive); anything else gives fallback
+CounterSource parseCounterSource(const char* value, CounterSource fallback);
+
+// Counter source requested through SPEED_METER_BACKEND, netlink by default
+CounterSource counterSourceFromEnvironment();
+
+// Netlink backend for iface, or nullptr when rtnetlink is not usable
+std::unique_ptr<CounterBackend> createNetlinkBackend(const std::string& iface);
+
+// Backend for the preferred source, falling back to /proc/net/dev
+std::unique_ptr<CounterBackend> openCounterBackend(CounterSource preferred,
+                                                   const std::string& iface);
+
+#endif // COUNTER_BACKEND_H
@@ -11,6 +11,10 @@ struct UsageRecord {
     double uploadSpeed;
     double totalDownload;
     double totalUpload;
+    double downloadPacketRate;  // packets/s
+    double uploadPacketRate;
+    double downloadDropRate;    // dropped packets/s
+    double uploadDropRate;
 };
 
 class DataExporter {
@@ -4,10 +4,14 @@
 #include <string>
 #include <vector>
 #include <chrono>
-#include <map>
+#include <memory>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
+#include "calendar_day.h"
+#include "rate_histogram.h"
+#include "usage_index.h"
+#include "usage_writer.h"
 
 struct DailyStats {
     std::string date;  // YYYY-MM-DD format
@@ -17,6 +21,15 @@ struct DailyStats {
     double peak_upload_speed;    // bytes per second
     uint64_t session_count;
     std::chrono::seconds total_session_time;
+    uint64_t total_download_packets;
+    uint64_t total_upload_packets;
+    uint64_t download_dropped;
+    uint64_t upload_dropped;
+    uint64_t download_errors;
+    uint64_t upload_errors;
+    double peak_download_packet_rate;  // packets per second
+    double peak_upload_packet_rate;
+    RateDigest rates;  // every raw rate sample of the day
 };
 
 struct MonthlyStats {
@@ -28,6 +41,38 @@ struct MonthlyStats {
     double avg_daily_download;
     double avg_daily_upload;
     uint32_t active_days;
+    uint64_t total_download_packets;
+    uint64_t total_upload_packets;
+    uint64_t download_dropped;
+    uint64_t upload_dropped;
+    uint64_t download_errors;
+    uint64_t upload_errors;
+    double peak_download_packet_rate;
+    double peak_upload_packet_rate;
+    RateDigest rates;  // the month's daily digests merged
+};
+
+// Packet counters accumulated since the previous updateDailyStats() call,
+// plus the packet rates at the time of the call
+struct PacketActivity {
+    uint64_t download_packets;
+    uint64_t upload_packets;
+    uint64_t download_dropped;
+    uint64_t upload_dropped;
+    uint64_t download_errors;
+    uint64_t upload_errors;
+    double download_packet_rate;
+    double upload_packet_rate;
+};
+
+// Outcome of the most recent speed test, kept so a collector can export it
+struct SpeedTestRecord {
+    int64_t unix_time;     // when the test finished
+    double download_mbps;
+    double upload_mbps;
+    double ping_ms;
+    double jitter_ms;
+    std::string server;
 };
 
 class DataManager {
@@ -38,7 +83,12 @@ public:
     // Daily statistics
     void updateDailyStats(uint64_t download_bytes, uint64_t upload_bytes,
                          double current_download_speed, double current_upload_speed,
-                         std::chrono::seconds session_time);
+                         std::chrono::seconds session_time,
+                         const PacketActivity& packets = PacketActivity());
+    // Merge rate samples taken since the last call into today's digest;
+    // raises the day's peaks to the largest raw rate. Saved with the next
+    // updateDailyStats() or saveData().
+    void recordRates(const RateDigest& samples);
     DailyStats getTodayStats() const;
     DailyStats getDailyStats(const std::string& date) const;
     std::vector<DailyStats> getDailyStatsRange(const std::string& start_date,
@@ -50,12 +100,39 @@ public:
                                                   const std::string& end_month) const;
     MonthlyStats getCurrentMonthStats() const;
 
-    // Data limits and alerts
+    // Bytes moved in a window, answered from prefix-sum indexes over the
+    // day and hour totals in O(log n). Days are "YYYY-MM-DD", [from, to).
+    ByteTotals getUsage(const std::string& from_date, const std::string& to_date) const;
+    // Today and the days before it
+    ByteTotals getUsageLastDays(uint32_t days) const;
+    // The current hour and the hours before it; hours are known for
+    // history saved since hourly totals were added
+    ByteTotals getUsageLastHours(uint32_t hours) const;
+    // Billing cycle starting on start_day of each month (clamped to short
+    // months), through today
+    ByteTotals getBillingCycleUsage(unsigned start_day) const;
+
+    // Data limits and alerts; cheap enough to check every sample
     void setDataLimit(uint64_t monthly_limit_bytes);
     uint64_t getDataLimit() const;
     double getDataUsagePercentage() const;
     bool isDataLimitExceeded() const;
 
+    // Last speed test, written to its own file (by the writer thread, at
+    // once) so another process sharing the data directory (speed-meterd)
+    // sees it; the getter re-reads the file only when it has changed
+    void recordSpeedTest(const SpeedTestRecord& record);
+    bool getLastSpeedTest(SpeedTestRecord& record) const;
+
+    // Changes are queued for usage_journal.bin as they happen and written
+    // by a background thread every SPEED_METER_COMMIT_MS (default 10 s);
+    // no method here waits for the disk.
+    // saveData() queues a compaction: usage_data.txt rewritten in full and
+    // the journal emptied. That happens on destruction, which waits for
+    // the writer, and once the journal holds kCompactAfterRecords records.
+    static constexpr size_t kCompactAfterRecords = 4096;
+    PersistenceStats getPersistenceStats() const;
+
     // Utility functions
     void saveData();
     void loadData();
@@ -63,14 +140,66 @@ public:
     void exportData(const std::string& filename) const;
 
 private:
+    // One day of history without its date, implied by its position, or
+    // its rate digest, kept apart because most of it is empty
+    struct DayTotals {
+        uint64_t download_bytes;
+        uint64_t upload_bytes;
+        double peak_download_speed;
+        double peak_upload_speed;
+        uint64_t session_count;
+        int64_t session_seconds;
+        uint64_t download_packets;
+        uint64_t upload_packets;
+        uint64_t download_dropped;
+        uint64_t upload_dropped;
+        uint64_t download_errors;
+        uint64_t upload_errors;
+        double peak_download_packet_rate;
+        double peak_upload_packet_rate;
+        bool stored;  // the day has history (a gap otherwise)
+    };
+    // Days further apart than this are not stored (a corrupt date)
+    static constexpr int32_t kMaxSpanDays = 100 * 366;
+    static constexpr size_t kHoursPerDay = 24;
+
     std::string data_file_path;
-    std::map<std::string, DailyStats> daily_stats;
+    // History is dense from first_day: days[i] is day first_day + i
+    int32_t first_day;
+    std::vector<DayTotals> days;
+    std::vector<std::unique_ptr<RateDigest>> day_rates;  // parallel to days; null while empty
+    UsageIndex day_index;   // bytes per day, slot i is days[i]
+    UsageIndex hour_index;  // bytes per local hour, slot 24 * i + hour
+    mutable calendar::LocalToday today;
     uint64_t monthly_data_limit;
+    std::string speed_test_file_path;
+    mutable SpeedTestRecord last_speed_test;
+    mutable bool has_speed_test;
+    mutable int64_t speed_test_mtime;
+    std::string journal_file_path;
+    std::vector<usage_journal::Record> pending_records;  // rate records awaiting the next commit
+    UsageWriter writer;  // last, so it stops before the rest is destroyed
 
-    std::string getCurrentDate() const;
-    std::string getCurrentMonth() const;
+    // Slot of day, growing the history to reach it; nullptr beyond kMaxSpanDays
+    DayTotals* dayAt(int32_t day);
+    RateDigest* ratesAt(int32_t day);
+    void clearDay(int32_t day);
+    // Index sums over days [from, to) and hours [from, to) of day numbers
+    ByteTotals usageDays(int32_t from, int32_t to) const;
+    ByteTotals usageHours(int64_t from, int64_t to) const;
+    DailyStats dailyStats(size_t index) const;
+    // Stored days in [first, end) summed; month named after first
+    MonthlyStats monthStats(int32_t first, int32_t end) const;
+    std::vector<DailyStats> storedDays() const;
     std::string expandPath(const std::string& path) const;
     void ensureDataDirectory();
+    // Apply one journal record to the history (replay and live updates)
+    void apply(const usage_journal::Record& record);
+    void appendRates(int32_t day, const RateHistogram& histogram, bool upload);
+    // Open the journal and replay it onto the loaded snapshot
+    void openJournal(uint64_t generation);
+    // Queue pending_records, then compact if the journal has grown enough
+    void commit();
     void calculateMonthlyStats();
 };
 
@@ -6,4 +6,10 @@
 std::string formatSpeed(double speed);
 std::string formatDataUsage(long long bytes);
 
+// Write value with a fixed number of decimals (0-6) into [first, last),
+// std::to_chars style: returns one past the last character written, or
+// nullptr if the buffer is too small. Nothing is NUL-terminated and
+// nothing is allocated.
+char* formatFixed(char* first, char* last, double value, int precision);
+
 #endif // HELPERS_H
@@ -0,0 +1,99 @@
+#ifndef INTERFACE_TABLE_H
+#define INTERFACE_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "proc_net_dev_reader.h"
+
+// Rate summary for one interface (or the sum over all of them)
+struct InterfaceRate {
+    std::string name;
+    double rx_rate;  // bytes per second
+    double tx_rate;  // bytes per second
+};
+
+// Counters and rates for every interface on the host, stored as a
+// structure of arrays indexed by a stable slot ID. A slot keeps its ID for
+// as long as the interface exists; slots of vanished interfaces are reused
+// for new ones. One update is a single pass over the /proc/net/dev rows
+// followed by one flat rate loop per counter, so the per-tick cost stays
+// linear in the number of interfaces even with thousands of veth devices.
+class InterfaceTable {
+public:
+    enum Counter {
+        RxBytes,
+        TxBytes,
+        RxPackets,
+        TxPackets,
+        RxDrop,
+        TxDrop,
+        kCounterCount
+    };
+
+    static constexpr uint32_t kNoSlot = 0xffffffffu;
+
+    InterfaceTable();
+
+    // Ingest the rows of the reader's last refresh() and recompute rates
+    void update(const ProcNetDevReader& reader, double elapsedSeconds);
+
+    // Row-level form of update(), for sources other than /proc/net/dev.
+    // fields uses the /proc/net/dev column order.
+    void beginUpdate();
+    uint32_t ingest(const char* name, size_t nameLen, const uint64_t* fields);
+    void endUpdate(double elapsedSeconds);
+
+    size_t slotCount() const { return names_.size(); }
+    size_t presentCount() const { return presentCount_; }
+    bool isPresent(uint32_t slot) const { return present_[slot] != 0; }
+    const std::string& name(uint32_t slot) const { return names_[slot]; }
+    uint32_t findSlot(const char* name, size_t nameLen) const;
+
+    uint64_t value(Counter counter, uint32_t slot) const { return current_[counter][slot]; }
+    double rate(Counter counter, uint32_t slot) const { return rate_[counter][slot]; }
+
+    // Contiguous per-counter arrays, indexed by slot
+    const uint64_t* values(Counter counter) const { return current_[counter].data(); }
+    const double* rates(Counter counter) const { return rate_[counter].data(); }
+
+    // Sum of byte rates over present interfaces, loopback excluded
+    InterfaceRate total() const;
+
+    // Up to n present interfaces with the highest rx+tx rate, busiest first
+    void topN(size_t n, std::vector<uint32_t>& slots) const;
+
+private:
+    uint32_t lookup(const char* name, size_t nameLen, uint32_t hash) const;
+    uint32_t assignSlot(const char* name, size_t nameLen, uint32_t hash);
+    void indexSlot(uint32_t slot, uint32_t hash);
+    void insertIndex(uint32_t slot, uint32_t hash);
+    void eraseIndex(uint32_t slot);
+    void rebuildIndex(size_t capacity);
+    void computeRates(double elapsedSeconds);
+
+    std::vector<std::string> names_;
+    std::vector<uint32_t> hashes_;
+    std::vector<uint8_t> present_;
+    std::vector<uint8_t> seen_;
+    std::vector<double> valid_;   // 1.0 when the slot has a baseline sample
+    std::vector<uint64_t> current_[kCounterCount];
+    std::vector<uint64_t> previous_[kCounterCount];
+    std::vector<double> rate_[kCounterCount];
+
+    // Open-addressing name index: slot + 1, 0 = empty, kTombstone = erased
+    std::vector<uint32_t> buckets_;
+    size_t tombstones_;
+
+    // Slot seen at each row position last time; rows rarely move, so this
+    // usually resolves a row without hashing
+    std::vector<uint32_t> rowOrder_;
+    size_t row_;
+
+    std::vector<uint32_t> freeSlots_;
+    size_t presentCount_;
+    uint32_t loopbackSlot_;
+};
+
+#endif // INTERFACE_TABLE_H
@@ -0,0 +1,49 @@
+#ifndef LABEL_RENDERER_H
+#define LABEL_RENDERER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "metrics_snapshot.h"
+#include "interface_table.h"
+
+// Tray label and tooltip text rendered from a MetricsSnapshot on the
+// consumer's thread. Text lives in fixed buffers and is rebuilt only when
+// a value changes at the precision it is displayed with, so an idle or
+// steady link costs a few integer compares per refresh.
+class LabelRenderer {
+public:
+    static constexpr size_t kLabelSize = 64;
+    static constexpr size_t kTooltipSize = 1024;
+
+    LabelRenderer();
+
+    // Re-render if the displayed label would change; true when it did
+    bool updateLabel(const MetricsSnapshot& snapshot);
+
+    // Same for the tooltip. total/top are the all-interface lines; pass
+    // nullptr/empty when that mode is off.
+    bool updateTooltip(const MetricsSnapshot& snapshot, const InterfaceRate* total,
+                       const std::vector<InterfaceRate>& top);
+
+    const char* label() const { return label_; }
+    const char* tooltip() const { return tooltip_; }
+
+    // "12.3 Kb/s" / "4.56 Mb/s" for a rate in bytes/s; returns the end
+    // pointer like formatFixed(), or nullptr if it does not fit
+    static char* formatSpeed(char* first, char* last, double bytesPerSecond);
+
+    // Displayed-precision key of formatSpeed(): equal keys, equal text
+    static int64_t speedKey(double bytesPerSecond);
+
+private:
+    char label_[kLabelSize];
+    char tooltip_[kTooltipSize];
+    int64_t labelKeys_[2];
+    int64_t tooltipKeys_[4]; // MB down, MB up, packets dropped in, out
+    char tooltipIface_[sizeof(MetricsSnapshot::iface)];
+    bool hasLabel_;
+    bool hasTooltip_;
+};
+
+#endif // LABEL_RENDERER_H
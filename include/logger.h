@@ -0,0 +1,119 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Asynchronous logger. A call site copies its message pointer and a few
+// typed fields into the calling thread's lock-free ring and returns; a
+// background thread formats the records and writes them in batches to
+// stderr or SPEED_METER_LOG_FILE.
+//
+// Levels below SPEED_METER_LOG_LEVEL (0 = trace ... 4 = error) are removed
+// at compile time, arguments included. Above that, the runtime threshold is
+// Info, or Debug when SPEED_METER_DEBUG=1.
+//
+//   LOG_INFO("Default route moved", logging::field("from", old), logging::field("to", iface));
+//
+// The message must be a string literal: only its pointer is stored.
+
+#ifndef SPEED_METER_LOG_LEVEL
+#define SPEED_METER_LOG_LEVEL 1
+#endif
+
+namespace logging {
+
+enum class Level : uint8_t { Trace = 0, Debug = 1, Info = 2, Warn = 3, Error = 4 };
+
+// One key=value pair, copied by value into the ring
+struct Field {
+    static constexpr size_t kTextSize = 40;
+    enum Type : uint8_t { Int, Uint, Double, Text };
+
+    const char* key; // string literal
+    Type type;
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+    };
+    char text[kTextSize]; // truncated copy for Text fields
+};
+
+inline Field field(const char* key, long long value) {
+    Field f; f.key = key; f.type = Field::Int; f.i = value; return f;
+}
+inline Field field(const char* key, unsigned long long value) {
+    Field f; f.key = key; f.type = Field::Uint; f.u = value; return f;
+}
+inline Field field(const char* key, int value) { return field(key, static_cast<long long>(value)); }
+inline Field field(const char* key, long value) { return field(key, static_cast<long long>(value)); }
+inline Field field(const char* key, unsigned value) { return field(key, static_cast<unsigned long long>(value)); }
+inline Field field(const char* key, unsigned long value) { return field(key, static_cast<unsigned long long>(value)); }
+inline Field field(const char* key, double value) {
+    Field f; f.key = key; f.type = Field::Double; f.d = value; return f;
+}
+inline Field field(const char* key, const char* value) {
+    Field f;
+    f.key = key;
+    f.type = Field::Text;
+    f.u = 0;
+    std::strncpy(f.text, value ? value : "", Field::kTextSize - 1);
+    f.text[Field::kTextSize - 1] = '\0';
+    return f;
+}
+inline Field field(const char* key, const std::string& value) { return field(key, value.c_str()); }
+
+// Start the flusher thread. Without it records are written synchronously.
+void start();
+// Drain everything that was logged and stop the flusher
+void stop();
+
+void setLevel(Level level);
+bool enabled(Level level);
+
+// Records dropped because a thread's ring was full
+uint64_t droppedCount();
+
+void write(Level level, const char* message, const Field* fields, size_t count);
+
+inline void log(Level level, const char* message) {
+    write(level, message, nullptr, 0);
+}
+
+template <typename... Fields>
+void log(Level level, const char* message, const Fields&... fields) {
+    const Field array[] = {fields...};
+    write(level, message, array, sizeof...(fields));
+}
+
+} // namespace logging
+
+#define SPEED_METER_LOG_AT(level, ...) \
+    do { if (::logging::enabled(level)) ::logging::log(level, __VA_ARGS__); } while (0)
+
+#if SPEED_METER_LOG_LEVEL <= 0
+#define LOG_TRACE(...) SPEED_METER_LOG_AT(::logging::Level::Trace, __VA_ARGS__)
+#else
+#define LOG_TRACE(...) do {} while (0)
+#endif
+#if SPEED_METER_LOG_LEVEL <= 1
+#define LOG_DEBUG(...) SPEED_METER_LOG_AT(::logging::Level::Debug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do {} while (0)
+#endif
+#if SPEED_METER_LOG_LEVEL <= 2
+#define LOG_INFO(...) SPEED_METER_LOG_AT(::logging::Level::Info, __VA_ARGS__)
+#else
+#define LOG_INFO(...) do {} while (0)
+#endif
+#if SPEED_METER_LOG_LEVEL <= 3
+#define LOG_WARN(...) SPEED_METER_LOG_AT(::logging::Level::Warn, __VA_ARGS__)
+#else
+#define LOG_WARN(...) do {} while (0)
+#endif
+#define LOG_ERROR(...) SPEED_METER_LOG_AT(::logging::Level::Error, __VA_ARGS__)
+
+#endif // LOGGER_H
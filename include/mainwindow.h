@@ -60,6 +60,7 @@ private:
 
     // Update methods
     void updateSessionInfo();
+    void updateInterfaceTable();
     void updateDetailedStats();
     void updateCharts();
 
@@ -102,6 +103,7 @@ private:
     // Overview tab
     QLabel* downloadLabel_;
     QLabel* uploadLabel_;
+    QLabel* packetsLabel_;
     QProgressBar* downloadProgressBar_;
     QProgressBar* uploadProgressBar_;
     QLabel* sessionTimeLabel_;
@@ -111,6 +113,8 @@ private:
     QLabel* ipLabel_;
     QLabel* statusLabel_;
     QLabel* statusIndicator_;
+    QLabel* samplingLabel_;
+    QLabel* allInterfacesLabel_;
 
     // Statistics tab
     QLabel* peakDownloadLabel_;
@@ -124,6 +128,7 @@ private:
     QChart* speedChart_;
     QLineSeries* downloadSeries_;
     QLineSeries* uploadSeries_;
+    qint64 lastChartPointMs_;
     QLabel* dataUsageLabel_;
     QProgressBar* dataUsageProgress_;
     QLabel* dataLimitStatusLabel_;
@@ -0,0 +1,52 @@
+#ifndef METER_CLIENT_H
+#define METER_CLIENT_H
+
+#include <string>
+#include <vector>
+#include "meter_protocol.h"
+
+// Blocking client for the speed-meterd socket. Requests are answered in
+// order; after subscribe() the stream of Sample frames is read with
+// nextSample(), and requests are best not mixed into it.
+class MeterClient {
+public:
+    MeterClient();
+    ~MeterClient();
+    MeterClient(const MeterClient&) = delete;
+    MeterClient& operator=(const MeterClient&) = delete;
+
+    bool connect(const std::string& path = meter_protocol::defaultSocketPath());
+    void close();
+    bool isConnected() const { return fd_ >= 0; }
+    int fd() const { return fd_; }
+    // Reason of the last failure, for messages to the user
+    const std::string& error() const { return error_; }
+
+    bool snapshot(MetricsSnapshot& out);
+    bool days(const std::string& first, const std::string& last,
+              std::vector<meter_protocol::HistoryRow>& out);
+    bool months(const std::string& first, const std::string& last,
+                std::vector<meter_protocol::HistoryRow>& out);
+
+    bool subscribe(uint32_t every = 1);
+    bool unsubscribe();
+    // Next pushed sample; false on timeout (timeoutMs >= 0) or error
+    bool nextSample(MetricsSnapshot& out, int timeoutMs = -1);
+
+private:
+    bool send(meter_protocol::MessageType type, const void* payload, uint32_t length);
+    // Read one frame; false on timeout, disconnect or protocol error
+    bool receive(meter_protocol::FrameHeader& header, std::string& payload, int timeoutMs);
+    bool request(meter_protocol::MessageType type, const void* payload, uint32_t length,
+                 meter_protocol::MessageType expected, std::string& reply);
+    bool history(meter_protocol::MessageType type, meter_protocol::MessageType expected,
+                 const std::string& first, const std::string& last,
+                 std::vector<meter_protocol::HistoryRow>& out);
+    bool fail(const std::string& reason);
+
+    int fd_;
+    std::string buffer_;  // bytes received but not yet consumed
+    std::string error_;
+};
+
+#endif // METER_CLIENT_H
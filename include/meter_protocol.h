@@ -0,0 +1,119 @@
+#ifndef METER_PROTOCOL_H
+#define METER_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include "metrics_snapshot.h"
+
+// Wire format of the speed-meterd Unix socket. Every message is a frame:
+// a FrameHeader followed by `length` payload bytes. Payloads are the
+// fixed-size structs below in host byte order; the socket never leaves
+// the machine, so there is nothing to swap. A peer that sees a different
+// version closes the connection.
+namespace meter_protocol {
+
+constexpr uint16_t kVersion = 1;
+constexpr uint32_t kMaxPayload = 64 * 1024;
+constexpr size_t kMaxHistoryRows = 400; // one reply never exceeds kMaxPayload
+
+enum class MessageType : uint16_t {
+    // Client to daemon
+    GetSnapshot = 1,   // no payload; answered with Snapshot
+    Subscribe = 2,     // SubscribeRequest; Sample frames follow
+    Unsubscribe = 3,   // no payload, no answer
+    GetDays = 4,       // HistoryRequest of YYYY-MM-DD dates; answered with Days
+    GetMonths = 5,     // HistoryRequest of YYYY-MM months; answered with Months
+
+    // Daemon to client
+    Snapshot = 0x81,   // MetricsSnapshot
+    Sample = 0x82,     // MetricsSnapshot, pushed to subscribers; a gap in
+                       // seq means the client fell behind and lost samples
+    Days = 0x83,       // HistoryRow[] in date order
+    Months = 0x84,     // HistoryRow[] in month order
+    Error = 0xff       // ErrorReply
+};
+
+struct FrameHeader {
+    uint32_t length;   // payload bytes after the header
+    uint16_t type;     // MessageType
+    uint16_t version;  // kVersion
+};
+
+struct SubscribeRequest {
+    uint32_t every;    // push every Nth sample; 0 or 1 for all of them
+};
+
+// Inclusive range, NUL-padded; an empty `last` means up to today
+struct HistoryRequest {
+    char first[12];
+    char last[12];
+};
+
+// One day or one month of DataManager history
+struct HistoryRow {
+    char period[12];              // YYYY-MM-DD or YYYY-MM, NUL-padded
+    uint32_t active_days;         // 1 for a day row
+    uint64_t download_bytes;
+    uint64_t upload_bytes;
+    uint64_t download_packets;
+    uint64_t upload_packets;
+    uint64_t download_dropped;
+    uint64_t upload_dropped;
+    double peak_download;         // bytes/s
+    double peak_upload;
+    double download_percentiles[3];  // p50, p95, p99 in bytes/s
+    double upload_percentiles[3];
+};
+
+enum class ErrorCode : uint32_t {
+    BadRequest = 1,   // unknown type or malformed payload
+    Unavailable = 2   // the daemon cannot answer right now
+};
+
+struct ErrorReply {
+    uint32_t code;    // ErrorCode
+    char message[60]; // NUL-terminated
+};
+
+static_assert(std::is_trivially_copyable<MetricsSnapshot>::value, "snapshot goes on the wire as is");
+static_assert(sizeof(HistoryRow) * kMaxHistoryRows <= kMaxPayload, "history reply too large");
+
+// Append one frame to out
+inline void appendFrame(std::string& out, MessageType type, const void* payload, uint32_t length) {
+    FrameHeader header;
+    header.length = length;
+    header.type = static_cast<uint16_t>(type);
+    header.version = kVersion;
+    out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (length > 0) {
+        out.append(static_cast<const char*>(payload), length);
+    }
+}
+
+// Header of the frame at the start of [data, data + size). Returns false
+// while the header is incomplete; check version and length before use.
+inline bool peekFrame(const char* data, size_t size, FrameHeader& header) {
+    if (size < sizeof(FrameHeader)) {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    return true;
+}
+
+// Copy a string into a fixed NUL-padded field, truncating if needed
+template <size_t N>
+inline void copyField(char (&field)[N], const std::string& value) {
+    std::memset(field, 0, N);
+    value.copy(field, N - 1);
+}
+
+// Path of the daemon socket: SPEED_METER_SOCKET, else
+// $XDG_RUNTIME_DIR/speed-meterd.sock, else /tmp/speed-meterd-<uid>.sock
+std::string defaultSocketPath();
+
+} // namespace meter_protocol
+
+#endif // METER_PROTOCOL_H
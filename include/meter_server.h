@@ -0,0 +1,92 @@
+#ifndef METER_SERVER_H
+#define METER_SERVER_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "meter_protocol.h"
+#include "metrics_exposition.h"
+
+class SpeedMeter;
+class DataManager;
+
+// speed-meterd's event loop: one epoll set holding the listening socket,
+// every client, SpeedMeter's sample eventfd, a one-minute save timer and
+// a stop eventfd, plus an optional TCP listener serving Prometheus
+// /metrics over plain HTTP. Each client has a bounded outgoing queue; a subscriber
+// whose queue is full loses samples (visible to it as a seq gap) instead
+// of holding up the loop, and the sampler thread never waits on clients.
+class MeterServer {
+public:
+    MeterServer(SpeedMeter& meter, DataManager& data);
+    ~MeterServer();
+    MeterServer(const MeterServer&) = delete;
+    MeterServer& operator=(const MeterServer&) = delete;
+
+    // Bind and listen on path (mode 0600). Refuses to take over the socket
+    // of a daemon that still answers; a stale socket file is replaced.
+    bool open(const std::string& path);
+    // Also serve GET /metrics on "[ADDRESS:]PORT" (IPv4, default address
+    // 127.0.0.1); call before run()
+    bool openMetrics(const std::string& address);
+    // Serve until stop(); false if the loop could not be set up
+    bool run();
+    // Ask run() to return; async-signal-safe
+    void stop();
+
+    // Queued bytes above which a subscriber starts losing samples and a
+    // reply closes the connection
+    static constexpr size_t kMaxQueuedBytes = 256 * 1024;
+
+private:
+    struct Client {
+        int fd;
+        std::string in;        // bytes of an incomplete request
+        std::string out;       // queued frames; out[0, sent) already written
+        size_t sent;
+        bool waitingWritable;  // EPOLLOUT armed
+        bool http;             // metrics scraper, not a protocol client
+        bool closeAfterFlush;  // HTTP response without keep-alive
+        bool subscribed;
+        uint32_t every;        // push every Nth sample
+        uint64_t seen;         // samples since subscribing
+        uint64_t dropped;      // samples lost to a full queue
+    };
+
+    void accept(int listenFd, bool http);
+    void readFrom(Client& client);
+    void serveHttp(Client& client);
+    bool handleFrame(Client& client, const meter_protocol::FrameHeader& header, const char* payload);
+    void publishSample();
+    void saveUsage();
+    void refreshUsage();
+    // false when the client had to be closed
+    bool enqueue(Client& client, const std::string& frame, bool droppable);
+    bool flush(Client& client);
+    void setWritable(Client& client, bool wanted);
+    // Update the client's epoll interest: EPOLLIN unless it is closing,
+    // EPOLLOUT while a write is pending
+    void watch(Client& client);
+    void closeClient(int fd);
+    void sendError(Client& client, meter_protocol::ErrorCode code, const char* message);
+    void history(Client& client, bool months, const meter_protocol::HistoryRequest& query);
+
+    SpeedMeter& meter_;
+    DataManager& data_;
+    std::string path_;
+    int listenFd_;
+    int epollFd_;
+    int stopFd_;
+    int saveTimerFd_;
+    std::unordered_map<int, Client> clients_;
+    std::string sampleFrame_;  // scratch, reused for every sample
+    int metricsFd_;
+    MetricsExposition exposition_;
+    UsageTotals usage_;         // DataManager figures as of the last save
+    uint64_t usageGeneration_;  // bumped whenever usage_ changes
+
+    int64_t lastSaveNs_;
+    MetricsSnapshot saved_;  // totals at the previous save
+};
+
+#endif // METER_SERVER_H
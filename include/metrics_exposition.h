@@ -0,0 +1,47 @@
+#ifndef METRICS_EXPOSITION_H
+#define METRICS_EXPOSITION_H
+
+#include <cstdint>
+#include <string>
+#include "data_manager.h"
+#include "metrics_snapshot.h"
+
+// Usage figures that come from DataManager rather than the sampler,
+// refreshed by the owner when it saves
+struct UsageTotals {
+    uint64_t today_download_bytes;
+    uint64_t today_upload_bytes;
+    uint64_t month_download_bytes;
+    uint64_t month_upload_bytes;
+    uint64_t data_limit_bytes;   // 0: no monthly limit set
+    bool has_speed_test;
+    SpeedTestRecord speed_test;
+    PersistenceStats persistence;  // DataManager's writer thread
+};
+
+// Prometheus text exposition (format 0.0.4) of one snapshot and the usage
+// totals, kept as a complete HTTP/1.1 response. It is rendered again only
+// when the snapshot seq or the usage generation changes, so any number of
+// scrapes between two samples each cost a single write of the same bytes.
+class MetricsExposition {
+public:
+    MetricsExposition();
+
+    // Response for this snapshot; the reference stays valid until the next call
+    const std::string& response(const MetricsSnapshot& snapshot, const UsageTotals& usage,
+                                uint64_t usageGeneration, bool keepAlive);
+    uint64_t renders() const { return renders_; }
+
+private:
+    void render(const MetricsSnapshot& snapshot, const UsageTotals& usage);
+
+    std::string body_;
+    std::string response_;  // headers + body_, for keep-alive
+    std::string closing_;   // the same with "Connection: close"
+    uint64_t seq_;
+    uint64_t generation_;
+    bool valid_;
+    uint64_t renders_;
+};
+
+#endif // METRICS_EXPOSITION_H
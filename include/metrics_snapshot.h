@@ -0,0 +1,40 @@
+#ifndef METRICS_SNAPSHOT_H
+#define METRICS_SNAPSHOT_H
+
+#include <cstdint>
+
+// Everything the UI reads from the sampler after one sample, published as
+// a single value through a Seqlock so the fields always belong together
+struct MetricsSnapshot {
+    uint64_t seq;               // samples published so far; 0 before the first
+    int64_t sample_ns;          // CLOCK_MONOTONIC of the counter read
+    uint64_t total_rx_bytes;    // bytes received since the meter started
+    uint64_t total_tx_bytes;    // bytes sent since the meter started
+    double instant_rx_rate;     // bytes/s over the last interval
+    double instant_tx_rate;
+    double rx_rate;             // smoothed bytes/s
+    double tx_rate;
+    uint64_t total_rx_packets;  // packets since the meter started
+    uint64_t total_tx_packets;
+    uint64_t total_rx_dropped;  // drops since the meter started
+    uint64_t total_tx_dropped;
+    uint64_t total_rx_errors;   // errors since the meter started
+    uint64_t total_tx_errors;
+    double rx_packet_rate;      // smoothed packets/s, same filter as the byte rates
+    double tx_packet_rate;
+    double rx_drop_rate;        // drops/s over the last interval
+    double tx_drop_rate;
+    double rx_error_rate;       // errors/s over the last interval
+    double tx_error_rate;
+    int32_t sample_period_ms;   // period in effect after this sample
+    bool sampling_idle;         // period is backed off on a quiet link
+    char iface[16];             // monitored interface (IFNAMSIZ), NUL-terminated
+};
+
+// Mean packet size in bytes for a byte rate and a packet rate taken over
+// the same interval; 0 when no packets moved
+inline double averagePacketSize(double byteRate, double packetRate) {
+    return packetRate > 0.0 ? byteRate / packetRate : 0.0;
+}
+
+#endif // METRICS_SNAPSHOT_H
@@ -0,0 +1,53 @@
+#ifndef NET_STATS_H
+#define NET_STATS_H
+
+#include <cstdint>
+
+// Raw interface counters as reported by the kernel. Error columns follow
+// /proc/net/dev, which folds several rtnl_link_stats fields into each.
+struct NetStats {
+    uint64_t rx_bytes;
+    uint64_t tx_bytes;
+    uint64_t rx_packets;
+    uint64_t tx_packets;
+    uint64_t rx_errors;
+    uint64_t tx_errors;
+    uint64_t rx_dropped;     // includes rx_missed_errors
+    uint64_t tx_dropped;
+    uint64_t rx_fifo;
+    uint64_t tx_fifo;
+    uint64_t rx_frame;       // length, over, CRC and frame errors
+    uint64_t tx_collisions;
+    uint64_t tx_carrier;     // carrier, aborted, window and heartbeat errors
+    uint64_t rx_compressed;
+    uint64_t tx_compressed;
+    uint64_t rx_multicast;
+};
+
+// Fill stats from one /proc/net/dev row (8 RX columns, then 8 TX columns)
+inline void netStatsFromProcFields(const uint64_t* fields, NetStats& stats) {
+    stats.rx_bytes = fields[0];
+    stats.rx_packets = fields[1];
+    stats.rx_errors = fields[2];
+    stats.rx_dropped = fields[3];
+    stats.rx_fifo = fields[4];
+    stats.rx_frame = fields[5];
+    stats.rx_compressed = fields[6];
+    stats.rx_multicast = fields[7];
+    stats.tx_bytes = fields[8];
+    stats.tx_packets = fields[9];
+    stats.tx_errors = fields[10];
+    stats.tx_dropped = fields[11];
+    stats.tx_fifo = fields[12];
+    stats.tx_collisions = fields[13];
+    stats.tx_carrier = fields[14];
+    stats.tx_compressed = fields[15];
+}
+
+// Counter change between two reads; a counter that went backwards (driver
+// reset, interface re-created) counts as no change
+inline uint64_t netCounterDelta(uint64_t current, uint64_t last) {
+    return current >= last ? current - last : 0;
+}
+
+#endif // NET_STATS_H
@@ -0,0 +1,37 @@
+#ifndef NETLINK_STATS_H
+#define NETLINK_STATS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "counter_backend.h"
+
+// Reads interface counters over rtnetlink. Each read() sends one
+// RTM_GETLINK request for the selected ifindex and decodes the binary
+// rtnl_link_stats64 block (IFLA_STATS64) from the reply, so there is no
+// text parsing and the counters are exact 64-bit values.
+class NetlinkStatsBackend : public CounterBackend {
+public:
+    NetlinkStatsBackend();
+    ~NetlinkStatsBackend() override;
+
+    NetlinkStatsBackend(const NetlinkStatsBackend&) = delete;
+    NetlinkStatsBackend& operator=(const NetlinkStatsBackend&) = delete;
+
+    bool isOpen() const { return fd_ >= 0; }
+
+    const char* name() const override { return "netlink"; }
+    bool setInterface(const std::string& iface) override;
+    bool read(NetStats& stats) override;
+
+    // Query an interface by index without changing the selected one
+    bool readIndex(int ifindex, NetStats& stats);
+
+private:
+    int fd_;
+    int ifindex_;
+    uint32_t seq_;
+    std::vector<char> buf_;
+};
+
+#endif // NETLINK_STATS_H
@@ -0,0 +1,103 @@
+#ifndef NIC_LOAD_H
+#define NIC_LOAD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Network softirq and NIC interrupt rates on one CPU, events per second
+struct CpuNetLoad {
+    int cpu;
+    double net_rx;   // NET_RX softirqs
+    double net_tx;   // NET_TX softirqs
+    double nic_irqs; // hardware interrupts from the active NIC's vectors
+};
+
+// One hardware queue of the active NIC
+struct NicQueueLoad {
+    char name[16]; // "rx-0", "tx-3"
+    double bytes_per_sec;
+};
+
+struct NicLoad {
+    std::vector<CpuNetLoad> cpus;
+    std::vector<NicQueueLoad> queues;
+    int nic_irq_lines;        // interrupt vectors attributed to the NIC
+    bool queue_bytes_known;   // the driver reports per-queue byte counters
+};
+
+// Samples /proc/softirqs, the active NIC's interrupt counts and its
+// per-queue byte counters. Files stay open and are re-read with pread()
+// into buffers kept across calls; queue counters come from one
+// ETHTOOL_GSTATS ioctl into a preallocated array. The NIC's vectors are
+// found once in /proc/interrupts, then read per tick from
+// /sys/kernel/irq/<n>/per_cpu_count, because rendering the whole
+// /proc/interrupts table costs more than the main sampler's own read.
+// The sysfs queue directories only carry queue settings, so per-queue
+// byte counters are the driver's ethtool statistics ("rx_queue_0_bytes",
+// "rx0_bytes", "rx-0.bytes", ...); drivers without them report no queue
+// rates.
+// Linux only; elsewhere isOpen() is false.
+class NicLoadSampler {
+public:
+    NicLoadSampler();
+    ~NicLoadSampler();
+
+    NicLoadSampler(const NicLoadSampler&) = delete;
+    NicLoadSampler& operator=(const NicLoadSampler&) = delete;
+
+    bool isOpen() const { return softirqs_.fd >= 0; }
+
+    // Find the interface's IRQ lines and queue counters; the next sample()
+    // only sets a baseline
+    void setInterface(const std::string& iface);
+
+    // Read every counter and turn the change since the last call into rates
+    bool sample(double elapsedSeconds);
+
+    const NicLoad& load() const { return load_; }
+
+private:
+    struct ProcFile {
+        int fd = -1;
+        std::vector<char> buf;
+        size_t len = 0;
+        bool open(const char* path, size_t initialSize);
+        bool read();
+        void close();
+    };
+
+    // Counter columns of one file, indexed by CPU id
+    struct CpuCounters {
+        std::vector<uint64_t> net_rx;
+        std::vector<uint64_t> net_tx;
+        std::vector<uint64_t> irqs;
+    };
+
+    bool readSoftirqs(CpuCounters& counters);
+    bool readInterrupts(CpuCounters& counters);
+    bool readQueueBytes(std::vector<uint64_t>& bytes);
+    void findIrqs(const std::string& iface);
+    void findQueueStats(const std::string& iface);
+
+    ProcFile softirqs_;
+    ProcFile interrupts_;
+    std::vector<int> columnCpu_; // CPU id per column, reused by both parsers
+    std::vector<unsigned> irqs_; // sorted IRQ numbers of the NIC
+    std::vector<ProcFile> irqFiles_; // per_cpu_count of each; empty means parse /proc/interrupts
+
+    int ethtoolFd_;
+    char iface_[16];
+    std::vector<uint64_t> statsBuf_; // struct ethtool_stats + counters
+    std::vector<std::pair<uint32_t, uint32_t>> queueStats_; // (stat index, queue slot)
+
+    CpuCounters last_;
+    CpuCounters current_;
+    std::vector<uint64_t> lastQueueBytes_;
+    std::vector<uint64_t> queueBytes_;
+    bool haveBaseline_;
+    NicLoad load_;
+};
+
+#endif // NIC_LOAD_H
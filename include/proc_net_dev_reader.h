@@ -0,0 +1,66 @@
+#ifndef PROC_NET_DEV_READER_H
+#define PROC_NET_DEV_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "net_stats.h"
+
+// Reader for /proc/net/dev that keeps the descriptor open between samples.
+// Every refresh() re-reads the file with pread() at offset 0 into a buffer
+// that is reused across calls, and rows are parsed in place, so the steady
+// state does no allocation and no per-line string handling.
+class ProcNetDevReader {
+public:
+    // Number of numeric columns per interface row (8 RX + 8 TX)
+    static constexpr int kFieldCount = 16;
+
+    explicit ProcNetDevReader(const char* path = "/proc/net/dev");
+    ~ProcNetDevReader();
+
+    ProcNetDevReader(const ProcNetDevReader&) = delete;
+    ProcNetDevReader& operator=(const ProcNetDevReader&) = delete;
+
+    bool isOpen() const { return fd_ >= 0; }
+
+    // Re-read the file into the internal buffer
+    bool refresh();
+
+    // Look up an interface in the last refreshed contents. The name has to
+    // match exactly, so "eth0" never matches a "veth0" row.
+    bool find(const char* iface, size_t ifaceLen, NetStats& stats) const;
+
+    // refresh() followed by find()
+    bool read(const std::string& iface, NetStats& stats);
+
+    // Call fn(name, nameLen, fields) for every interface row in the buffer
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        const char* p = buf_.data();
+        const char* end = p + len_;
+        const char* name;
+        size_t nameLen;
+        uint64_t fields[kFieldCount];
+        while (p < end) {
+            p = parseRow(p, end, &name, &nameLen, fields);
+            if (name) {
+                fn(name, nameLen, fields);
+            }
+        }
+    }
+
+    // Parse the line starting at p. On an interface row, name/nameLen point
+    // into the buffer and fields holds the counters; on any other line name
+    // is set to nullptr. Returns the start of the next line.
+    static const char* parseRow(const char* p, const char* end,
+                                const char** name, size_t* nameLen,
+                                uint64_t* fields);
+
+private:
+    int fd_;
+    std::vector<char> buf_;
+    size_t len_;
+};
+
+#endif // PROC_NET_DEV_READER_H
@@ -0,0 +1,105 @@
+#ifndef PROCESS_TRAFFIC_H
+#define PROCESS_TRAFFIC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "sock_diag.h"
+
+// Throughput attributed to one process over the last refresh
+struct ProcessRate {
+    int pid;
+    std::string name;
+    double rx_rate; // bytes/s
+    double tx_rate;
+};
+
+// Socket inode -> owning PID, built from the socket:[inode] links under
+// /proc/<pid>/fd and maintained incrementally: a lookup miss scans PIDs
+// that appeared since the last scan first, then re-lists the fd
+// directories of known PIDs and readlink()s only fds not seen before, or
+// whose socket has been forgotten since (fd numbers are reused).
+class SocketOwnerIndex {
+public:
+    // Try to place every inode in `inodes`; known ones cost nothing
+    void resolve(const std::vector<uint32_t>& inodes);
+
+    // Owning PID, or -1
+    int owner(uint32_t inode) const;
+    const std::string& processName(int pid) const;
+
+    // Drop an inode whose socket has gone away
+    void forget(uint32_t inode);
+
+    size_t processCount() const { return processes_.size(); }
+    // readlink() calls made by the last resolve(), for the benchmark
+    size_t lastLinksRead() const { return linksRead_; }
+
+private:
+    struct Process {
+        std::string name;
+        // (fd, socket inode or 0), sorted by fd; files and pipes
+        // are kept too so they are never readlink()ed again
+        std::vector<std::pair<int, uint32_t>> fds;
+        uint32_t scanGeneration;
+    };
+
+    // Re-list the fds of pid; relinkAll reads every link, not only new ones
+    void scanProcess(int pid, Process& process, bool relinkAll);
+    size_t listPids(std::vector<int>& pids) const;
+
+    std::unordered_map<int, Process> processes_;
+    std::unordered_map<uint32_t, int> owners_;
+    // Inodes no readable fd points at (other users' processes, kernel
+    // sockets); retried only every kMissRetry resolves
+    std::unordered_map<uint32_t, uint32_t> misses_;
+    std::vector<int> pids_;
+    std::vector<int> fdScratch_;
+    uint32_t generation_ = 0;
+    uint32_t lastRelink_ = 0;  // generation of the last full re-read
+    size_t linksRead_ = 0;
+};
+
+// Per-process TCP throughput: one sock_diag dump per refresh gives every
+// socket's bytes_acked / bytes_received; deltas are summed per owning PID.
+// UDP is not attributed because sock_diag carries no UDP byte counters.
+class ProcessTraffic {
+public:
+    ProcessTraffic();
+
+    bool isAvailable() const { return diag_.isOpen(); }
+
+    // Sample all sockets; elapsedSeconds is the time since the last call
+    bool refresh(double elapsedSeconds);
+
+    // Busiest processes by rx + tx, at most n
+    void top(size_t n, std::vector<ProcessRate>& out) const;
+
+    size_t socketCount() const { return sockets_.size(); }
+    const SocketOwnerIndex& index() const { return index_; }
+
+private:
+    struct SocketCounters {
+        uint64_t acked;
+        uint64_t received;
+        uint32_t generation;
+    };
+    struct Delta {
+        uint32_t inode;
+        uint64_t tx;
+        uint64_t rx;
+    };
+
+    SockDiag diag_;
+    SocketOwnerIndex index_;
+    std::unordered_map<uint32_t, SocketCounters> sockets_;
+    std::vector<Delta> deltas_;
+    std::vector<uint32_t> unknown_;
+    std::unordered_map<int, size_t> rowOfPid_;
+    std::vector<ProcessRate> rates_;
+    uint32_t generation_;
+};
+
+#endif // PROCESS_TRAFFIC_H
@@ -0,0 +1,209 @@
+#ifndef RATE_FILTER_H
+#define RATE_FILTER_H
+
+#include <cmath>
+#include <cstddef>
+
+// Smoothing stages for a stream of rate samples. Each stage takes one raw
+// value and the real time since the previous sample and returns its output;
+// the first value after reset() passes through unchanged. Stages are plain
+// structs chained at compile time by FilterChain, so a fixed pipeline
+// inlines to straight-line code. RateFilter below picks one of the common
+// pipelines at run time.
+namespace rate_filter {
+
+// Exponential moving average with a fixed weight per sample
+struct Ema {
+    double alpha = 0.6;
+    double value = 0.0;
+    bool primed = false;
+
+    double apply(double x, double) {
+        value = primed ? alpha * x + (1.0 - alpha) * value : x;
+        primed = true;
+        return value;
+    }
+    void reset() { primed = false; }
+};
+
+// EMA whose weight follows the real interval: alpha = 1 - exp(-dt / tau).
+// A late or backed-off sample moves the output further than a fast one.
+// The default tau gives alpha 0.6 at one-second samples.
+struct TimeConstantEma {
+    double tau = 1.0913566679372915; // seconds; -1 / ln(0.4)
+    double value = 0.0;
+    bool primed = false;
+
+    double apply(double x, double dt) {
+        if (!primed) {
+            value = x;
+            primed = true;
+        } else if (dt > 0.0) {
+            const double alpha = 1.0 - std::exp(-dt / tau);
+            value += alpha * (x - value);
+        }
+        return value;
+    }
+    void reset() { primed = false; }
+};
+
+// Mean of the last N samples
+template <size_t N>
+struct WindowMean {
+    static_assert(N > 0, "window must hold at least one sample");
+    double ring[N] = {};
+    double sum = 0.0;
+    size_t next = 0;
+    size_t filled = 0;
+
+    double apply(double x, double) {
+        if (filled == N) {
+            sum -= ring[next];
+        } else {
+            ++filled;
+        }
+        ring[next] = x;
+        sum += x;
+        next = next + 1 == N ? 0 : next + 1;
+        return sum / static_cast<double>(filled);
+    }
+    void reset() {
+        sum = 0.0;
+        next = 0;
+        filled = 0;
+    }
+};
+
+// Median of the last N samples; drops single-sample spikes entirely.
+// A sorted copy of the window is kept up to date, so each sample costs one
+// removal and one insertion of at most N shifts.
+template <size_t N>
+struct WindowMedian {
+    static_assert(N > 0, "window must hold at least one sample");
+    double ring[N] = {};
+    double sorted[N] = {};
+    size_t next = 0;
+    size_t filled = 0;
+
+    double apply(double x, double) {
+        size_t count = filled;
+        if (count == N) {
+            // Drop the value leaving the window from the sorted copy
+            const double old = ring[next];
+            size_t i = 0;
+            while (i + 1 < count && sorted[i] != old) ++i;
+            for (; i + 1 < count; ++i) sorted[i] = sorted[i + 1];
+            --count;
+        } else {
+            ++filled;
+        }
+        ring[next] = x;
+        next = next + 1 == N ? 0 : next + 1;
+
+        size_t j = count;
+        for (; j > 0 && sorted[j - 1] > x; --j) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = x;
+        return filled % 2 ? sorted[filled / 2] : 0.5 * (sorted[filled / 2 - 1] + sorted[filled / 2]);
+    }
+    void reset() {
+        next = 0;
+        filled = 0;
+    }
+};
+
+// One-dimensional Kalman filter for a rate that drifts as a random walk.
+// Noise is relative to a unit measurement variance, so only the ratio
+// matters and the filter works at any scale; the gain adapts to dt. The
+// default settles at a gain of 0.6 for one-second samples, like Ema.
+struct Kalman {
+    double processNoise = 0.9; // variance added per second, in measurement units
+    double value = 0.0;
+    double variance = 1.0;
+    bool primed = false;
+
+    double apply(double x, double dt) {
+        if (!primed) {
+            value = x;
+            variance = 1.0;
+            primed = true;
+            return value;
+        }
+        variance += processNoise * (dt > 0.0 ? dt : 1.0);
+        const double gain = variance / (variance + 1.0);
+        value += gain * (x - value);
+        variance *= 1.0 - gain;
+        return value;
+    }
+    void reset() { primed = false; }
+};
+
+// Stages applied left to right: FilterChain<WindowMedian<5>, Ema>
+template <typename... Stages>
+class FilterChain;
+
+template <>
+class FilterChain<> {
+public:
+    double apply(double x, double) { return x; }
+    void reset() {}
+};
+
+template <typename First, typename... Rest>
+class FilterChain<First, Rest...> {
+public:
+    double apply(double x, double dt) { return rest_.apply(first_.apply(x, dt), dt); }
+    void reset() {
+        first_.reset();
+        rest_.reset();
+    }
+    First& head() { return first_; }
+    FilterChain<Rest...>& tail() { return rest_; }
+
+private:
+    First first_;
+    FilterChain<Rest...> rest_;
+};
+
+} // namespace rate_filter
+
+enum class RateFilterKind {
+    Ema,              // alpha 0.6 per sample (default)
+    TimeConstantEma,  // alpha from the real interval
+    WindowMean,       // mean of the last 8 samples
+    Median,           // median of the last 5 samples
+    Kalman,           // 1-D Kalman filter
+    MedianEma,        // median of 5, then EMA: rejects spikes, then smooths
+    None              // raw rate
+};
+
+// Parses "ema", "ema-dt", "mean", "median", "kalman", "median-ema" or
+// "none"; anything else gives fallback
+RateFilterKind parseRateFilterKind(const char* value, RateFilterKind fallback);
+
+// Filter requested through SPEED_METER_FILTER, Ema by default
+RateFilterKind rateFilterFromEnvironment();
+
+// One rate stream smoothed by a pipeline chosen at run time. Each kind is
+// a compile-time FilterChain; a switch picks the one in use, so the
+// per-sample cost is one branch plus the inlined chain.
+class RateFilter {
+public:
+    explicit RateFilter(RateFilterKind kind = RateFilterKind::Ema) : kind_(kind) {}
+
+    RateFilterKind kind() const { return kind_; }
+    double update(double x, double dtSeconds);
+    void reset();
+
+private:
+    RateFilterKind kind_;
+    rate_filter::FilterChain<rate_filter::Ema> ema_;
+    rate_filter::FilterChain<rate_filter::TimeConstantEma> timeConstantEma_;
+    rate_filter::FilterChain<rate_filter::WindowMean<8>> mean_;
+    rate_filter::FilterChain<rate_filter::WindowMedian<5>> median_;
+    rate_filter::FilterChain<rate_filter::Kalman> kalman_;
+    rate_filter::FilterChain<rate_filter::WindowMedian<5>, rate_filter::Ema> medianEma_;
+};
+
+#endif // RATE_FILTER_H
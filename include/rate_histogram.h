@@ -0,0 +1,72 @@
+#ifndef RATE_HISTOGRAM_H
+#define RATE_HISTOGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Fixed-size log-linear histogram of rates in bytes/s, in the style of an
+// HDR histogram. Rates below 32 B/s get one bucket each; above that every
+// power of two is split into 16 equal buckets, so a percentile read back
+// from the bucket midpoint is within about 3% of the recorded rate. The
+// range tops out at 2^40 B/s (1 TB/s) in 592 buckets, 2.3 KB of counts.
+// Two histograms merge by adding counts, so daily histograms combine into a
+// monthly one without the original samples. A bucket count stops at 2^32 - 1
+// (about 1.4 years of 10 ms samples at one rate) rather than wrapping.
+class RateHistogram {
+public:
+    static constexpr int kSubBucketBits = 5;
+    static constexpr int kMaxExponent = 40;
+    static constexpr size_t kBuckets =
+        (1u << kSubBucketBits) + (kMaxExponent - kSubBucketBits) * (1u << (kSubBucketBits - 1));
+
+    RateHistogram() { clear(); }
+
+    // Add `count` samples of one rate; negative and non-finite rates count as 0
+    void record(double bytesPerSecond, uint32_t count = 1);
+    void merge(const RateHistogram& other);
+    void clear();
+
+    uint64_t count() const { return count_; }
+    double max() const { return max_; }
+
+    // Rate at or below which a fraction q (0..1) of the samples fall;
+    // 0 for an empty histogram
+    double percentile(double q) const;
+
+    // Sparse text form "max;index:count index:count ..." without commas, so
+    // it fits in one column of usage_data.txt; decode() accepts "" as empty
+    std::string encode() const;
+    bool decode(const std::string& text);
+
+    // Bucket-level access for compact binary records (usage journal):
+    // the count in one bucket, and adding counts to one bucket directly
+    uint32_t bucketCount(size_t index) const { return counts_[index]; }
+    void addToBucket(size_t index, uint32_t count, double max);
+
+    static size_t bucketIndex(uint64_t value);
+    static uint64_t bucketLow(size_t index);
+    static uint64_t bucketWidth(size_t index);
+
+private:
+    uint32_t counts_[kBuckets];
+    uint64_t count_;
+    double max_;
+};
+
+// Download and upload rate histograms of one period (session, day, month)
+struct RateDigest {
+    RateHistogram download;
+    RateHistogram upload;
+
+    void merge(const RateDigest& other) {
+        download.merge(other.download);
+        upload.merge(other.upload);
+    }
+    void clear() {
+        download.clear();
+        upload.clear();
+    }
+};
+
+#endif // RATE_HISTOGRAM_H
@@ -0,0 +1,46 @@
+#ifndef ROUTE_WATCHER_H
+#define ROUTE_WATCHER_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+// Follows default-route and link changes through the rtnetlink multicast
+// groups (RTMGRP_LINK, RTMGRP_IPV4_ROUTE, RTMGRP_IPV6_ROUTE) and reports
+// the interface that carries the default route whenever it changes. The
+// watcher thread sleeps in poll() until the kernel sends a notification;
+// nothing is re-enumerated on a timer.
+class RouteWatcher {
+public:
+    // Called on the watcher thread with the new default-route interface,
+    // or an empty string when no default route is left
+    using Callback = std::function<void(const std::string& iface)>;
+
+    explicit RouteWatcher(Callback onChange);
+    ~RouteWatcher();
+
+    RouteWatcher(const RouteWatcher&) = delete;
+    RouteWatcher& operator=(const RouteWatcher&) = delete;
+
+    // Subscribe and start the watcher thread; false when rtnetlink
+    // notifications are not available on this platform
+    bool start(const std::string& current);
+    void stop();
+
+    // Interface of the preferred default route (IPv4 first, then IPv6,
+    // lowest metric wins), from one RTM_GETROUTE dump. Empty if none.
+    static std::string queryDefaultInterface();
+
+private:
+    void run();
+
+    Callback callback_;
+    std::string current_;
+    int fd_;
+    int wakeFd_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+};
+
+#endif // ROUTE_WATCHER_H
@@ -0,0 +1,153 @@
+#ifndef RRD_STORE_H
+#define RRD_STORE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "metrics_snapshot.h"
+
+// Round-robin history of the monitored interface at three resolutions,
+// one preallocated file per tier in the history directory:
+//
+//   history_1s.rrd   1 s slots for 24 hours     (86400 slots)
+//   history_1m.rrd   1 min slots for 90 days    (129600 slots)
+//   history_1h.rrd   1 h slots for 10 years     (87600 slots)
+//
+// Files are created at full size (posix_fallocate, so the blocks are
+// reserved too) and written only through a shared mapping; they never
+// grow, and the whole store is kTotalFileBytes on disk.
+//
+// A slot is addressed by its own start time: slot (t / resolution) %
+// capacity. It holds data only while its start stamp matches; the writer
+// resets a slot left over from an earlier lap before folding into it, so
+// there is no cursor to persist and a gap simply leaves stale slots that
+// readers skip. Every sample is folded into all three tiers as it
+// arrives (bytes, seconds covered, min/max rate), so rollups cost O(1)
+// per sample and nothing is recomputed.
+//
+// Readers in other processes map the files read-only. Each slot carries
+// a stamp that is odd while the writer is updating it; readers copy
+// between two stamp loads and retry, as in sample_ring.
+namespace rrd {
+
+constexpr uint32_t kMagic = 0x44525253;  // "SRRD"
+constexpr uint32_t kSchemaVersion = 1;   // bump on any layout change
+
+enum class Tier { Second, Minute, Hour };
+constexpr size_t kTierCount = 3;
+
+struct TierSpec {
+    const char* file;
+    const char* name;      // "1s", "1m", "1h"
+    uint32_t resolution;   // seconds per slot
+    uint32_t capacity;     // slots
+};
+
+constexpr TierSpec kTiers[kTierCount] = {
+    {"history_1s.rrd", "1s", 1, 24 * 3600},
+    {"history_1m.rrd", "1m", 60, 90 * 24 * 60},
+    {"history_1h.rrd", "1h", 3600, 10 * 365 * 24},
+};
+
+struct alignas(64) FileHeader {
+    uint32_t magic;
+    uint32_t schema_version;
+    uint32_t resolution;
+    uint32_t capacity;
+    uint32_t slot_size;
+    uint32_t reserved0;
+    int64_t created;          // unix time the file was laid out
+    uint8_t reserved[32];
+};
+
+// Aggregate of every sample whose wall-clock second falls in
+// [start, start + resolution). Rates are bytes/s; the average rate is
+// bytes / seconds.
+struct alignas(64) Slot {
+    std::atomic<uint32_t> stamp;  // odd while the writer is updating
+    uint32_t samples;
+    int64_t start;                // unix time; 0 for a never-written slot
+    uint64_t rx_bytes;
+    uint64_t tx_bytes;
+    double seconds;               // time covered by the samples
+    float rx_min;
+    float rx_max;
+    float tx_min;
+    float tx_max;
+    uint8_t reserved[8];
+};
+
+// A slot as readers see it
+struct Point {
+    int64_t start;
+    uint32_t samples;
+    uint64_t rx_bytes;
+    uint64_t tx_bytes;
+    double seconds;
+    float rx_min;
+    float rx_max;
+    float tx_min;
+    float tx_max;
+
+    double rxAverage() const { return seconds > 0.0 ? rx_bytes / seconds : 0.0; }
+    double txAverage() const { return seconds > 0.0 ? tx_bytes / seconds : 0.0; }
+};
+
+constexpr size_t fileBytes(const TierSpec& tier) {
+    return sizeof(FileHeader) + static_cast<size_t>(tier.capacity) * sizeof(Slot);
+}
+constexpr size_t kTotalFileBytes = fileBytes(kTiers[0]) + fileBytes(kTiers[1]) + fileBytes(kTiers[2]);
+
+// $HOME/.config/linux-speed-meter
+std::string defaultDirectory();
+// SPEED_METER_HISTORY: unset, "0" or "off" disables the store (empty
+// string); "1" or "on" selects defaultDirectory(); anything else is the
+// directory, with a leading ~ expanded
+std::string directoryFromEnvironment();
+
+// Slots of one tier with start in [from, to), oldest first. Reads the
+// file through a read-only mapping; false if it is missing or not a
+// history file of this schema.
+bool read(const std::string& directory, Tier tier, int64_t from, int64_t to, std::vector<Point>& out);
+
+} // namespace rrd
+
+// Writer side, owned by the sampler. open() lays out missing or
+// mismatched files and takes an exclusive flock on each, so a second
+// collector on the same directory is refused rather than interleaving
+// with the first.
+class RrdStore {
+public:
+    RrdStore();
+    ~RrdStore();
+    RrdStore(const RrdStore&) = delete;
+    RrdStore& operator=(const RrdStore&) = delete;
+
+    bool open(const std::string& directory);
+    void close();
+
+    // Fold one sample into every tier: the bytes moved since the previous
+    // call (from the snapshot's running totals), seconds is the interval
+    // the sample covers and now its wall-clock second. The first call
+    // after open() counts from zero, the meter's start.
+    void record(const MetricsSnapshot& metrics, double seconds, int64_t now);
+
+private:
+    struct Mapping {
+        int fd;
+        void* map;
+        size_t size;
+        rrd::Slot* slots;
+    };
+
+    void fold(const rrd::TierSpec& spec, rrd::Slot* slots, int64_t now, double seconds,
+              uint64_t rx_bytes, uint64_t tx_bytes, float rx_rate, float tx_rate);
+
+    Mapping tiers_[rrd::kTierCount];
+    uint64_t last_rx_bytes_;
+    uint64_t last_tx_bytes_;
+};
+
+#endif // RRD_STORE_H
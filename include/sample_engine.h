@@ -0,0 +1,57 @@
+#ifndef SAMPLE_ENGINE_H
+#define SAMPLE_ENGINE_H
+
+#include <cstdint>
+#include <string>
+#include "net_stats.h"
+#include "metrics_snapshot.h"
+#include "rate_filter.h"
+#include "seqlock.h"
+
+// Turns successive counter reads of one interface into a MetricsSnapshot:
+// deltas against the previous read, rates over the real interval, the
+// smoothing pipeline and running totals. Every frontend feeds its counter
+// source through this one class, so they all agree on the same link.
+// Not thread-safe; the sampler thread owns it and publishes copies.
+class SampleEngine {
+public:
+    explicit SampleEngine(RateFilterKind filter = rateFilterFromEnvironment());
+
+    // Measure the next update() from stats. Rates read 0 and the filters
+    // start over; totals are kept.
+    void rebaseline(const NetStats& stats, int64_t sampleNs);
+    // The next update() becomes the baseline (counters unreadable)
+    void forgetBaseline() { haveBaseline_ = false; }
+    bool hasBaseline() const { return haveBaseline_; }
+
+    // Fold in one counter read taken at sampleNs (CLOCK_MONOTONIC).
+    // nominalSeconds stands in for a zero or negative interval. Returns
+    // false when there was no baseline and stats became it.
+    bool update(const NetStats& stats, int64_t sampleNs, double nominalSeconds);
+
+    // Bytes moved in both directions and real seconds covered by the
+    // last update(); 0 after a rebaseline
+    uint64_t deltaBytes() const { return deltaBytes_; }
+    double elapsedSeconds() const { return elapsedSeconds_; }
+
+    void setInterface(const std::string& name);
+    void setSampling(int32_t periodMs, bool idle);
+
+    const MetricsSnapshot& metrics() const { return metrics_; }
+    // Stamp the next sequence number and store the metrics into out
+    void publish(Seqlock<MetricsSnapshot>& out);
+
+private:
+    MetricsSnapshot metrics_;
+    NetStats last_;
+    bool haveBaseline_;
+    int64_t lastSampleNs_;
+    uint64_t deltaBytes_;
+    double elapsedSeconds_;
+    RateFilter rxFilter_;
+    RateFilter txFilter_;
+    RateFilter rxPacketFilter_;
+    RateFilter txPacketFilter_;
+};
+
+#endif // SAMPLE_ENGINE_H
@@ -0,0 +1,138 @@
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "metrics_snapshot.h"
+
+// Single-producer, multi-consumer ring of MetricsSnapshot in a POSIX
+// shared-memory object (/dev/shm). The sampler writes every sample into
+// the next slot; any number of processes map the object read-only and
+// read samples with plain loads, without a syscall or any decoding per
+// sample.
+//
+// Each slot carries a stamp: 2i+1 while sample i is being written, 2i+2
+// once it is complete. A reader copies the payload between two stamp
+// loads and keeps it only if both equal 2i+2, so a slot the writer laps
+// mid-copy is detected, never returned torn. The writer never waits on
+// readers; a reader that falls more than `capacity` samples behind loses
+// the oldest ones and is told how many.
+namespace sample_ring {
+
+constexpr uint32_t kMagic = 0x474e5253;  // "SRNG"
+constexpr uint32_t kSchemaVersion = 1;   // bump on any layout or payload change
+constexpr uint32_t kDefaultCapacity = 4096;
+constexpr size_t kCacheLine = 64;
+
+constexpr size_t kPayloadWords = (sizeof(MetricsSnapshot) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+struct Slot {
+    std::atomic<uint64_t> stamp;
+    std::atomic<uint64_t> words[kPayloadWords];
+};
+
+// Slots start on their own cache lines so a reader of one slot never
+// shares a line with the slot being written
+constexpr size_t kSlotStride = (sizeof(Slot) + kCacheLine - 1) / kCacheLine * kCacheLine;
+
+struct Header {
+    uint32_t magic;
+    uint32_t schema_version;
+    uint32_t slot_stride;
+    uint32_t capacity;                  // slots, a power of two
+    uint32_t payload_size;              // sizeof(MetricsSnapshot)
+    uint32_t reserved;
+    std::atomic<uint64_t> epoch;        // changes each time a writer (re)opens the ring
+    std::atomic<uint32_t> writer_open;  // 0 once the writer has closed
+    // Samples written so far; sample i lives in slot i % capacity
+    alignas(kCacheLine) std::atomic<uint64_t> write_index;
+};
+
+constexpr size_t kHeaderSize = (sizeof(Header) + kCacheLine - 1) / kCacheLine * kCacheLine;
+
+inline size_t mappingSize(uint32_t capacity) {
+    return kHeaderSize + static_cast<size_t>(capacity) * kSlotStride;
+}
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "ring words must be lock-free to be shared between processes");
+
+// Ring requested through SPEED_METER_RING: "" when unset, "0" or "off";
+// the default name for "1" or "on"; otherwise the value as a shm name
+std::string ringNameFromEnvironment();
+// "/speed-meter-<uid>"
+std::string defaultRingName();
+
+} // namespace sample_ring
+
+// Producer side; one per ring, called from the sampler thread only
+class SampleRingWriter {
+public:
+    SampleRingWriter();
+    ~SampleRingWriter();
+    SampleRingWriter(const SampleRingWriter&) = delete;
+    SampleRingWriter& operator=(const SampleRingWriter&) = delete;
+
+    // Create or take over the shared-memory object `name`. Mode 0644: the
+    // same rates are world-readable in /proc/net/dev anyway.
+    // capacity is rounded up to a power of two. Holds an exclusive flock on
+    // the object until close(); false if another writer holds it.
+    bool open(const std::string& name, uint32_t capacity = sample_ring::kDefaultCapacity);
+    // Mark the ring closed for readers and unmap it; the object stays so
+    // readers can keep the last samples
+    void close();
+    bool isOpen() const { return header_ != nullptr; }
+
+    void publish(const MetricsSnapshot& snapshot);
+
+private:
+    sample_ring::Header* header_;
+    char* slots_;
+    uint64_t next_;
+    uint32_t mask_;
+    size_t size_;
+    int fd_;  // kept open for the flock
+};
+
+// Consumer side; maps the ring read-only. Not thread-safe: one reader per
+// thread, as many as wanted per process.
+class SampleRingReader {
+public:
+    SampleRingReader();
+    ~SampleRingReader();
+    SampleRingReader(const SampleRingReader&) = delete;
+    SampleRingReader& operator=(const SampleRingReader&) = delete;
+
+    // Map the ring and start after its newest sample. Fails if the object
+    // is missing or has another schema version or payload size.
+    bool open(const std::string& name = sample_ring::defaultRingName());
+    void close();
+    bool isOpen() const { return header_ != nullptr; }
+
+    // Newest complete sample; false before the first one
+    bool latest(MetricsSnapshot& out) const;
+    // Oldest sample not yet returned. False once caught up. lost, when
+    // given, is increased by samples overwritten before they were read.
+    bool next(MetricsSnapshot& out, uint64_t* lost = nullptr);
+    // Skip to the newest sample; the next next() returns the one after it
+    void skipToEnd();
+
+    uint64_t writeIndex() const;
+    uint32_t capacity() const { return mask_ + 1; }
+    // The writer has closed or been replaced; reopen to follow a new one
+    bool writerGone() const;
+
+private:
+    // Copy sample index out of its slot; false if it is not (or no longer) there
+    bool readSlot(uint64_t index, MetricsSnapshot& out) const;
+
+    const sample_ring::Header* header_;
+    const char* slots_;
+    uint64_t cursor_;
+    uint64_t epoch_;
+    uint32_t mask_;
+    size_t size_;
+};
+
+#endif // SAMPLE_RING_H
@@ -0,0 +1,101 @@
+#ifndef SAMPLE_SCHEDULER_H
+#define SAMPLE_SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// One wakeup of the sampler
+struct SampleTick {
+    int64_t monotonic_ns;     // CLOCK_MONOTONIC when the sampler woke
+    int64_t boottime_ns;      // CLOCK_BOOTTIME at the same instant
+    double interval_seconds;  // real time since the previous tick
+    uint64_t expirations;     // deadlines covered by this tick (1 unless late)
+    bool resumed;             // the machine was suspended since the previous tick
+};
+
+// Periodic sampler clock with absolute deadlines. On Linux a timerfd armed
+// on CLOCK_MONOTONIC with TFD_TIMER_ABSTIME keeps every deadline on the
+// grid start + k * period, so the time spent sampling never accumulates
+// as drift. Elsewhere the same grid is followed with sleep_until().
+class SampleScheduler {
+public:
+    static constexpr int64_t kMinPeriodNs = 10 * 1000 * 1000; // 10 ms
+
+    explicit SampleScheduler(std::chrono::milliseconds period);
+    ~SampleScheduler();
+
+    SampleScheduler(const SampleScheduler&) = delete;
+    SampleScheduler& operator=(const SampleScheduler&) = delete;
+
+    // Change the period; applied from the next deadline. Thread-safe.
+    void setPeriod(std::chrono::milliseconds period);
+    std::chrono::milliseconds period() const;
+
+    // Block until the next deadline. Returns false once stop() was called.
+    bool wait(SampleTick& tick);
+
+    // Wake a blocked wait() and make every later call return false
+    void stop();
+
+    static int64_t monotonicNs();
+    static int64_t boottimeNs();
+
+private:
+    bool arm(int64_t deadline_ns, int64_t period_ns);
+
+    std::atomic<int64_t> period_ns_;
+    int64_t armed_period_ns_;
+    int64_t next_deadline_ns_;
+    int64_t last_monotonic_ns_;
+    int64_t last_boottime_ns_;
+    std::atomic<bool> stopped_;
+    int timer_fd_;
+    int wake_fd_;
+    std::mutex wait_mutex_;
+    std::condition_variable wait_cv_;
+};
+
+// Sampling period policy for quiet links. The period stays at fast while
+// bytes move; once the deltas have been zero for kIdleGrace it doubles on
+// every further idle sample up to slow, and it drops back to fast on the
+// first non-zero delta. slow <= fast disables the back-off.
+class AdaptiveSampling {
+public:
+    static constexpr std::chrono::milliseconds kIdleGrace{3000};
+
+    AdaptiveSampling(std::chrono::milliseconds fast, std::chrono::milliseconds slow);
+
+    // Feed the byte delta of the sample just taken; returns the period to
+    // use until the next one
+    std::chrono::milliseconds next(uint64_t delta_bytes);
+
+    // Return to the fast period (new interface, resume from suspend)
+    void reset();
+
+    std::chrono::milliseconds fast() const { return fast_; }
+    std::chrono::milliseconds slow() const { return slow_; }
+    std::chrono::milliseconds current() const { return current_; }
+    bool idle() const { return current_ > fast_; }
+
+private:
+    std::chrono::milliseconds fast_;
+    std::chrono::milliseconds slow_;
+    std::chrono::milliseconds current_;
+    std::chrono::milliseconds quiet_for_;
+};
+
+// Sampling period requested through SPEED_METER_INTERVAL_MS, clamped to
+// at least 10 ms; fallback when unset or invalid
+std::chrono::milliseconds sampleIntervalFromEnvironment(std::chrono::milliseconds fallback);
+
+// Longest idle period requested through SPEED_METER_MAX_INTERVAL_MS
+std::chrono::milliseconds maxSampleIntervalFromEnvironment(std::chrono::milliseconds fallback);
+
+// Shortest time between socket dumps (per-process traffic, TCP health),
+// from SPEED_METER_PROCESS_INTERVAL_MS
+std::chrono::milliseconds processIntervalFromEnvironment(std::chrono::milliseconds fallback);
+
+#endif // SAMPLE_SCHEDULER_H
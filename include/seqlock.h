@@ -0,0 +1,66 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Single-writer sequence lock for a small trivially copyable value.
+// The writer never blocks; readers retry while a store is in progress and
+// always see one complete value. The payload is held in relaxed atomic
+// words so a reader racing the writer is well defined, not just lucky.
+template <typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock payload must be trivially copyable");
+
+public:
+    Seqlock() : seq_(0) {
+        T zero;
+        std::memset(&zero, 0, sizeof(zero));
+        store(zero);
+        seq_.store(0, std::memory_order_relaxed);
+    }
+
+    // Writer side; only one thread may call store()
+    void store(const T& value) {
+        uint64_t words[kWords] = {};
+        std::memcpy(words, &value, sizeof(T));
+
+        const uint32_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < kWords; ++i) {
+            words_[i].store(words[i], std::memory_order_relaxed);
+        }
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    // Reader side; safe from any number of threads
+    T load() const {
+        uint64_t words[kWords];
+        uint32_t before;
+        uint32_t after;
+        do {
+            before = seq_.load(std::memory_order_acquire);
+            for (size_t i = 0; i < kWords; ++i) {
+                words[i] = words_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = seq_.load(std::memory_order_relaxed);
+        } while ((before & 1u) != 0 || before != after);
+
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint32_t> seq_;
+    std::atomic<uint64_t> words_[kWords];
+};
+
+#endif // SEQLOCK_H
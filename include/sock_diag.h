@@ -0,0 +1,72 @@
+#ifndef SOCK_DIAG_H
+#define SOCK_DIAG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// One TCP socket from a NETLINK_SOCK_DIAG dump, with the tcp_info fields
+// the meter uses. Fields a kernel does not report are zero.
+struct TcpSocketInfo {
+    uint32_t inode;
+    uint32_t uid;
+    uint8_t family;          // AF_INET or AF_INET6
+    uint8_t state;           // TCP_ESTABLISHED, ...
+    uint16_t local_port;
+    uint16_t remote_port;
+    uint8_t local_addr[16];  // IPv4 uses the first 4 bytes
+    uint8_t remote_addr[16];
+    uint32_t rtt_us;
+    uint32_t rttvar_us;
+    uint32_t min_rtt_us;
+    uint32_t snd_cwnd;       // segments
+    uint32_t retransmits;    // unrecovered RTO timeouts
+    uint32_t total_retrans;  // segments retransmitted over the connection
+    uint64_t pacing_rate;    // bytes/s
+    uint64_t delivery_rate;  // bytes/s
+    uint64_t bytes_acked;    // sent and acknowledged
+    uint64_t bytes_received;
+};
+
+// Bit for a TCP state in the states mask of dumpTcp()
+constexpr uint32_t tcpStateBit(int state) { return 1u << state; }
+
+// Client for NETLINK_SOCK_DIAG (inet_diag) TCP dumps. Replies are decoded
+// straight from one reusable receive buffer; nothing is allocated per
+// socket. Linux only; elsewhere isOpen() is false.
+class SockDiag {
+public:
+    SockDiag();
+    ~SockDiag();
+
+    SockDiag(const SockDiag&) = delete;
+    SockDiag& operator=(const SockDiag&) = delete;
+
+    bool isOpen() const { return fd_ >= 0; }
+
+    // Dump IPv4 and IPv6 TCP sockets whose state is in statesMask and call
+    // fn(const TcpSocketInfo&) for each. Returns false if a dump failed.
+    template <typename Fn>
+    bool dumpTcp(uint32_t statesMask, Fn&& fn);
+
+private:
+    using Visitor = void (*)(void* context, const TcpSocketInfo& info);
+    bool dumpAll(uint32_t statesMask, Visitor visit, void* context);
+    bool dump(uint8_t family, uint32_t statesMask, Visitor visit, void* context);
+
+    int fd_;
+    uint32_t seq_;
+    std::vector<char> buf_;
+};
+
+template <typename Fn>
+bool SockDiag::dumpTcp(uint32_t statesMask, Fn&& fn) {
+    using Callable = typename std::remove_reference<Fn>::type;
+    Visitor visit = [](void* context, const TcpSocketInfo& info) {
+        (*static_cast<Callable*>(context))(info);
+    };
+    return dumpAll(statesMask, visit, &fn);
+}
+
+#endif // SOCK_DIAG_H
@@ -7,13 +7,27 @@
 #include <thread>
 #include <mutex>
 #include <chrono>
+#include <memory>
+#include <vector>
+#include "net_stats.h"
+#include "counter_backend.h"
+#include "interface_table.h"
+#include "route_watcher.h"
+#include "sample_scheduler.h"
+#include "metrics_snapshot.h"
+#include "seqlock.h"
+#include "label_renderer.h"
+#include "process_traffic.h"
+#include "sock_diag.h"
+#include "nic_load.h"
+#include "rate_histogram.h"
+#include "sample_engine.h"
 
-enum class SpeedUnit { KB, MB };
+class SampleRingWriter;
+class RrdStore;
+class TcpHealthTable;
 
-struct NetStats {
-    uint64_t rx_bytes;
-    uint64_t tx_bytes;
-};
+enum class SpeedUnit { KB, MB };
 
 class SpeedMeter {
 public:
@@ -21,30 +35,123 @@ public:
     ~SpeedMeter();
     void on_quit();
     void update_loop();
-    std::string get_iface() const { return iface; }
-    double get_total_rx_mb() const { return total_rx / 1024.0 / 1024.0; }
-    double get_total_tx_mb() const { return total_tx / 1024.0 / 1024.0; }
-    double get_current_download_speed() const { return current_download_speed.load(); }
-    double get_current_upload_speed() const { return current_upload_speed.load(); }
+    // Consistent view of the latest sample; lock-free, safe from any thread
+    MetricsSnapshot get_snapshot() const { return snapshot_.load(); }
+    int64_t get_last_sample_ns() const { return get_snapshot().sample_ns; }
+    // Current sampling period; longer than the configured one while idle
+    int get_sample_period_ms() const { return get_snapshot().sample_period_ms; }
+    bool is_sampling_idle() const { return get_snapshot().sampling_idle; }
+    std::string get_iface() const { return get_snapshot().iface; }
+    double get_total_rx_mb() const { return get_snapshot().total_rx_bytes / 1024.0 / 1024.0; }
+    double get_total_tx_mb() const { return get_snapshot().total_tx_bytes / 1024.0 / 1024.0; }
+    double get_current_download_speed() const { return get_snapshot().rx_rate; }
+    double get_current_upload_speed() const { return get_snapshot().tx_rate; }
     std::string get_label() const;
     std::string get_tooltip() const;
+    // Change-driven rendering for a long-lived consumer such as the tray;
+    // returns true when renderer's label or tooltip text changed
+    bool render(LabelRenderer& renderer, const MetricsSnapshot& snapshot) const;
+    // All-interface mode (SPEED_METER_INTERFACES=all)
+    bool is_all_interfaces() const { return all_interfaces_; }
+    InterfaceRate get_all_interfaces_total() const;
+    std::vector<InterfaceRate> get_top_interfaces() const;
+    // Per-process TCP throughput (SPEED_METER_PROCESSES=1)
+    bool is_tracking_processes() const { return process_traffic_ != nullptr; }
+    std::vector<ProcessRate> get_top_processes() const;
+    // Per-CPU softirq and NIC queue load, sampled only while a consumer
+    // asks for it (the dashboard's CPU & Queues tab)
+    void set_nic_load_tracking(bool enabled) { nic_load_wanted_.store(enabled); }
+    NicLoad get_nic_load() const;
+    // Established TCP connections with their tcp_info (the dashboard's TCP
+    // connections section), dumped on the sampler thread while wanted.
+    // take_tcp_health() swaps the newest dump into rows and returns false
+    // if there has been none since the last call.
+    void set_tcp_health_tracking(bool enabled) { tcp_health_wanted_.store(enabled); }
+    bool take_tcp_health(std::vector<TcpSocketInfo>& rows);
+    // Histograms of the raw (unsmoothed) rate of every sample since start
+    RateDigest get_session_rates() const;
+    // Samples recorded since the previous call, for DataManager::recordRates()
+    RateDigest take_rate_samples();
+    // eventfd that becomes readable after every published sample, for an
+    // event loop serving the snapshot (speed-meterd); created on first
+    // call, -1 where unsupported
+    int sample_event_fd();
 private:
     std::string iface;
     std::atomic<bool> running;
+    SampleScheduler scheduler_;
+    AdaptiveSampling sampling_;
     std::thread thread;
-    NetStats last_stats;
-    uint64_t total_rx, total_tx;
-    std::atomic<double> current_download_speed;
-    std::atomic<double> current_upload_speed;
-    double smoothed_download_speed_;
-    double smoothed_upload_speed_;
-    bool first_sample_;
-    std::chrono::steady_clock::time_point last_update_time_;
-    mutable std::mutex label_mutex_;
-    std::string label_;
-    std::string tooltip_;
-    void update_stats();
-    std::string format_speed(double bytes_per_second) const;
+    std::unique_ptr<CounterBackend> backend_;
+    // Rates, smoothing and totals of the monitored interface; the sampler
+    // thread's working copy, published to readers through snapshot_
+    SampleEngine engine_;
+    Seqlock<MetricsSnapshot> snapshot_;
+    std::atomic<int> sample_event_fd_;
+#ifdef __linux__
+    // Every published sample is also copied here for shared-memory
+    // readers when SPEED_METER_RING asks for it
+    std::unique_ptr<SampleRingWriter> ring_;
+    // Round-robin history files, fed every sample when
+    // SPEED_METER_HISTORY names a directory
+    std::unique_ptr<RrdStore> history_;
+#endif
+    bool all_interfaces_;
+    mutable std::mutex interfaces_mutex_; // guards interfaces_total_ and top_interfaces_
+    std::unique_ptr<ProcNetDevReader> table_reader_;
+    InterfaceTable table_;
+    std::vector<uint32_t> top_slots_;
+    InterfaceRate interfaces_total_;
+    std::vector<InterfaceRate> top_interfaces_;
+    // Refreshed from the sampler thread, at most once per
+    // process_min_interval_ns_ (SPEED_METER_PROCESS_INTERVAL_MS) and less
+    // often when the dump itself gets expensive
+    std::unique_ptr<ProcessTraffic> process_traffic_;
+    int64_t last_process_ns_;
+    int64_t process_min_interval_ns_;
+    int64_t process_interval_ns_;
+    std::vector<ProcessRate> process_scratch_;
+    mutable std::mutex processes_mutex_; // guards top_processes_
+    std::vector<ProcessRate> top_processes_;
+    // Sampled in the same tick as the interface counters while wanted
+    std::atomic<bool> nic_load_wanted_;
+    bool nic_load_active_;
+    std::unique_ptr<NicLoadSampler> nic_load_;
+    mutable std::mutex nic_load_mutex_; // guards nic_load_published_
+    NicLoad nic_load_published_;
+    // Dumped like process_traffic_: at most once per process_min_interval_ns_,
+    // spaced out by what the last dump cost
+    std::atomic<bool> tcp_health_wanted_;
+#ifdef __linux__
+    std::unique_ptr<TcpHealthTable> tcp_health_;
+#endif
+    int64_t last_tcp_health_ns_;
+    int64_t tcp_health_interval_ns_;
+    std::mutex tcp_health_mutex_; // guards tcp_health_rows_ and tcp_health_fresh_
+    std::vector<TcpSocketInfo> tcp_health_rows_;
+    bool tcp_health_fresh_;
+    // Each sample counts once per nominal period it covers, so percentiles
+    // are shares of time even while the period is backed off
+    mutable std::mutex rates_mutex_; // guards session_rates_ and pending_rates_
+    RateDigest session_rates_;
+    RateDigest pending_rates_;
+    // Default-route changes reported by route_watcher_, applied by the
+    // sampler thread between two samples
+    std::unique_ptr<RouteWatcher> route_watcher_;
+    std::mutex retarget_mutex_;
+    std::string pending_iface_;
+    std::atomic<bool> retarget_pending_;
+    void update_stats(const SampleTick& tick);
+    void request_retarget(const std::string& new_iface);
+    bool apply_retarget();
+    void adapt_period(uint64_t delta_bytes);
+    void publish();
+    void sample_interface_table(double elapsed_seconds);
+    void sample_processes(int64_t now_ns);
+    void sample_nic_load(double elapsed_seconds);
+    void sample_tcp_health(int64_t now_ns);
+    void record_rates(double download, double upload, double elapsed_seconds);
+    bool read_counters(NetStats& stats);
 };
 
 #endif // SPEED_MONITOR_H
\ No newline at end of file
@@ -3,12 +3,16 @@
 
 #include "speed_monitor_qt.h"
 #include <QObject>
-#include <QThread>
-#include <QMutex>
-#include <QElapsedTimer>
-#include <atomic>
-#include <fstream>
+#include <QTimer>
+#include <memory>
+#include "meter_client.h"
+#include "speed_monitor.h"
 
+// Qt face of the shared sampler: SpeedMeter does the counting, smoothing
+// and route following; this class only formats its snapshot and turns an
+// interface change into connectionChanged(). When speed-meterd is running
+// the snapshots are the daemon's pushed samples instead, and a local
+// SpeedMeter is started only if the daemon goes away.
 class SpeedMonitorLinux : public SpeedMonitor {
     Q_OBJECT
 
@@ -17,6 +21,8 @@ public:
     ~SpeedMonitorLinux();
 
     bool initialize() override;
+    // Sample locally even when speed-meterd is running; call before start()
+    void setStandalone(bool standalone) { standalone_ = standalone; }
     void start() override;
     void stop() override;
 
@@ -30,36 +36,33 @@ public:
     QString getIPAddress() const override;
     bool isConnected() const override;
     bool isActive() const override;
+    int getSamplePeriodMs() const override;
+    bool isSamplingIdle() const override;
+    PacketRates getPacketRates() const override;
+    bool isAllInterfaces() const override;
+    InterfaceRate getAllInterfacesTotal() const override;
+    std::vector<InterfaceRate> getTopInterfaces() const override;
 
 private:
-    void monitorNetwork();
+    bool connectToDaemon();
+    void startLocal();
+    void poll();
+    MetricsSnapshot snapshot() const;
     QString formatBytes(double bytes) const;
     QString formatSpeed(double bytesPerSecond) const;
-    bool readNetworkStats(quint64& rx, quint64& tx);
+    static QString addressOf(const QString& name);
 
-    QThread* monitorThread_;
-    mutable QMutex dataMutex_;
+    std::unique_ptr<SpeedMeter> meter_;
+    std::unique_ptr<MeterClient> client_;
+    MetricsSnapshot clientSnapshot_;  // newest sample pushed by the daemon
+    bool standalone_;
+    QTimer pollTimer_;
+    uint64_t lastSeq_;
 
-    // Network statistics
-    std::atomic<quint64> totalDownloaded_;
-    std::atomic<quint64> totalUploaded_;
-    std::atomic<double> downloadRate_;
-    std::atomic<double> uploadRate_;
-
-    // Previous values for rate calculation
-    quint64 prevDownloaded_;
-    quint64 prevUploaded_;
-    QElapsedTimer timer_;
-    bool firstSample_;
-    double smoothedDownload_;
-    double smoothedUpload_;
-
-    // Interface information
+    // Interface information, kept in step with the snapshot by poll()
     QString interfaceName_;
     QString ipAddress_;
     bool connected_;
-
-    std::atomic<bool> running_;
 };
 
-#endif // SPEED_MONITOR_LINUX_H
\ No newline at end of file
+#endif // SPEED_MONITOR_LINUX_H
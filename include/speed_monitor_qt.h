@@ -3,6 +3,40 @@
 
 #include <QObject>
 #include <QString>
+#include <vector>
+#include "interface_table.h"
+#include "metrics_snapshot.h"
+
+// Packet-level view of the last interval, per direction. Byte rates are
+// repeated as numbers so callers can derive the average packet size.
+struct PacketRates {
+    double downloadPackets = 0.0;   // packets/s
+    double uploadPackets = 0.0;
+    double downloadDrops = 0.0;     // dropped packets/s
+    double uploadDrops = 0.0;
+    double downloadBytes = 0.0;     // bytes/s
+    double uploadBytes = 0.0;
+    quint64 totalDownloadDropped = 0;
+    quint64 totalUploadDropped = 0;
+    quint64 totalDownloadErrors = 0;
+    quint64 totalUploadErrors = 0;
+};
+
+// Packet view of one shared-sampler snapshot
+inline PacketRates packetRatesFromSnapshot(const MetricsSnapshot& snapshot) {
+    PacketRates rates;
+    rates.downloadPackets = snapshot.rx_packet_rate;
+    rates.uploadPackets = snapshot.tx_packet_rate;
+    rates.downloadDrops = snapshot.rx_drop_rate;
+    rates.uploadDrops = snapshot.tx_drop_rate;
+    rates.downloadBytes = snapshot.rx_rate;
+    rates.uploadBytes = snapshot.tx_rate;
+    rates.totalDownloadDropped = snapshot.total_rx_dropped;
+    rates.totalUploadDropped = snapshot.total_tx_dropped;
+    rates.totalDownloadErrors = snapshot.total_rx_errors;
+    rates.totalUploadErrors = snapshot.total_tx_errors;
+    return rates;
+}
 
 class SpeedMonitor : public QObject {
     Q_OBJECT
@@ -27,6 +61,20 @@ public:
     virtual bool isConnected() const = 0;
     virtual bool isActive() const = 0;
 
+    // Current sampling period in ms (0 if the backend does not report it)
+    // and whether it is backed off because the link is idle
+    virtual int getSamplePeriodMs() const { return 0; }
+    virtual bool isSamplingIdle() const { return false; }
+
+    // Packet, drop and error rates; all zero if the backend only counts bytes
+    virtual PacketRates getPacketRates() const { return PacketRates(); }
+
+    // All-interface mode (SPEED_METER_INTERFACES=all): the sum over every
+    // interface but loopback and the busiest ones, busiest first
+    virtual bool isAllInterfaces() const { return false; }
+    virtual InterfaceRate getAllInterfacesTotal() const { return InterfaceRate{"all", 0.0, 0.0}; }
+    virtual std::vector<InterfaceRate> getTopInterfaces() const { return std::vector<InterfaceRate>(); }
+
 signals:
     void dataUpdated();
     void connectionChanged(bool connected);
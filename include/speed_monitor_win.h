@@ -6,8 +6,8 @@
 #include <iphlpapi.h>
 #include <QObject>
 #include <QThread>
-#include <QMutex>
 #include <atomic>
+#include "sample_engine.h"
 
 #pragma comment(lib, "iphlpapi.lib")
 #pragma comment(lib, "ws2_32.lib")
@@ -33,6 +33,8 @@ public:
     QString getIPAddress() const override;
     bool isConnected() const override;
     bool isActive() const override;
+    int getSamplePeriodMs() const override;
+    PacketRates getPacketRates() const override;
 
 private:
     void monitorNetwork();
@@ -40,17 +42,11 @@ private:
     QString formatSpeed(quint64 bytesPerSecond) const;
 
     QThread* monitorThread_;
-    mutable QMutex dataMutex_;
 
-    // Network statistics
-    std::atomic<quint64> totalDownloaded_;
-    std::atomic<quint64> totalUploaded_;
-    std::atomic<quint64> downloadRate_;
-    std::atomic<quint64> uploadRate_;
-
-    // Previous values for rate calculation
-    quint64 prevDownloaded_;
-    quint64 prevUploaded_;
+    // Counters of every active interface, summed, go through the same
+    // pipeline as the Linux sampler; engine_ belongs to the monitor thread
+    SampleEngine engine_;
+    Seqlock<MetricsSnapshot> snapshot_;
 
     // Interface information
     QString interfaceName_;
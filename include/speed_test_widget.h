@@ -27,6 +27,9 @@ public:
     
     // Update results after test
     void updateResults(const SpeedTestResult& result);
+
+    // Called on the UI thread with every successful result
+    void setResultListener(std::function<void(const SpeedTestResult&)> listener) { resultListener_ = std::move(listener); }
     
 private:
     struct TestRunConfig {
@@ -64,6 +67,7 @@ private:
     std::vector<TestServer> servers_;
     bool testRunning_;
     std::deque<SpeedTestResult> history_;
+    std::function<void(const SpeedTestResult&)> resultListener_;
     
     // Signal handlers
     static void onStartClicked(GtkButton* button, gpointer userData);
@@ -0,0 +1,47 @@
+#ifndef TCP_HEALTH_H
+#define TCP_HEALTH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "sock_diag.h"
+
+// Established TCP connections with their congestion-control state (rtt,
+// cwnd, retransmits, pacing and delivery rate), from one sock_diag dump per
+// refresh. Rows are decoded into a preallocated array that only grows when
+// more connections are open than ever before; ordering is done on an index
+// array with a partial sort, so rows are never copied or fully sorted.
+// The netlink socket is opened by the first refresh(), so a table that
+// only receives rows through swapRows() (the dashboard's copy) holds none.
+class TcpHealthTable {
+public:
+    enum class SortKey { DeliveryRate, Rtt, Retransmits, Cwnd };
+
+    TcpHealthTable();
+
+    // Whether sock_diag can be opened here (Linux, not blocked)
+    static bool isSupported();
+
+    // Replace the rows with the current established connections
+    bool refresh();
+    // Exchange the rows with another buffer; dumps taken on one thread are
+    // handed to another this way without copying
+    void swapRows(std::vector<TcpSocketInfo>& rows) { rows_.swap(rows); }
+
+    size_t size() const { return rows_.size(); }
+    const TcpSocketInfo& row(uint32_t index) const { return rows_[index]; }
+
+    // Row indices of the k largest rows by key, largest first
+    const std::vector<uint32_t>& top(size_t k, SortKey key);
+
+    // "192.0.2.1:443" or "[2001:db8::1]:443"; returns the end of the text
+    static char* formatEndpoint(char* first, char* last, const TcpSocketInfo& info, bool remote);
+
+private:
+    std::unique_ptr<SockDiag> diag_;
+    std::vector<TcpSocketInfo> rows_;
+    std::vector<uint32_t> order_;
+};
+
+#endif // TCP_HEALTH_H
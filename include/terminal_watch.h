@@ -0,0 +1,45 @@
+#ifndef TERMINAL_WATCH_H
+#define TERMINAL_WATCH_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include "interface_table.h"
+#include "metrics_snapshot.h"
+
+class SpeedMeter;
+
+// Text frames for `linux-speed-meter --watch`: one fixed-width line per
+// sample for the monitored interface, or a fixed-height table with the
+// all-interface total and the busiest interfaces. On a terminal each
+// frame overwrites the previous one in place; otherwise frames are
+// appended as plain lines. A frame is formatted into one fixed buffer
+// without allocating, ready for a single write().
+class WatchFrame {
+public:
+    static constexpr size_t kCapacity = 2048;
+    static constexpr size_t kTableRows = 5;  // busiest interfaces shown
+
+    explicit WatchFrame(bool terminal);
+
+    // Format the frame for snapshot; total is nullptr unless all-interface
+    // mode is on. Returns the frame length.
+    size_t render(const MetricsSnapshot& snapshot, const InterfaceRate* total,
+                  const std::vector<InterfaceRate>& top);
+    // Text that leaves the cursor below the last frame
+    size_t finish();
+
+    const char* data() const { return buffer_; }
+
+private:
+    char buffer_[kCapacity];
+    bool terminal_;
+    bool drawn_;   // a frame is on screen
+    bool table_;   // that frame was a table
+};
+
+// Print a frame now and after every sample until running turns false.
+// Returns the process exit status.
+int runTerminalWatch(SpeedMeter& meter, const std::atomic<bool>& running);
+
+#endif // TERMINAL_WATCH_H
@@ -12,6 +12,7 @@ public:
     ~TrayIcon();
     void createTrayIcon();
     void set_label(const std::string& label, const std::string& tooltip);
+    void set_label(const char* label, const char* tooltip);
     void set_menu(GtkWidget* menu);
     void cleanup();
 private:
@@ -0,0 +1,47 @@
+#ifndef USAGE_INDEX_H
+#define USAGE_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bytes moved in some period
+struct ByteTotals {
+    uint64_t download_bytes;
+    uint64_t upload_bytes;
+
+    uint64_t total() const { return download_bytes + upload_bytes; }
+};
+
+// Fenwick (binary indexed) tree over a dense run of slots, one per day or
+// hour of history. add() and sum() over any [from, to) window are
+// O(log n), so a month, a rolling 30 days or a billing cycle starting on
+// any day costs the same few dozen additions however long the history.
+// Arithmetic wraps like uint64_t, so lowering a slot is adding its
+// negation.
+class UsageIndex {
+public:
+    size_t size() const { return values_.size(); }
+    // Grow to count slots; new slots are zero. O(log n) per slot.
+    void resize(size_t count);
+    // Insert count zero slots before slot 0; rebuilds in O(n)
+    void prepend(size_t count);
+    void clear();
+
+    void add(size_t slot, uint64_t download_bytes, uint64_t upload_bytes);
+    void set(size_t slot, const ByteTotals& value);
+    ByteTotals value(size_t slot) const { return values_[slot]; }
+    // Slots [from, to), clamped to the index
+    ByteTotals sum(size_t from, size_t to) const;
+
+    const std::vector<ByteTotals>& values() const { return values_; }
+
+private:
+    // Slots [0, count)
+    ByteTotals prefix(size_t count) const;
+
+    std::vector<ByteTotals> values_;
+    std::vector<ByteTotals> tree_;  // tree_[i - 1] covers slots (i - lowbit(i), i]
+};
+
+#endif // USAGE_INDEX_H
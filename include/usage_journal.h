@@ -0,0 +1,142 @@
+#ifndef USAGE_JOURNAL_H
+#define USAGE_JOURNAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+
+// Append-only journal of DataManager changes: fixed-size binary records,
+// each with its own CRC-32, appended after the last snapshot of
+// usage_data.txt. A one-minute save appends a usage record and a few rate
+// records (a few hundred bytes) whatever the length of the history; the
+// snapshot is rewritten only on compaction.
+//
+// The snapshot and the journal both carry a generation. Compaction writes
+// the snapshot with generation g+1, then replaces the journal with an
+// empty one of generation g+1, each by rename. A crash between the two
+// leaves a journal of generation g, which replay ignores because the
+// snapshot already holds its records. Replay stops at the first record
+// whose CRC does not match, i.e. a write torn by a crash.
+namespace usage_journal {
+
+constexpr uint32_t kMagic = 0x4a4d5053;  // "SPMJ"
+constexpr uint16_t kVersion = 1;
+constexpr size_t kRateBuckets = 8;       // histogram buckets per rate record
+
+enum class RecordType : uint8_t {
+    Usage = 1,       // updateDailyStats() increments
+    Rates = 2,       // recordRates() buckets of one direction
+    DataLimit = 3,   // setDataLimit()
+    ResetMonth = 4,  // resetMonthlyData()
+};
+
+struct FileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint64_t generation;
+    uint8_t reserved[16];
+};
+
+struct UsageDelta {
+    uint64_t download_bytes;
+    uint64_t upload_bytes;
+    uint64_t download_packets;
+    uint64_t upload_packets;
+    uint32_t download_dropped;
+    uint32_t upload_dropped;
+    uint32_t download_errors;
+    uint32_t upload_errors;
+    double download_speed;  // rates at the time of the save; raise the peaks
+    double upload_speed;
+    double download_packet_rate;
+    double upload_packet_rate;
+};
+
+struct RateBucket {
+    uint16_t index;
+    uint16_t reserved;
+    uint32_t count;
+};
+
+struct RateRun {
+    double max;
+    uint8_t upload;  // 0: download histogram, 1: upload
+    uint8_t used;    // valid entries in buckets
+    uint8_t reserved[6];
+    RateBucket buckets[kRateBuckets];
+};
+
+struct Record {
+    uint32_t crc;              // CRC-32 of the record after this field
+    uint8_t type;              // RecordType
+    uint8_t hour;              // Usage: local hour of the save, 0-23
+    uint8_t reserved[2];
+    int32_t day;               // local date as a calendar day number
+    uint32_t session_seconds;  // Usage: session time covered
+    union {
+        UsageDelta usage;
+        RateRun rates;
+        uint64_t limit_bytes;
+    };
+};
+
+static_assert(sizeof(FileHeader) == 32, "journal header layout");
+static_assert(sizeof(Record) == 96, "journal record layout");
+
+// A zeroed record of type for day
+Record makeRecord(RecordType type, int32_t day);
+// Set crc over the record
+void seal(Record& record);
+bool intact(const Record& record);
+
+uint32_t crc32(const void* data, size_t size);
+
+// Replace target with source; atomic where the platform allows
+bool replaceFile(const std::string& source, const std::string& target);
+// Flush file's buffers and its data to the disk (fdatasync)
+bool syncFile(std::FILE* file);
+// Make a rename in the directory holding path durable; no-op on Windows
+void syncParentDirectory(const std::string& path);
+// Replace path with text through a synced temp file and a rename
+bool writeFileDurably(const std::string& path, const std::string& text);
+
+} // namespace usage_journal
+
+class UsageJournal {
+public:
+    UsageJournal();
+    ~UsageJournal();
+    UsageJournal(const UsageJournal&) = delete;
+    UsageJournal& operator=(const UsageJournal&) = delete;
+
+    // Open path for appending. Records of a journal of this generation are
+    // passed to apply in order; a missing, foreign or stale journal is
+    // replaced by an empty one. False if the file cannot be written.
+    bool open(const std::string& path, uint64_t generation,
+              const std::function<void(const usage_journal::Record&)>& apply);
+    // Write records with one write; false on an I/O error
+    bool append(const usage_journal::Record* records, size_t count);
+    // Make appended records durable
+    bool sync();
+    // Replace the journal with an empty one of generation (after a snapshot)
+    bool reset(uint64_t generation);
+    void close();
+
+    bool isOpen() const { return file_ != nullptr; }
+    const std::string& path() const { return path_; }
+    // Records in the journal, replayed or appended
+    size_t records() const { return records_; }
+    // Replay stopped at a damaged record; compact to drop the tail
+    bool tornTail() const { return torn_; }
+
+private:
+    std::FILE* file_;
+    std::string path_;
+    size_t records_;
+    bool torn_;
+};
+
+#endif // USAGE_JOURNAL_H
@@ -0,0 +1,93 @@
+#ifndef USAGE_WRITER_H
+#define USAGE_WRITER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "usage_journal.h"
+
+// Counters describing the writer, for self-monitoring
+struct PersistenceStats {
+    uint64_t commits;            // batches written
+    uint64_t records;            // journal records made durable
+    uint64_t snapshots;          // usage_data.txt rewrites
+    uint64_t failures;           // batches with an I/O error
+    double last_commit_seconds;  // duration of the latest batch
+    double max_commit_seconds;
+    double commit_seconds_total;
+    size_t queue_depth;          // records waiting for the next batch
+};
+
+// Write-behind persistence for DataManager. The owning thread only
+// queues: journal records, a snapshot to replace usage_data.txt, or a
+// whole small file. A writer thread commits the queue as one batch, with a
+// single fdatasync for all its journal records, once the oldest queued
+// record is commit_interval old; snapshots, files and stop() commit at
+// once. Snapshot text is rendered on the writer thread from the copy the
+// caller hands over.
+class UsageWriter {
+public:
+    // Snapshot file contents for the given generation
+    using Snapshot = std::function<std::string(uint64_t generation)>;
+
+    explicit UsageWriter(std::chrono::milliseconds commit_interval);
+    ~UsageWriter();
+    UsageWriter(const UsageWriter&) = delete;
+    UsageWriter& operator=(const UsageWriter&) = delete;
+
+    // Replay the journal at journal_path onto the snapshot of generation
+    // stored at snapshot_path (see UsageJournal::open). Call before start().
+    bool open(const std::string& snapshot_path, const std::string& journal_path, uint64_t generation,
+              const std::function<void(const usage_journal::Record&)>& apply);
+    bool tornTail() const { return journal_.tornTail(); }
+    void start();
+    // Commit everything queued, then end the thread
+    void stop();
+
+    void append(const usage_journal::Record* records, size_t count);
+    // Queued records are dropped; the snapshot already holds them
+    void snapshot(Snapshot render);
+    void writeFile(const std::string& path, std::string text);
+
+    // Journal records written or queued since the last snapshot
+    size_t journalRecords() const;
+    // The journal could not be kept consistent; a snapshot repairs it
+    bool snapshotWanted() const;
+    PersistenceStats stats() const;
+
+private:
+    void run();
+    // One batch, outside the lock; false on an I/O error
+    bool commit(Snapshot& render, std::vector<usage_journal::Record>& records,
+                std::vector<std::pair<std::string, std::string>>& files);
+
+    const std::chrono::milliseconds interval_;
+    UsageJournal journal_;      // writer thread only, once started
+    std::string snapshot_path_;
+    uint64_t generation_;       // writer thread only, once started
+
+    mutable std::mutex mutex_;  // guards everything below
+    std::condition_variable wake_;
+    std::vector<usage_journal::Record> queue_;
+    Snapshot pending_snapshot_;
+    std::vector<std::pair<std::string, std::string>> files_;
+    std::chrono::steady_clock::time_point oldest_;  // first record in queue_
+    size_t journal_records_;
+    bool snapshot_wanted_;
+    bool stopping_;
+    PersistenceStats stats_;
+    std::thread thread_;
+};
+
+// Commit interval from SPEED_METER_COMMIT_MS (0: commit every change);
+// fallback when unset or invalid
+std::chrono::milliseconds commitIntervalFromEnvironment(std::chrono::milliseconds fallback);
+
+#endif // USAGE_WRITER_H
@@ -4,7 +4,15 @@
 #include <string>
 #include <chrono>
 #include <memory>
+#include <vector>
 #include "data_manager.h"
+#include "interface_table.h"
+#include "meter_protocol.h"
+#include "metrics_snapshot.h"
+#include "process_traffic.h"
+#include "tcp_health.h"
+#include "nic_load.h"
+#include "rate_histogram.h"
 #include "speed_test_widget.h"
 
 class Window {
@@ -19,9 +27,30 @@ public:
     void exportToCSV();
     void exportToJSON();
     void setDataManager(DataManager* dm);
+    void updateInterfaceTable(const InterfaceRate& total, const std::vector<InterfaceRate>& top);
+    void updateSamplePeriod(int periodMs, bool idle);
+    // Packets/s, average packet size and drops/s; call after updateSpeeds()
+    void updatePacketRates(const MetricsSnapshot& snapshot);
+    // p50/p95/p99/max of the raw rates since the meter started
+    void updateSessionRates(const RateDigest& session);
+    void updateProcessTable(const std::vector<ProcessRate>& top);
+    // The TCP connections section is on screen, so the sampler should dump them
+    bool isTcpHealthVisible() const;
+    // Show a dump taken by the sampler; rows gets the previous one back
+    void updateTcpHealth(std::vector<TcpSocketInfo>& rows);
+    // The CPU & Queues tab is on screen, so the sampler should collect NIC load
+    bool isNicLoadVisible() const;
+    void updateNicLoad(const NicLoad& load);
+    // Today's and this month's usage as kept by speed-meterd, for a
+    // dashboard without a DataManager of its own; either may be null
+    void updateUsageHistory(const meter_protocol::HistoryRow* today, const meter_protocol::HistoryRow* month);
 
 private:
     void createSpeedSection(GtkWidget* parent);
+    void createTcpHealthTable(GtkWidget* parent);
+    // Fill the health table from the last dump, ranked by tcpSortKey_
+    void renderTcpHealth();
+    GtkWidget* createNicLoadTab();
     void createSessionStatsSection(GtkWidget* parent);
     void createInterfaceSection(GtkWidget* parent);
     void createMonthlyStatsSection(GtkWidget* parent);
@@ -32,26 +61,50 @@ private:
     void formatSpeed(std::stringstream& ss, double speed, const std::string& prefix);
     std::string formatSpeedSimple(double speed);
     std::string formatBytes(double bytes);
+    std::string formatPercentiles(const RateHistogram& rates);
+    // Same from a history row's p50/p95/p99 and its peak
+    std::string formatPercentiles(const double* percentiles, double peak);
 
     GtkWidget* window;
     GtkLabel* downloadLabel;
     GtkLabel* uploadLabel;
+    GtkLabel* packetsLabel;
     GtkLabel* totalLabel;
     GtkLabel* sessionTimeLabel;
     GtkLabel* avgSpeedLabel;
+    GtkLabel* sessionRatesLabel;
     GtkLabel* interfaceLabel;
     GtkLabel* ipLabel;
     GtkLabel* statusLabel;
+    GtkLabel* allInterfacesLabel;
+    GtkLabel* processesLabel;
+    GtkLabel* samplingLabel;
+    int shownSamplePeriodMs;
 
     // Progress bars for visual speed indication
     GtkWidget* downloadProgress_;
     GtkWidget* uploadProgress_;
 
+    // Per-connection TCP health, sorted by the column last clicked
+    std::unique_ptr<TcpHealthTable> tcpHealth_;
+    GtkListStore* tcpStore_;
+    GtkLabel* tcpSummaryLabel_;
+    TcpHealthTable::SortKey tcpSortKey_;
+
+    // CPU & Queues tab
+    GtkWidget* notebook_;
+    int nicLoadPage_;
+    GtkListStore* cpuLoadStore_;
+    GtkListStore* queueLoadStore_;
+    GtkLabel* nicLoadSummaryLabel_;
+
     // Monthly statistics labels
     GtkLabel* monthlyDownloadLabel;
     GtkLabel* monthlyUploadLabel;
     GtkLabel* monthlyPeakDownloadLabel;
     GtkLabel* monthlyPeakUploadLabel;
+    GtkLabel* dailyRatesLabel;
+    GtkLabel* monthlyRatesLabel;
     GtkLabel* dataUsageLabel;
     GtkLabel* dataLimitStatusLabel;
 
@@ -68,6 +121,10 @@ private:
         double uploadSpeed;
         double totalDownload;
         double totalUpload;
+        double rxPacketRate;
+        double txPacketRate;
+        double rxDropRate;
+        double txDropRate;
     };
     std::vector<UsageData> usageHistory;
 };
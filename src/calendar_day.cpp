@@ -0,0 +1,139 @@
+#include "../include/calendar_day.h"
+#include <cstdio>
+
+// Howard Hinnant's days_from_civil / civil_from_days
+int32_t calendar::daysFromCivil(int year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(year - era * 400);
+    const unsigned doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int32_t>(doe) - 719468;
+}
+
+void calendar::civilFromDays(int32_t days, int& year, unsigned& month, unsigned& day) {
+    const int32_t z = days + 719468;
+    const int era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    day = doy - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = static_cast<int>(yoe) + era * 400 + (month <= 2);
+}
+
+bool calendar::parseDate(const std::string& date, int32_t& days) {
+    int y = 0;
+    unsigned m = 0;
+    unsigned d = 0;
+    if (std::sscanf(date.c_str(), "%d-%u-%u", &y, &m, &d) != 3 || m < 1 || m > 12 || d < 1 || d > 31) {
+        return false;
+    }
+    // Reject days past the end of the month (2025-02-30) instead of rolling over
+    const int32_t parsed = daysFromCivil(y, m, d);
+    int check_y;
+    unsigned check_m;
+    unsigned check_d;
+    civilFromDays(parsed, check_y, check_m, check_d);
+    if (check_m != m || check_d != d) {
+        return false;
+    }
+    days = parsed;
+    return true;
+}
+
+bool calendar::parseMonth(const std::string& month, int32_t& first, int32_t& end) {
+    int y = 0;
+    unsigned m = 0;
+    if (std::sscanf(month.c_str(), "%d-%u", &y, &m) != 2 || m < 1 || m > 12) {
+        return false;
+    }
+    first = daysFromCivil(y, m, 1);
+    end = m == 12 ? daysFromCivil(y + 1, 1, 1) : daysFromCivil(y, m + 1, 1);
+    return true;
+}
+
+std::string calendar::formatDate(int32_t days) {
+    int y;
+    unsigned m;
+    unsigned d;
+    civilFromDays(days, y, m, d);
+    char text[32];
+    std::snprintf(text, sizeof(text), "%04d-%02u-%02u", y, m, d);
+    return text;
+}
+
+std::string calendar::formatMonth(int32_t days) {
+    int y;
+    unsigned m;
+    unsigned d;
+    civilFromDays(days, y, m, d);
+    char text[32];
+    std::snprintf(text, sizeof(text), "%04d-%02u", y, m);
+    return text;
+}
+
+int32_t calendar::firstOfMonth(int32_t days) {
+    int y;
+    unsigned m;
+    unsigned d;
+    civilFromDays(days, y, m, d);
+    return days - static_cast<int32_t>(d - 1);
+}
+
+int32_t calendar::firstOfNextMonth(int32_t days) {
+    int y;
+    unsigned m;
+    unsigned d;
+    civilFromDays(days, y, m, d);
+    return m == 12 ? daysFromCivil(y + 1, 1, 1) : daysFromCivil(y, m + 1, 1);
+}
+
+calendar::LocalToday::LocalToday() : day_(0), hour_(0), valid_from_(0), valid_until_(0) {
+}
+
+int32_t calendar::LocalToday::day() {
+    refresh();
+    return day_;
+}
+
+int calendar::LocalToday::hour() {
+    refresh();
+    return hour_;
+}
+
+void calendar::LocalToday::refresh() {
+    const std::time_t now = std::time(nullptr);
+    if (now >= valid_from_ && now < valid_until_) {
+        return;
+    }
+    std::tm local = std::tm();
+#ifdef _WIN32
+    localtime_s(&local, &now);
+#else
+    localtime_r(&now, &local);
+#endif
+    day_ = daysFromCivil(local.tm_year + 1900, static_cast<unsigned>(local.tm_mon + 1),
+                         static_cast<unsigned>(local.tm_mday));
+    hour_ = local.tm_hour;
+
+    // mktime normalizes hour 24 into the next day and finds the hour's
+    // start across a DST change
+    std::tm start = local;
+    start.tm_min = 0;
+    start.tm_sec = 0;
+    start.tm_isdst = -1;
+    valid_from_ = std::mktime(&start);
+    start = local;
+    start.tm_hour += 1;
+    start.tm_min = 0;
+    start.tm_sec = 0;
+    start.tm_isdst = -1;
+    valid_until_ = std::mktime(&start);
+    if (valid_from_ == static_cast<std::time_t>(-1) || valid_from_ > now || valid_until_ <= now) {
+        // No usable boundary; ask localtime again in a minute
+        valid_from_ = now;
+        valid_until_ = now + 60;
+    }
+}
@@ -0,0 +1,68 @@
+#include "../include/counter_backend.h"
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include "../include/netlink_stats.h"
+#endif
+
+ProcNetDevBackend::ProcNetDevBackend(const std::string& iface)
+    : iface_(iface) {
+}
+
+bool ProcNetDevBackend::setInterface(const std::string& iface) {
+    iface_ = iface;
+    return reader_.isOpen();
+}
+
+bool ProcNetDevBackend::read(NetStats& stats) {
+    return reader_.read(iface_, stats);
+}
+
+CounterSource parseCounterSource(const char* value, CounterSource fallback) {
+    if (!value) {
+        return fallback;
+    }
+    if (std::strcmp(value, "netlink") == 0) {
+        return CounterSource::Netlink;
+    }
+    if (std::strcmp(value, "procfs") == 0 || std::strcmp(value, "proc") == 0) {
+        return CounterSource::ProcNetDev;
+    }
+    return fallback;
+}
+
+CounterSource counterSourceFromEnvironment() {
+    return parseCounterSource(std::getenv("SPEED_METER_BACKEND"), CounterSource::Netlink);
+}
+
+std::unique_ptr<CounterBackend> createNetlinkBackend(const std::string& iface) {
+#ifdef __linux__
+    NetlinkStatsBackend* netlink = new NetlinkStatsBackend();
+    std::unique_ptr<CounterBackend> backend(netlink);
+    if (!netlink->isOpen() || !netlink->setInterface(iface)) {
+        return nullptr;
+    }
+    // Probe once so a kernel or sandbox that refuses RTM_GETLINK is caught
+    // here rather than on every tick
+    NetStats probe;
+    if (!backend->read(probe)) {
+        return nullptr;
+    }
+    return backend;
+#else
+    (void)iface;
+    return nullptr;
+#endif
+}
+
+std::unique_ptr<CounterBackend> openCounterBackend(CounterSource preferred,
+                                                   const std::string& iface) {
+    if (preferred == CounterSource::Netlink) {
+        std::unique_ptr<CounterBackend> backend = createNetlinkBackend(iface);
+        if (backend) {
+            return backend;
+        }
+    }
+    return std::unique_ptr<CounterBackend>(new ProcNetDevBackend(iface));
+}
@@ -5,6 +5,14 @@
 #include <QJsonObject>
 #include <QJsonArray>
 
+namespace {
+
+double averagePacketSize(double bytesPerSecond, double packetsPerSecond) {
+    return packetsPerSecond > 0.0 ? bytesPerSecond / packetsPerSecond : 0.0;
+}
+
+} // namespace
+
 bool DataExporter::exportToCSV(const QString& filename, const QVector<UsageRecord>& records) {
     QFile file(filename);
     if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
@@ -34,7 +42,9 @@ QString DataExporter::formatCSV(const QVector<UsageRecord>& records) {
     QTextStream out(&csv);
     
     // Header
-    out << "Timestamp,Download Speed (MB/s),Upload Speed (MB/s),Total Download (MB),Total Upload (MB)\n";
+    out << "Timestamp,Download Speed (MB/s),Upload Speed (MB/s),Total Download (MB),Total Upload (MB),"
+           "Download Packets/s,Upload Packets/s,Avg Download Packet (B),Avg Upload Packet (B),"
+           "Download Drops/s,Upload Drops/s\n";
     
     // Data rows
     for (const auto& record : records) {
@@ -42,7 +52,13 @@ QString DataExporter::formatCSV(const QVector<UsageRecord>& records) {
             << QString::number(record.downloadSpeed / (1024.0 * 1024.0), 'f', 3) << ","
             << QString::number(record.uploadSpeed / (1024.0 * 1024.0), 'f', 3) << ","
             << QString::number(record.totalDownload / (1024.0 * 1024.0), 'f', 2) << ","
-            << QString::number(record.totalUpload / (1024.0 * 1024.0), 'f', 2) << "\n";
+            << QString::number(record.totalUpload / (1024.0 * 1024.0), 'f', 2) << ","
+            << QString::number(record.downloadPacketRate, 'f', 1) << ","
+            << QString::number(record.uploadPacketRate, 'f', 1) << ","
+            << QString::number(averagePacketSize(record.downloadSpeed, record.downloadPacketRate), 'f', 1) << ","
+            << QString::number(averagePacketSize(record.uploadSpeed, record.uploadPacketRate), 'f', 1) << ","
+            << QString::number(record.downloadDropRate, 'f', 2) << ","
+            << QString::number(record.uploadDropRate, 'f', 2) << "\n";
     }
     
     return csv;
@@ -59,6 +75,12 @@ QString DataExporter::formatJSON(const QVector<UsageRecord>& records) {
         recordObj["uploadSpeedMBps"] = record.uploadSpeed / (1024.0 * 1024.0);
         recordObj["totalDownloadMB"] = record.totalDownload / (1024.0 * 1024.0);
         recordObj["totalUploadMB"] = record.totalUpload / (1024.0 * 1024.0);
+        recordObj["downloadPacketsPerSec"] = record.downloadPacketRate;
+        recordObj["uploadPacketsPerSec"] = record.uploadPacketRate;
+        recordObj["avgDownloadPacketBytes"] = averagePacketSize(record.downloadSpeed, record.downloadPacketRate);
+        recordObj["avgUploadPacketBytes"] = averagePacketSize(record.uploadSpeed, record.uploadPacketRate);
+        recordObj["downloadDropsPerSec"] = record.downloadDropRate;
+        recordObj["uploadDropsPerSec"] = record.uploadDropRate;
         dataArray.append(recordObj);
     }
     
@@ -1,8 +1,11 @@
 #include "../include/data_manager.h"
+#include "../include/logger.h"
 #include <iostream>
 #include <algorithm>
+#include <cstdio>
 #include <ctime>
-#include <set>
+#include <iterator>
+#include <sys/stat.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -10,23 +13,146 @@
 #include <direct.h>
 #define mkdir _mkdir
 #else
-#include <sys/stat.h>
 #include <unistd.h>
 #endif
 
+namespace {
+
+DailyStats emptyDay(const std::string& date) {
+    DailyStats stats = DailyStats();
+    stats.date = date;
+    return stats;
+}
+
+// Optional trailing column of a usage_data.txt line; lines written before
+// the packet columns existed simply end early
+uint64_t nextCount(std::istringstream& iss) {
+    std::string token;
+    if (!std::getline(iss, token, ',') || token.empty()) return 0;
+    return std::stoull(token);
+}
+
+double nextRate(std::istringstream& iss) {
+    std::string token;
+    if (!std::getline(iss, token, ',') || token.empty()) return 0.0;
+    return std::stod(token);
+}
+
+double averageSize(uint64_t bytes, uint64_t packets) {
+    return packets ? static_cast<double>(bytes) / packets : 0.0;
+}
+
+double percentOf(uint64_t part, uint64_t whole) {
+    return whole ? 100.0 * static_cast<double>(part) / whole : 0.0;
+}
+
+// Journal counters are 32-bit; a one-minute delta never comes close
+uint32_t saturate32(uint64_t value) {
+    return static_cast<uint32_t>(std::min<uint64_t>(value, UINT32_MAX));
+}
+
+// Rate digest column; empty or unreadable columns leave the digest empty
+void nextDigest(std::istringstream& iss, RateHistogram& histogram) {
+    std::string token;
+    if (!std::getline(iss, token, ',') || !histogram.decode(token)) {
+        histogram.clear();
+    }
+}
+
+// Hourly column: "hour:download:upload" for each hour with traffic,
+// space-separated
+void encodeHours(std::ostream& out, const std::vector<ByteTotals>& hours, size_t first) {
+    bool any = false;
+    for (size_t h = 0; h < 24 && first + h < hours.size(); ++h) {
+        const ByteTotals& bytes = hours[first + h];
+        if (bytes.download_bytes == 0 && bytes.upload_bytes == 0) continue;
+        if (any) out << ' ';
+        out << h << ':' << bytes.download_bytes << ':' << bytes.upload_bytes;
+        any = true;
+    }
+}
+
+// Lines written before the hourly column have no hours
+template <typename Store>
+void nextHours(std::istringstream& iss, Store store) {
+    std::string column;
+    if (!std::getline(iss, column, ',')) return;
+    std::istringstream entries(column);
+    std::string entry;
+    while (entries >> entry) {
+        unsigned hour = 0;
+        unsigned long long down = 0;
+        unsigned long long up = 0;
+        if (std::sscanf(entry.c_str(), "%u:%llu:%llu", &hour, &down, &up) == 3 && hour < 24) {
+            ByteTotals bytes = ByteTotals();
+            bytes.download_bytes = down;
+            bytes.upload_bytes = up;
+            store(hour, bytes);
+        }
+    }
+}
+
+constexpr std::chrono::milliseconds kDefaultCommitInterval(10000);
+
+// usage_data.txt contents; older readers parse only the number before the
+// comma on the first line
+std::string formatSnapshot(const std::vector<DailyStats>& days, const std::vector<ByteTotals>& hours,
+                           int32_t first_day, uint64_t limit, uint64_t generation) {
+    std::ostringstream file;
+    file << limit << "," << generation << "\n";
+    for (const auto& stats : days) {
+        file << stats.date << ","
+             << stats.total_download_bytes << ","
+             << stats.total_upload_bytes << ","
+             << stats.peak_download_speed << ","
+             << stats.peak_upload_speed << ","
+             << stats.session_count << ","
+             << stats.total_session_time.count() << ","
+             << stats.total_download_packets << ","
+             << stats.total_upload_packets << ","
+             << stats.download_dropped << ","
+             << stats.upload_dropped << ","
+             << stats.download_errors << ","
+             << stats.upload_errors << ","
+             << stats.peak_download_packet_rate << ","
+             << stats.peak_upload_packet_rate << ","
+             << stats.rates.download.encode() << ","
+             << stats.rates.upload.encode() << ",";
+        int32_t day;
+        if (calendar::parseDate(stats.date, day) && day >= first_day) {
+            encodeHours(file, hours, static_cast<size_t>(day - first_day) * 24);
+        }
+        file << "\n";
+    }
+    return file.str();
+}
+
+} // namespace
+
 DataManager::DataManager(const std::string& data_dir)
-    : monthly_data_limit(0) {
+    : first_day(0),
+      monthly_data_limit(0),
+      last_speed_test(),
+      has_speed_test(false),
+      speed_test_mtime(-1),
+      writer(commitIntervalFromEnvironment(kDefaultCommitInterval)) {
 #ifdef _WIN32
     data_file_path = expandPath(data_dir) + "\\usage_data.txt";
+    speed_test_file_path = expandPath(data_dir) + "\\last_speed_test.txt";
+    journal_file_path = expandPath(data_dir) + "\\usage_journal.bin";
 #else
     data_file_path = expandPath(data_dir) + "/usage_data.txt";
+    speed_test_file_path = expandPath(data_dir) + "/last_speed_test.txt";
+    journal_file_path = expandPath(data_dir) + "/usage_journal.bin";
 #endif
     ensureDataDirectory();
     loadData();
+    writer.start();
 }
 
 DataManager::~DataManager() {
     saveData();
+    writer.stop();
 }
 
 std::string DataManager::expandPath(const std::string& path) const {
@@ -75,89 +201,316 @@ void DataManager::ensureDataDirectory() {
 #endif
 }
 
-std::string DataManager::getCurrentDate() const {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    std::tm* tm = std::localtime(&time_t);
+void DataManager::updateDailyStats(uint64_t download_bytes, uint64_t upload_bytes,
+                                  double current_download_speed, double current_upload_speed,
+                                  std::chrono::seconds session_time,
+                                  const PacketActivity& packets) {
+    using namespace usage_journal;
+    Record record = makeRecord(RecordType::Usage, today.day());
+    record.hour = static_cast<uint8_t>(today.hour());
+    record.session_seconds = static_cast<uint32_t>(std::max<long long>(0, session_time.count()));
+    record.usage.download_bytes = download_bytes;
+    record.usage.upload_bytes = upload_bytes;
+    record.usage.download_packets = packets.download_packets;
+    record.usage.upload_packets = packets.upload_packets;
+    record.usage.download_dropped = saturate32(packets.download_dropped);
+    record.usage.upload_dropped = saturate32(packets.upload_dropped);
+    record.usage.download_errors = saturate32(packets.download_errors);
+    record.usage.upload_errors = saturate32(packets.upload_errors);
+    record.usage.download_speed = current_download_speed;
+    record.usage.upload_speed = current_upload_speed;
+    record.usage.download_packet_rate = packets.download_packet_rate;
+    record.usage.upload_packet_rate = packets.upload_packet_rate;
+    apply(record);
+    seal(record);
+    pending_records.push_back(record);
+    commit();
+}
 
-    std::ostringstream oss;
-    oss << std::put_time(tm, "%Y-%m-%d");
-    return oss.str();
+void DataManager::recordRates(const RateDigest& samples) {
+    const int32_t day = today.day();
+    appendRates(day, samples.download, false);
+    appendRates(day, samples.upload, true);
 }
 
-std::string DataManager::getCurrentMonth() const {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    std::tm* tm = std::localtime(&time_t);
+// The histogram's non-empty buckets as rate records of up to kRateBuckets
+// buckets each, applied now and queued for the next commit
+void DataManager::appendRates(int32_t day, const RateHistogram& histogram, bool upload) {
+    using namespace usage_journal;
+    if (histogram.count() == 0) {
+        return;
+    }
+    Record record = makeRecord(RecordType::Rates, day);
+    auto flush = [&]() {
+        apply(record);
+        seal(record);
+        pending_records.push_back(record);
+        record = makeRecord(RecordType::Rates, day);
+    };
+    for (size_t i = 0; i < RateHistogram::kBuckets; ++i) {
+        const uint32_t count = histogram.bucketCount(i);
+        if (count == 0) continue;
+        if (record.rates.used == kRateBuckets) {
+            flush();
+        }
+        record.rates.max = histogram.max();
+        record.rates.upload = upload ? 1 : 0;
+        RateBucket& bucket = record.rates.buckets[record.rates.used++];
+        bucket.index = static_cast<uint16_t>(i);
+        bucket.count = count;
+    }
+    flush();
+}
+
+DataManager::DayTotals* DataManager::dayAt(int32_t day) {
+    if (days.empty()) {
+        first_day = day;
+    }
+    if (day < first_day) {
+        const int32_t grow = first_day - day;
+        if (static_cast<int64_t>(days.size()) + grow > kMaxSpanDays) {
+            return nullptr;
+        }
+        days.insert(days.begin(), static_cast<size_t>(grow), DayTotals());
+        std::vector<std::unique_ptr<RateDigest>> front(static_cast<size_t>(grow));
+        day_rates.insert(day_rates.begin(), std::make_move_iterator(front.begin()),
+                         std::make_move_iterator(front.end()));
+        day_index.prepend(static_cast<size_t>(grow));
+        hour_index.prepend(static_cast<size_t>(grow) * kHoursPerDay);
+        first_day = day;
+    }
+    const size_t index = static_cast<size_t>(day - first_day);
+    if (index >= days.size()) {
+        if (index >= static_cast<size_t>(kMaxSpanDays)) {
+            return nullptr;
+        }
+        days.resize(index + 1, DayTotals());
+        day_rates.resize(index + 1);
+        day_index.resize(index + 1);
+        hour_index.resize((index + 1) * kHoursPerDay);
+    }
+    DayTotals& slot = days[index];
+    slot.stored = true;
+    return &slot;
+}
 
-    std::ostringstream oss;
-    oss << std::put_time(tm, "%Y-%m");
-    return oss.str();
+RateDigest* DataManager::ratesAt(int32_t day) {
+    if (!dayAt(day)) {
+        return nullptr;
+    }
+    std::unique_ptr<RateDigest>& rates = day_rates[static_cast<size_t>(day - first_day)];
+    if (!rates) {
+        rates.reset(new RateDigest());
+    }
+    return rates.get();
 }
 
-void DataManager::updateDailyStats(uint64_t download_bytes, uint64_t upload_bytes,
-                                  double current_download_speed, double current_upload_speed,
-                                  std::chrono::seconds session_time) {
-    std::string today = getCurrentDate();
+void DataManager::clearDay(int32_t day) {
+    if (day < first_day || day - first_day >= static_cast<int32_t>(days.size())) {
+        return;
+    }
+    const size_t index = static_cast<size_t>(day - first_day);
+    days[index] = DayTotals();
+    day_rates[index].reset();
+    day_index.set(index, ByteTotals());
+    for (size_t hour = 0; hour < kHoursPerDay; ++hour) {
+        hour_index.set(index * kHoursPerDay + hour, ByteTotals());
+    }
+}
 
-    if (daily_stats.find(today) == daily_stats.end()) {
-        daily_stats[today] = DailyStats{today, 0, 0, 0.0, 0.0, 0, std::chrono::seconds(0)};
+ByteTotals DataManager::usageDays(int32_t from, int32_t to) const {
+    from = std::max(from, first_day);
+    if (to <= from) {
+        return ByteTotals();
     }
+    return day_index.sum(static_cast<size_t>(from - first_day), static_cast<size_t>(to - first_day));
+}
 
-    auto& stats = daily_stats[today];
-    stats.total_download_bytes += download_bytes;
-    stats.total_upload_bytes += upload_bytes;
-    stats.peak_download_speed = std::max(stats.peak_download_speed, current_download_speed);
-    stats.peak_upload_speed = std::max(stats.peak_upload_speed, current_upload_speed);
-    stats.session_count++;
-    stats.total_session_time += session_time;
+ByteTotals DataManager::usageHours(int64_t from, int64_t to) const {
+    const int64_t base = static_cast<int64_t>(first_day) * static_cast<int64_t>(kHoursPerDay);
+    from = std::max(from, base);
+    if (to <= from) {
+        return ByteTotals();
+    }
+    return hour_index.sum(static_cast<size_t>(from - base), static_cast<size_t>(to - base));
+}
 
-    saveData();
+DailyStats DataManager::dailyStats(size_t index) const {
+    DailyStats stats = emptyDay(calendar::formatDate(first_day + static_cast<int32_t>(index)));
+    if (index >= days.size() || !days[index].stored) {
+        return stats;
+    }
+    const DayTotals& day = days[index];
+    stats.total_download_bytes = day.download_bytes;
+    stats.total_upload_bytes = day.upload_bytes;
+    stats.peak_download_speed = day.peak_download_speed;
+    stats.peak_upload_speed = day.peak_upload_speed;
+    stats.session_count = day.session_count;
+    stats.total_session_time = std::chrono::seconds(day.session_seconds);
+    stats.total_download_packets = day.download_packets;
+    stats.total_upload_packets = day.upload_packets;
+    stats.download_dropped = day.download_dropped;
+    stats.upload_dropped = day.upload_dropped;
+    stats.download_errors = day.download_errors;
+    stats.upload_errors = day.upload_errors;
+    stats.peak_download_packet_rate = day.peak_download_packet_rate;
+    stats.peak_upload_packet_rate = day.peak_upload_packet_rate;
+    if (day_rates[index]) {
+        stats.rates = *day_rates[index];
+    }
+    return stats;
+}
+
+std::vector<DailyStats> DataManager::storedDays() const {
+    std::vector<DailyStats> result;
+    for (size_t i = 0; i < days.size(); ++i) {
+        if (days[i].stored) {
+            result.push_back(dailyStats(i));
+        }
+    }
+    return result;
+}
+
+void DataManager::apply(const usage_journal::Record& record) {
+    using namespace usage_journal;
+    switch (static_cast<RecordType>(record.type)) {
+    case RecordType::Usage: {
+        DayTotals* day = dayAt(record.day);
+        if (!day) break;
+        const UsageDelta& u = record.usage;
+        const size_t index = static_cast<size_t>(record.day - first_day);
+        day_index.add(index, u.download_bytes, u.upload_bytes);
+        hour_index.add(index * kHoursPerDay + std::min<size_t>(record.hour, kHoursPerDay - 1),
+                       u.download_bytes, u.upload_bytes);
+        day->download_bytes += u.download_bytes;
+        day->upload_bytes += u.upload_bytes;
+        day->peak_download_speed = std::max(day->peak_download_speed, u.download_speed);
+        day->peak_upload_speed = std::max(day->peak_upload_speed, u.upload_speed);
+        day->session_count++;
+        day->session_seconds += record.session_seconds;
+        day->download_packets += u.download_packets;
+        day->upload_packets += u.upload_packets;
+        day->download_dropped += u.download_dropped;
+        day->upload_dropped += u.upload_dropped;
+        day->download_errors += u.download_errors;
+        day->upload_errors += u.upload_errors;
+        day->peak_download_packet_rate = std::max(day->peak_download_packet_rate, u.download_packet_rate);
+        day->peak_upload_packet_rate = std::max(day->peak_upload_packet_rate, u.upload_packet_rate);
+        break;
+    }
+    case RecordType::Rates: {
+        RateDigest* rates = ratesAt(record.day);
+        if (!rates) break;
+        DayTotals& day = days[static_cast<size_t>(record.day - first_day)];
+        const RateRun& run = record.rates;
+        RateHistogram& histogram = run.upload ? rates->upload : rates->download;
+        for (size_t i = 0; i < run.used && i < kRateBuckets; ++i) {
+            histogram.addToBucket(run.buckets[i].index, run.buckets[i].count, run.max);
+        }
+        double& peak = run.upload ? day.peak_upload_speed : day.peak_download_speed;
+        peak = std::max(peak, run.max);
+        break;
+    }
+    case RecordType::DataLimit:
+        monthly_data_limit = record.limit_bytes;
+        break;
+    case RecordType::ResetMonth: {
+        const int32_t end = calendar::firstOfNextMonth(record.day);
+        for (int32_t day = calendar::firstOfMonth(record.day); day < end; ++day) {
+            clearDay(day);
+        }
+        break;
+    }
+    }
+}
+
+void DataManager::commit() {
+    writer.append(pending_records.data(), pending_records.size());
+    pending_records.clear();
+    // After a failed write the journal may end in a partial record; a full
+    // snapshot keeps everything and starts a clean journal
+    if (writer.snapshotWanted() || writer.journalRecords() >= kCompactAfterRecords) {
+        saveData();
+    }
+}
+
+PersistenceStats DataManager::getPersistenceStats() const {
+    return writer.stats();
 }
 
 DailyStats DataManager::getTodayStats() const {
-    std::string today = getCurrentDate();
-    auto it = daily_stats.find(today);
-    if (it != daily_stats.end()) {
-        return it->second;
+    const int32_t day = today.day();
+    if (day < first_day) {
+        return emptyDay(calendar::formatDate(day));
     }
-    return DailyStats{today, 0, 0, 0.0, 0.0, 0, std::chrono::seconds(0)};
+    return dailyStats(static_cast<size_t>(day - first_day));
 }
 
 DailyStats DataManager::getDailyStats(const std::string& date) const {
-    auto it = daily_stats.find(date);
-    if (it != daily_stats.end()) {
-        return it->second;
+    int32_t day;
+    if (!calendar::parseDate(date, day)) {
+        return emptyDay(date);
+    }
+    if (day < first_day) {
+        return emptyDay(calendar::formatDate(day));
     }
-    return DailyStats{date, 0, 0, 0.0, 0.0, 0, std::chrono::seconds(0)};
+    return dailyStats(static_cast<size_t>(day - first_day));
 }
 
 std::vector<DailyStats> DataManager::getDailyStatsRange(const std::string& start_date,
                                                        const std::string& end_date) const {
-    std::vector<DailyStats> result;
+    // Bounds compare as text, as they always have ("" and "9999" are open
+    // ends); date text grows with the day number, so a binary search over
+    // the index finds them
+    auto firstIndex = [this](const std::string& bound, bool inclusive) {
+        size_t lo = 0;
+        size_t hi = days.size();
+        while (lo < hi) {
+            const size_t mid = lo + (hi - lo) / 2;
+            const std::string date = calendar::formatDate(first_day + static_cast<int32_t>(mid));
+            if (inclusive ? date < bound : date <= bound) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    };
 
-    for (const auto& pair : daily_stats) {
-        if (pair.first >= start_date && pair.first <= end_date) {
-            result.push_back(pair.second);
+    std::vector<DailyStats> result;
+    const size_t end = firstIndex(end_date, false);
+    for (size_t i = firstIndex(start_date, true); i < end; ++i) {
+        if (days[i].stored) {
+            result.push_back(dailyStats(i));
         }
     }
-
-    std::sort(result.begin(), result.end(),
-              [](const DailyStats& a, const DailyStats& b) { return a.date < b.date; });
-
     return result;
 }
 
-MonthlyStats DataManager::getMonthlyStats(const std::string& month) const {
-    MonthlyStats stats{month, 0, 0, 0.0, 0.0, 0.0, 0.0, 0};
-
-    for (const auto& pair : daily_stats) {
-        if (pair.first.substr(0, 7) == month) {
-            stats.total_download_bytes += pair.second.total_download_bytes;
-            stats.total_upload_bytes += pair.second.total_upload_bytes;
-            stats.peak_download_speed = std::max(stats.peak_download_speed, pair.second.peak_download_speed);
-            stats.peak_upload_speed = std::max(stats.peak_upload_speed, pair.second.peak_upload_speed);
-            stats.active_days++;
+MonthlyStats DataManager::monthStats(int32_t first, int32_t end) const {
+    MonthlyStats stats = MonthlyStats();
+    stats.month = calendar::formatMonth(first);
+
+    const int32_t last = first_day + static_cast<int32_t>(days.size());
+    for (int32_t d = std::max(first, first_day); d < std::min(end, last); ++d) {
+        const size_t index = static_cast<size_t>(d - first_day);
+        const DayTotals& day = days[index];
+        if (!day.stored) continue;
+        stats.total_download_bytes += day.download_bytes;
+        stats.total_upload_bytes += day.upload_bytes;
+        stats.peak_download_speed = std::max(stats.peak_download_speed, day.peak_download_speed);
+        stats.peak_upload_speed = std::max(stats.peak_upload_speed, day.peak_upload_speed);
+        stats.active_days++;
+        stats.total_download_packets += day.download_packets;
+        stats.total_upload_packets += day.upload_packets;
+        stats.download_dropped += day.download_dropped;
+        stats.upload_dropped += day.upload_dropped;
+        stats.download_errors += day.download_errors;
+        stats.upload_errors += day.upload_errors;
+        stats.peak_download_packet_rate = std::max(stats.peak_download_packet_rate, day.peak_download_packet_rate);
+        stats.peak_upload_packet_rate = std::max(stats.peak_upload_packet_rate, day.peak_upload_packet_rate);
+        if (day_rates[index]) {
+            stats.rates.merge(*day_rates[index]);
         }
     }
 
@@ -169,35 +522,53 @@ MonthlyStats DataManager::getMonthlyStats(const std::string& month) const {
     return stats;
 }
 
+MonthlyStats DataManager::getMonthlyStats(const std::string& month) const {
+    int32_t first;
+    int32_t end;
+    if (!calendar::parseMonth(month, first, end)) {
+        MonthlyStats stats = MonthlyStats();
+        stats.month = month;
+        return stats;
+    }
+    return monthStats(first, end);
+}
+
 MonthlyStats DataManager::getCurrentMonthStats() const {
-    return getMonthlyStats(getCurrentMonth());
+    const int32_t day = today.day();
+    return monthStats(calendar::firstOfMonth(day), calendar::firstOfNextMonth(day));
 }
 
 std::vector<MonthlyStats> DataManager::getMonthlyStatsRange(const std::string& start_month,
                                                            const std::string& end_month) const {
     std::vector<MonthlyStats> result;
-    std::set<std::string> months;
-
-    // Collect unique months
-    for (const auto& pair : daily_stats) {
-        months.insert(pair.first.substr(0, 7));
+    if (days.empty()) {
+        return result;
     }
 
-    for (const auto& month : months) {
+    const int32_t last = first_day + static_cast<int32_t>(days.size());
+    for (int32_t first = calendar::firstOfMonth(first_day); first < last; ) {
+        const int32_t end = calendar::firstOfNextMonth(first);
+        const std::string month = calendar::formatMonth(first);
         if (month >= start_month && month <= end_month) {
-            result.push_back(getMonthlyStats(month));
+            MonthlyStats stats = monthStats(first, end);
+            if (stats.active_days > 0) {
+                result.push_back(stats);
+            }
         }
+        first = end;
     }
 
-    std::sort(result.begin(), result.end(),
-              [](const MonthlyStats& a, const MonthlyStats& b) { return a.month < b.month; });
-
     return result;
 }
 
 void DataManager::setDataLimit(uint64_t monthly_limit_bytes) {
-    monthly_data_limit = monthly_limit_bytes;
-    saveData();
+    using namespace usage_journal;
+    Record record = makeRecord(RecordType::DataLimit, today.day());
+    record.limit_bytes = monthly_limit_bytes;
+    apply(record);
+    seal(record);
+    pending_records.push_back(record);
+    commit();
 }
 
 uint64_t DataManager::getDataLimit() const {
@@ -207,63 +578,145 @@ uint64_t DataManager::getDataLimit() const {
 double DataManager::getDataUsagePercentage() const {
     if (monthly_data_limit == 0) return 0.0;
 
-    MonthlyStats current = getCurrentMonthStats();
-    uint64_t total_usage = current.total_download_bytes + current.total_upload_bytes;
+    const int32_t day = today.day();
+    uint64_t total_usage = usageDays(calendar::firstOfMonth(day), calendar::firstOfNextMonth(day)).total();
     return (static_cast<double>(total_usage) / monthly_data_limit) * 100.0;
 }
 
 bool DataManager::isDataLimitExceeded() const {
     if (monthly_data_limit == 0) return false;
 
-    MonthlyStats current = getCurrentMonthStats();
-    uint64_t total_usage = current.total_download_bytes + current.total_upload_bytes;
+    const int32_t day = today.day();
+    uint64_t total_usage = usageDays(calendar::firstOfMonth(day), calendar::firstOfNextMonth(day)).total();
     return total_usage > monthly_data_limit;
 }
 
-void DataManager::saveData() {
-    std::ofstream file(data_file_path);
-    if (!file.is_open()) {
-        std::cerr << "Error opening data file for writing: " << data_file_path << std::endl;
-        return;
+ByteTotals DataManager::getUsage(const std::string& from_date, const std::string& to_date) const {
+    int32_t from;
+    int32_t to;
+    if (!calendar::parseDate(from_date, from) || !calendar::parseDate(to_date, to)) {
+        return ByteTotals();
     }
+    return usageDays(from, to);
+}
 
-    file << monthly_data_limit << std::endl;
+ByteTotals DataManager::getUsageLastDays(uint32_t count) const {
+    const int32_t end = today.day() + 1;
+    return usageDays(end - static_cast<int32_t>(std::min(count, static_cast<uint32_t>(kMaxSpanDays))), end);
+}
 
-    for (const auto& pair : daily_stats) {
-        const auto& stats = pair.second;
-        file << stats.date << ","
-             << stats.total_download_bytes << ","
-             << stats.total_upload_bytes << ","
-             << stats.peak_download_speed << ","
-             << stats.peak_upload_speed << ","
-             << stats.session_count << ","
-             << stats.total_session_time.count() << std::endl;
+ByteTotals DataManager::getUsageLastHours(uint32_t count) const {
+    const int64_t end = static_cast<int64_t>(today.day()) * static_cast<int64_t>(kHoursPerDay) + today.hour() + 1;
+    return usageHours(end - static_cast<int64_t>(count), end);
+}
+
+ByteTotals DataManager::getBillingCycleUsage(unsigned start_day) const {
+    const int32_t day = today.day();
+    // Start day of this month's cycle, or last month's if it is still ahead
+    auto cycleStart = [start_day](int32_t month_first) {
+        const int32_t length = calendar::firstOfNextMonth(month_first) - month_first;
+        const int32_t offset = std::min(std::max<int32_t>(static_cast<int32_t>(start_day), 1), length) - 1;
+        return month_first + offset;
+    };
+    int32_t start = cycleStart(calendar::firstOfMonth(day));
+    if (start > day) {
+        start = cycleStart(calendar::firstOfMonth(calendar::firstOfMonth(day) - 1));
     }
+    return usageDays(start, day + 1);
+}
+
+void DataManager::recordSpeedTest(const SpeedTestRecord& record) {
+    std::ostringstream file;
+    file << record.unix_time << ","
+         << record.download_mbps << ","
+         << record.upload_mbps << ","
+         << record.ping_ms << ","
+         << record.jitter_ms << ","
+         << record.server << "\n";
+    writer.writeFile(speed_test_file_path, file.str());
+    last_speed_test = record;
+    has_speed_test = true;
+}
+
+bool DataManager::getLastSpeedTest(SpeedTestRecord& record) const {
+    struct stat st;
+    const int64_t mtime = ::stat(speed_test_file_path.c_str(), &st) == 0 ? static_cast<int64_t>(st.st_mtime) : -1;
+    if (mtime != speed_test_mtime) {
+        speed_test_mtime = mtime;
+        std::ifstream file(speed_test_file_path);
+        std::string line;
+        if (file.is_open() && std::getline(file, line)) {
+            std::istringstream iss(line);
+            std::string token;
+            SpeedTestRecord loaded = SpeedTestRecord();
+            try {
+                std::getline(iss, token, ',');
+                loaded.unix_time = std::stoll(token);
+                loaded.download_mbps = nextRate(iss);
+                loaded.upload_mbps = nextRate(iss);
+                loaded.ping_ms = nextRate(iss);
+                loaded.jitter_ms = nextRate(iss);
+                std::getline(iss, loaded.server);
+                last_speed_test = loaded;
+                has_speed_test = true;
+            } catch (const std::exception&) {
+                // keep what was loaded before
+            }
+        }
+    }
+    if (has_speed_test) {
+        record = last_speed_test;
+    }
+    return has_speed_test;
+}
+
+void DataManager::saveData() {
+    // Rate records not queued yet are already in the history
+    pending_records.clear();
+    // The writer renders its own copy, so this thread never formats or
+    // waits for the file
+    writer.snapshot([rows = storedDays(), hours = hour_index.values(), first = first_day,
+                     limit = monthly_data_limit](uint64_t generation) {
+        return formatSnapshot(rows, hours, first, limit, generation);
+    });
 }
 
 void DataManager::loadData() {
     std::ifstream file(data_file_path);
     if (!file.is_open()) {
         std::cout << "Data file not found, starting with empty statistics" << std::endl;
+        // Replays a journal written before the first snapshot
+        openJournal(0);
         return;
     }
 
     std::string line;
+    uint64_t generation = 0;
 
-    // Read data limit
+    // Read data limit and snapshot generation ("limit,generation"; files
+    // written before the journal hold only the limit, generation 0)
     if (std::getline(file, line)) {
         try {
             monthly_data_limit = std::stoull(line);
         } catch (const std::exception&) {
             monthly_data_limit = 0;
         }
+        const size_t comma = line.find(',');
+        if (comma != std::string::npos) {
+            try {
+                generation = std::stoull(line.substr(comma + 1));
+            } catch (const std::exception&) {
+                generation = 0;
+            }
+        }
     }
 
     // Read daily statistics
+    size_t loaded = 0;
     while (std::getline(file, line)) {
         std::istringstream iss(line);
         std::string token;
-        DailyStats stats;
+        DailyStats stats = DailyStats();
 
         if (std::getline(iss, stats.date, ',')) {
             std::getline(iss, token, ',');
@@ -278,26 +731,75 @@ void DataManager::loadData() {
             stats.session_count = std::stoull(token);
             std::getline(iss, token, ',');
             stats.total_session_time = std::chrono::seconds(std::stoll(token));
-
-            daily_stats[stats.date] = stats;
+            stats.total_download_packets = nextCount(iss);
+            stats.total_upload_packets = nextCount(iss);
+            stats.download_dropped = nextCount(iss);
+            stats.upload_dropped = nextCount(iss);
+            stats.download_errors = nextCount(iss);
+            stats.upload_errors = nextCount(iss);
+            stats.peak_download_packet_rate = nextRate(iss);
+            stats.peak_upload_packet_rate = nextRate(iss);
+            nextDigest(iss, stats.rates.download);
+            nextDigest(iss, stats.rates.upload);
+
+            int32_t number;
+            DayTotals* day = calendar::parseDate(stats.date, number) ? dayAt(number) : nullptr;
+            if (!day) continue;
+            day->download_bytes = stats.total_download_bytes;
+            day->upload_bytes = stats.total_upload_bytes;
+            day->peak_download_speed = stats.peak_download_speed;
+            day->peak_upload_speed = stats.peak_upload_speed;
+            day->session_count = stats.session_count;
+            day->session_seconds = stats.total_session_time.count();
+            day->download_packets = stats.total_download_packets;
+            day->upload_packets = stats.total_upload_packets;
+            day->download_dropped = stats.download_dropped;
+            day->upload_dropped = stats.upload_dropped;
+            day->download_errors = stats.download_errors;
+            day->upload_errors = stats.upload_errors;
+            day->peak_download_packet_rate = stats.peak_download_packet_rate;
+            day->peak_upload_packet_rate = stats.peak_upload_packet_rate;
+            if (stats.rates.download.count() > 0 || stats.rates.upload.count() > 0) {
+                *ratesAt(number) = stats.rates;
+            }
+            const size_t index = static_cast<size_t>(number - first_day);
+            ByteTotals bytes = ByteTotals();
+            bytes.download_bytes = day->download_bytes;
+            bytes.upload_bytes = day->upload_bytes;
+            day_index.set(index, bytes);
+            nextHours(iss, [this, index](unsigned hour, const ByteTotals& hourBytes) {
+                hour_index.set(index * kHoursPerDay + hour, hourBytes);
+            });
+            ++loaded;
         }
     }
 
-    std::cout << "Loaded " << daily_stats.size() << " days of statistics" << std::endl;
+    std::cout << "Loaded " << loaded << " days of statistics" << std::endl;
+    openJournal(generation);
 }
 
-void DataManager::resetMonthlyData() {
-    std::string current_month = getCurrentMonth();
-
-    for (auto it = daily_stats.begin(); it != daily_stats.end(); ) {
-        if (it->first.substr(0, 7) == current_month) {
-            it = daily_stats.erase(it);
-        } else {
-            ++it;
-        }
+void DataManager::openJournal(uint64_t generation) {
+    if (!writer.open(data_file_path, journal_file_path, generation,
+                     [this](const usage_journal::Record& record) { apply(record); })) {
+        LOG_WARN("Error opening usage journal", logging::field("path", journal_file_path));
+        return;
+    }
+    if (writer.journalRecords() > 0) {
+        LOG_INFO("Replayed journal", logging::field("records", static_cast<unsigned long>(writer.journalRecords())));
     }
+    if (writer.tornTail()) {
+        // Keep what replayed and drop the damaged tail
+        saveData();
+    }
+}
 
-    saveData();
+void DataManager::resetMonthlyData() {
+    using namespace usage_journal;
+    Record record = makeRecord(RecordType::ResetMonth, calendar::firstOfMonth(today.day()));
+    apply(record);
+    seal(record);
+    pending_records.push_back(record);
+    commit();
 }
 
 void DataManager::exportData(const std::string& filename) const {
@@ -307,16 +809,38 @@ void DataManager::exportData(const std::string& filename) const {
         return;
     }
 
-    file << "Date,Download (MB),Upload (MB),Peak Download (MB/s),Peak Upload (MB/s),Sessions,Session Time (hours)" << std::endl;
+    file << "Date,Download (MB),Upload (MB),Peak Download (MB/s),Peak Upload (MB/s),Sessions,Session Time (hours),"
+            "Download Packets,Upload Packets,Avg Download Packet (B),Avg Upload Packet (B),"
+            "Peak Download Packets/s,Peak Upload Packets/s,Download Dropped,Upload Dropped,"
+            "Download Drop Rate (%),Upload Drop Rate (%),Download Errors,Upload Errors,"
+            "Download p50 (MB/s),Download p95 (MB/s),Download p99 (MB/s),"
+            "Upload p50 (MB/s),Upload p95 (MB/s),Upload p99 (MB/s)" << std::endl;
 
-    for (const auto& pair : daily_stats) {
-        const auto& stats = pair.second;
+    for (const DailyStats& stats : storedDays()) {
         file << stats.date << ","
              << (stats.total_download_bytes / 1024.0 / 1024.0) << ","
              << (stats.total_upload_bytes / 1024.0 / 1024.0) << ","
              << (stats.peak_download_speed / 1024.0 / 1024.0) << ","
              << (stats.peak_upload_speed / 1024.0 / 1024.0) << ","
              << stats.session_count << ","
-             << (stats.total_session_time.count() / 3600.0) << std::endl;
+             << (stats.total_session_time.count() / 3600.0) << ","
+             << stats.total_download_packets << ","
+             << stats.total_upload_packets << ","
+             << averageSize(stats.total_download_bytes, stats.total_download_packets) << ","
+             << averageSize(stats.total_upload_bytes, stats.total_upload_packets) << ","
+             << stats.peak_download_packet_rate << ","
+             << stats.peak_upload_packet_rate << ","
+             << stats.download_dropped << ","
+             << stats.upload_dropped << ","
+             << percentOf(stats.download_dropped, stats.total_download_packets + stats.download_dropped) << ","
+             << percentOf(stats.upload_dropped, stats.total_upload_packets + stats.upload_dropped) << ","
+             << stats.download_errors << ","
+             << stats.upload_errors << ","
+             << (stats.rates.download.percentile(0.50) / 1024.0 / 1024.0) << ","
+             << (stats.rates.download.percentile(0.95) / 1024.0 / 1024.0) << ","
+             << (stats.rates.download.percentile(0.99) / 1024.0 / 1024.0) << ","
+             << (stats.rates.upload.percentile(0.50) / 1024.0 / 1024.0) << ","
+             << (stats.rates.upload.percentile(0.95) / 1024.0 / 1024.0) << ","
+             << (stats.rates.upload.percentile(0.99) / 1024.0 / 1024.0) << std::endl;
     }
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #include "../include/download_test.h"
 #include "../include/curl_wrapper.h"
+#include "../include/logger.h"
 #include <curl/curl.h>
-#include <iostream>
 #include <chrono>
 #include <cstring>
 #include <algorithm>
@@ -129,7 +129,7 @@ double DownloadTest::run(const std::string& url, int parallelConnections,
 void DownloadTest::downloadWorker(const std::string& url, int threadId) {
     CurlHandle curl;
     if (!curl) {
-        std::cerr << "Failed to initialize curl for thread " << threadId << std::endl;
+        LOG_ERROR("Failed to initialize curl for download thread", logging::field("thread", threadId));
         return;
     }
     
@@ -163,9 +163,10 @@ void DownloadTest::downloadWorker(const std::string& url, int threadId) {
             consecutiveErrors = 0;  // Reset error counter on success
         } else if (running_) {
             consecutiveErrors++;
-            std::cerr << "Download error in thread " << threadId 
-                      << ": " << curl_easy_strerror(res) 
-                      << " (attempt " << consecutiveErrors << "/" << maxConsecutiveErrors << ")" << std::endl;
+            LOG_WARN("Download error", logging::field("thread", threadId),
+                     logging::field("error", curl_easy_strerror(res)),
+                     logging::field("attempt", consecutiveErrors),
+                     logging::field("max_attempts", maxConsecutiveErrors));
             
             // Small delay before retry
             std::this_thread::sleep_for(std::chrono::milliseconds(500));
@@ -2,6 +2,8 @@
 #include <string>
 #include <iomanip>
 #include <sstream>
+#include <cmath>
+#include <cstdint>
 
 std::string formatSpeed(double speed) {
     std::ostringstream oss;
@@ -22,4 +24,47 @@ std::string formatDataUsage(long long bytes) {
     std::ostringstream oss;
     oss << std::fixed << std::setprecision(2) << size << " " << units[unitIndex];
     return oss.str();
-}
\ No newline at end of file
+}
+
+char* formatFixed(char* first, char* last, double value, int precision) {
+    static const uint64_t kScale[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+    if (precision < 0) precision = 0;
+    if (precision > 6) precision = 6;
+    if (!std::isfinite(value)) value = 0.0;
+
+    const bool negative = value < 0.0;
+    const double magnitude = negative ? -value : value;
+    if (magnitude >= 1e12) {
+        return nullptr; // beyond anything a rate or byte count displays
+    }
+    const uint64_t scaled = static_cast<uint64_t>(std::llround(magnitude * kScale[precision]));
+    uint64_t whole = scaled / kScale[precision];
+    uint64_t fraction = scaled % kScale[precision];
+
+    // Digits are produced backwards into a scratch buffer
+    char digits[32];
+    char* p = digits + sizeof(digits);
+    for (int i = 0; i < precision; ++i) {
+        *--p = static_cast<char>('0' + fraction % 10);
+        fraction /= 10;
+    }
+    if (precision > 0) {
+        *--p = '.';
+    }
+    do {
+        *--p = static_cast<char>('0' + whole % 10);
+        whole /= 10;
+    } while (whole != 0);
+    if (negative && scaled != 0) {
+        *--p = '-';
+    }
+
+    const size_t length = static_cast<size_t>(digits + sizeof(digits) - p);
+    if (static_cast<size_t>(last - first) < length) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        first[i] = p[i];
+    }
+    return first + length;
+}
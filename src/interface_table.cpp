@@ -0,0 +1,274 @@
+#include "../include/interface_table.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr uint32_t kTombstone = 0xffffffffu;
+constexpr size_t kInitialBuckets = 64;
+
+inline uint32_t hashName(const char* name, size_t len) {
+    uint32_t h = 2166136261u; // FNV-1a
+    for (size_t i = 0; i < len; ++i) {
+        h ^= static_cast<unsigned char>(name[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// /proc/net/dev column feeding each table counter
+constexpr int kColumn[InterfaceTable::kCounterCount] = {
+    0,  // RxBytes
+    8,  // TxBytes
+    1,  // RxPackets
+    9,  // TxPackets
+    3,  // RxDrop
+    11  // TxDrop
+};
+
+} // namespace
+
+InterfaceTable::InterfaceTable()
+    : buckets_(kInitialBuckets, 0),
+      tombstones_(0),
+      row_(0),
+      presentCount_(0),
+      loopbackSlot_(kNoSlot) {
+}
+
+void InterfaceTable::update(const ProcNetDevReader& reader, double elapsedSeconds) {
+    beginUpdate();
+    reader.forEach([this](const char* name, size_t nameLen, const uint64_t* fields) {
+        ingest(name, nameLen, fields);
+    });
+    endUpdate(elapsedSeconds);
+}
+
+void InterfaceTable::beginUpdate() {
+    row_ = 0;
+    std::fill(seen_.begin(), seen_.end(), 0);
+}
+
+uint32_t InterfaceTable::ingest(const char* name, size_t nameLen, const uint64_t* fields) {
+    uint32_t slot = kNoSlot;
+    if (row_ < rowOrder_.size()) {
+        uint32_t hint = rowOrder_[row_];
+        if (hint != kNoSlot && names_[hint].size() == nameLen &&
+            std::memcmp(names_[hint].data(), name, nameLen) == 0) {
+            slot = hint;
+        }
+    }
+    if (slot == kNoSlot) {
+        uint32_t hash = hashName(name, nameLen);
+        slot = lookup(name, nameLen, hash);
+        if (slot == kNoSlot) {
+            slot = assignSlot(name, nameLen, hash);
+        }
+    }
+
+    if (row_ < rowOrder_.size()) {
+        rowOrder_[row_] = slot;
+    } else {
+        rowOrder_.push_back(slot);
+    }
+    ++row_;
+
+    seen_[slot] = 1;
+    for (int c = 0; c < kCounterCount; ++c) {
+        current_[c][slot] = fields[kColumn[c]];
+    }
+    return slot;
+}
+
+void InterfaceTable::endUpdate(double elapsedSeconds) {
+    rowOrder_.resize(row_);
+
+    const size_t n = names_.size();
+    size_t present = 0;
+    for (size_t s = 0; s < n; ++s) {
+        const bool wasPresent = present_[s] != 0;
+        const bool isSeen = seen_[s] != 0;
+        valid_[s] = (wasPresent && isSeen) ? 1.0 : 0.0;
+        if (wasPresent && !isSeen) {
+            freeSlots_.push_back(static_cast<uint32_t>(s));
+        }
+        present_[s] = seen_[s];
+        present += seen_[s];
+    }
+    presentCount_ = present;
+
+    computeRates(elapsedSeconds);
+}
+
+void InterfaceTable::computeRates(double elapsedSeconds) {
+    const size_t n = names_.size();
+    const double invElapsed = elapsedSeconds > 0.0 ? 1.0 / elapsedSeconds : 0.0;
+    const double* valid = valid_.data();
+
+    for (int c = 0; c < kCounterCount; ++c) {
+        const uint64_t* cur = current_[c].data();
+        uint64_t* prev = previous_[c].data();
+        double* rate = rate_[c].data();
+        for (size_t i = 0; i < n; ++i) {
+            // A counter that went backwards (driver reset) yields no rate
+            uint64_t delta = cur[i] >= prev[i] ? cur[i] - prev[i] : 0;
+            rate[i] = static_cast<double>(delta) * invElapsed * valid[i];
+            prev[i] = cur[i];
+        }
+    }
+}
+
+uint32_t InterfaceTable::findSlot(const char* name, size_t nameLen) const {
+    return lookup(name, nameLen, hashName(name, nameLen));
+}
+
+uint32_t InterfaceTable::lookup(const char* name, size_t nameLen, uint32_t hash) const {
+    // Bounded by the table size, so a table without empty buckets cannot
+    // spin; indexSlot() keeps one from forming
+    const size_t mask = buckets_.size() - 1;
+    size_t i = hash & mask;
+    for (size_t step = 0; step < buckets_.size(); ++step, i = (i + 1) & mask) {
+        uint32_t bucket = buckets_[i];
+        if (bucket == 0) {
+            return kNoSlot;
+        }
+        if (bucket == kTombstone) {
+            continue;
+        }
+        uint32_t slot = bucket - 1;
+        if (hashes_[slot] == hash && names_[slot].size() == nameLen &&
+            std::memcmp(names_[slot].data(), name, nameLen) == 0) {
+            return slot;
+        }
+    }
+    return kNoSlot;
+}
+
+uint32_t InterfaceTable::assignSlot(const char* name, size_t nameLen, uint32_t hash) {
+    // Reuse the slot of an interface that has gone away, if any
+    while (!freeSlots_.empty()) {
+        uint32_t slot = freeSlots_.back();
+        freeSlots_.pop_back();
+        if (present_[slot] || seen_[slot]) {
+            continue; // the old interface came back and kept its slot
+        }
+        eraseIndex(slot);
+        names_[slot].assign(name, nameLen);
+        hashes_[slot] = hash;
+        for (int c = 0; c < kCounterCount; ++c) {
+            current_[c][slot] = 0;
+            previous_[c][slot] = 0;
+            rate_[c][slot] = 0.0;
+        }
+        indexSlot(slot, hash);
+        if (loopbackSlot_ == slot) {
+            loopbackSlot_ = kNoSlot;
+        }
+        if (nameLen == 2 && std::memcmp(name, "lo", 2) == 0) {
+            loopbackSlot_ = slot;
+        }
+        return slot;
+    }
+
+    uint32_t slot = static_cast<uint32_t>(names_.size());
+    names_.emplace_back(name, nameLen);
+    hashes_.push_back(hash);
+    present_.push_back(0);
+    seen_.push_back(0);
+    valid_.push_back(0.0);
+    for (int c = 0; c < kCounterCount; ++c) {
+        current_[c].push_back(0);
+        previous_[c].push_back(0);
+        rate_[c].push_back(0.0);
+    }
+    if (nameLen == 2 && std::memcmp(name, "lo", 2) == 0) {
+        loopbackSlot_ = slot;
+    }
+    indexSlot(slot, hash);
+    return slot;
+}
+
+void InterfaceTable::indexSlot(uint32_t slot, uint32_t hash) {
+    // Keep the index at most half full, counting tombstones. Slot reuse
+    // leaves a tombstone per renamed slot without growing names_, so under
+    // veth churn this mostly rebuilds in place to clear them.
+    if ((names_.size() + tombstones_) * 2 > buckets_.size()) {
+        size_t capacity = buckets_.size();
+        while (names_.size() * 2 > capacity / 2) {
+            capacity *= 2;
+        }
+        rebuildIndex(capacity);
+    } else {
+        insertIndex(slot, hash);
+    }
+}
+
+void InterfaceTable::insertIndex(uint32_t slot, uint32_t hash) {
+    const size_t mask = buckets_.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        if (buckets_[i] == 0 || buckets_[i] == kTombstone) {
+            if (buckets_[i] == kTombstone) {
+                --tombstones_;
+            }
+            buckets_[i] = slot + 1;
+            return;
+        }
+    }
+}
+
+void InterfaceTable::eraseIndex(uint32_t slot) {
+    const size_t mask = buckets_.size() - 1;
+    size_t i = hashes_[slot] & mask;
+    for (size_t step = 0; step < buckets_.size(); ++step, i = (i + 1) & mask) {
+        if (buckets_[i] == 0) {
+            return;
+        }
+        if (buckets_[i] == slot + 1) {
+            buckets_[i] = kTombstone;
+            ++tombstones_;
+            return;
+        }
+    }
+}
+
+void InterfaceTable::rebuildIndex(size_t capacity) {
+    buckets_.assign(capacity, 0);
+    tombstones_ = 0;
+    for (size_t s = 0; s < names_.size(); ++s) {
+        insertIndex(static_cast<uint32_t>(s), hashes_[s]);
+    }
+}
+
+InterfaceRate InterfaceTable::total() const {
+    const size_t n = names_.size();
+    const double* rx = rate_[RxBytes].data();
+    const double* tx = rate_[TxBytes].data();
+    double rxSum = 0.0;
+    double txSum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        rxSum += rx[i];
+        txSum += tx[i];
+    }
+    if (loopbackSlot_ != kNoSlot) {
+        rxSum -= rx[loopbackSlot_];
+        txSum -= tx[loopbackSlot_];
+    }
+    return InterfaceRate{"all", rxSum, txSum};
+}
+
+void InterfaceTable::topN(size_t n, std::vector<uint32_t>& slots) const {
+    slots.clear();
+    const double* rx = rate_[RxBytes].data();
+    const double* tx = rate_[TxBytes].data();
+    for (size_t s = 0; s < names_.size(); ++s) {
+        if (present_[s] && s != loopbackSlot_) {
+            slots.push_back(static_cast<uint32_t>(s));
+        }
+    }
+    n = std::min(n, slots.size());
+    std::partial_sort(slots.begin(), slots.begin() + n, slots.end(),
+                      [rx, tx](uint32_t a, uint32_t b) {
+                          return rx[a] + tx[a] > rx[b] + tx[b];
+                      });
+    slots.resize(n);
+}
@@ -0,0 +1,167 @@
+#include "../include/label_renderer.h"
+#include "../include/helpers.h"
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Bounded appender over a fixed buffer; output is truncated, never overrun
+class TextWriter {
+public:
+    TextWriter(char* buf, size_t size) : begin_(buf), p_(buf), end_(buf + size - 1) {}
+
+    void put(const char* text) {
+        while (*text && p_ < end_) {
+            *p_++ = *text++;
+        }
+    }
+
+    void fixed(double value, int precision) {
+        char* next = formatFixed(p_, end_, value, precision);
+        if (next) p_ = next;
+    }
+
+    void speed(double bytesPerSecond) {
+        char* next = LabelRenderer::formatSpeed(p_, end_, bytesPerSecond);
+        if (next) p_ = next;
+    }
+
+    // NUL-terminate; returns the length written
+    size_t finish() {
+        *p_ = '\0';
+        return static_cast<size_t>(p_ - begin_);
+    }
+
+private:
+    char* begin_;
+    char* p_;
+    char* end_;
+};
+
+constexpr double kBytesPerMB = 1024.0 * 1024.0;
+
+int64_t megabyteKey(uint64_t bytes) {
+    return static_cast<int64_t>(std::llround(bytes / kBytesPerMB * 100.0));
+}
+
+} // namespace
+
+constexpr size_t LabelRenderer::kLabelSize;
+constexpr size_t LabelRenderer::kTooltipSize;
+
+LabelRenderer::LabelRenderer()
+    : labelKeys_{0, 0},
+      tooltipKeys_{0, 0, 0, 0},
+      hasLabel_(false),
+      hasTooltip_(false) {
+    label_[0] = '\0';
+    tooltip_[0] = '\0';
+    tooltipIface_[0] = '\0';
+}
+
+int64_t LabelRenderer::speedKey(double bytesPerSecond) {
+    if (!std::isfinite(bytesPerSecond) || bytesPerSecond < 0.0) {
+        bytesPerSecond = 0.0;
+    }
+    const double kbits = bytesPerSecond * 8.0 / 1024.0;
+    if (kbits < 1024.0) {
+        return std::llround(kbits * 10.0);                         // 0.1 Kb/s steps
+    }
+    return (int64_t(1) << 62) | std::llround(kbits / 1024.0 * 100.0); // 0.01 Mb/s steps
+}
+
+char* LabelRenderer::formatSpeed(char* first, char* last, double bytesPerSecond) {
+    if (!std::isfinite(bytesPerSecond) || bytesPerSecond < 0.0) {
+        bytesPerSecond = 0.0;
+    }
+    const double kbits = bytesPerSecond * 8.0 / 1024.0;
+    const bool mega = kbits >= 1024.0;
+    char* p = formatFixed(first, last, mega ? kbits / 1024.0 : kbits, mega ? 2 : 1);
+    const char* unit = mega ? " Mb/s" : " Kb/s";
+    const size_t unitLength = 5;
+    if (!p || static_cast<size_t>(last - p) < unitLength) {
+        return nullptr;
+    }
+    std::memcpy(p, unit, unitLength);
+    return p + unitLength;
+}
+
+bool LabelRenderer::updateLabel(const MetricsSnapshot& snapshot) {
+    const int64_t rx = speedKey(snapshot.rx_rate);
+    const int64_t tx = speedKey(snapshot.tx_rate);
+    if (hasLabel_ && rx == labelKeys_[0] && tx == labelKeys_[1]) {
+        return false;
+    }
+    labelKeys_[0] = rx;
+    labelKeys_[1] = tx;
+    hasLabel_ = true;
+
+    TextWriter out(label_, sizeof(label_));
+    out.put("↓ ");
+    out.speed(snapshot.rx_rate);
+    out.put(" | ↑ ");
+    out.speed(snapshot.tx_rate);
+    out.finish();
+    return true;
+}
+
+bool LabelRenderer::updateTooltip(const MetricsSnapshot& snapshot, const InterfaceRate* total,
+                                  const std::vector<InterfaceRate>& top) {
+    const int64_t rx = megabyteKey(snapshot.total_rx_bytes);
+    const int64_t tx = megabyteKey(snapshot.total_tx_bytes);
+    const int64_t dropped = static_cast<int64_t>(snapshot.total_rx_dropped);
+    const int64_t sendDropped = static_cast<int64_t>(snapshot.total_tx_dropped);
+    const bool sameBase = hasTooltip_ && rx == tooltipKeys_[0] && tx == tooltipKeys_[1] &&
+                          dropped == tooltipKeys_[2] && sendDropped == tooltipKeys_[3] &&
+                          std::strncmp(tooltipIface_, snapshot.iface, sizeof(tooltipIface_)) == 0;
+    // The all-interface lines change with every sample; only the fixed
+    // part is worth comparing before rendering
+    if (sameBase && !total) {
+        return false;
+    }
+    tooltipKeys_[0] = rx;
+    tooltipKeys_[1] = tx;
+    tooltipKeys_[2] = dropped;
+    tooltipKeys_[3] = sendDropped;
+    std::memcpy(tooltipIface_, snapshot.iface, sizeof(tooltipIface_));
+    tooltipIface_[sizeof(tooltipIface_) - 1] = '\0';
+
+    char next[kTooltipSize];
+    TextWriter out(next, sizeof(next));
+    out.put("Interface: ");
+    out.put(tooltipIface_);
+    out.put("\nTotal Download: ");
+    out.fixed(snapshot.total_rx_bytes / kBytesPerMB, 2);
+    out.put(" MB\nTotal Upload: ");
+    out.fixed(snapshot.total_tx_bytes / kBytesPerMB, 2);
+    out.put(" MB");
+    if (dropped != 0 || sendDropped != 0) {
+        out.put("\nDropped: ");
+        out.fixed(static_cast<double>(dropped), 0);
+        out.put(" in | ");
+        out.fixed(static_cast<double>(sendDropped), 0);
+        out.put(" out");
+    }
+    if (total) {
+        out.put("\nAll interfaces: ↓ ");
+        out.speed(total->rx_rate);
+        out.put(" | ↑ ");
+        out.speed(total->tx_rate);
+        for (const InterfaceRate& entry : top) {
+            out.put("\n  ");
+            out.put(entry.name.c_str());
+            out.put(": ↓ ");
+            out.speed(entry.rx_rate);
+            out.put(" | ↑ ");
+            out.speed(entry.tx_rate);
+        }
+    }
+    const size_t length = out.finish();
+
+    if (hasTooltip_ && std::memcmp(next, tooltip_, length + 1) == 0) {
+        return false;
+    }
+    std::memcpy(tooltip_, next, length + 1);
+    hasTooltip_ = true;
+    return true;
+}
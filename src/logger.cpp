@@ -0,0 +1,322 @@
+#include "../include/logger.h"
+#include "../include/helpers.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace logging {
+namespace {
+
+constexpr size_t kMaxFields = 6;
+constexpr size_t kRingCapacity = 128; // records per thread; power of two
+constexpr size_t kBatchSize = 64 * 1024;
+constexpr auto kFlushInterval = std::chrono::milliseconds(100);
+
+struct Record {
+    int64_t wall_ns;
+    const char* message;
+    Level level;
+    uint8_t field_count;
+    Field fields[kMaxFields];
+};
+
+// Single-producer (the owning thread) / single-consumer (the flusher) ring
+struct Ring {
+    Record records[kRingCapacity];
+    std::atomic<size_t> head{0}; // next slot the producer writes
+    std::atomic<size_t> tail{0}; // next slot the flusher reads
+    std::atomic<bool> abandoned{false};
+
+    // Returns the number of queued records including this one, 0 if full
+    size_t push(const Record& record) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        const size_t queued = h - tail.load(std::memory_order_acquire);
+        if (queued == kRingCapacity) {
+            return 0;
+        }
+        records[h & (kRingCapacity - 1)] = record;
+        head.store(h + 1, std::memory_order_release);
+        return queued + 1;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_relaxed);
+    }
+};
+
+Level initialLevel() {
+    const char* debug = std::getenv("SPEED_METER_DEBUG");
+    return debug && std::strcmp(debug, "1") == 0 ? Level::Debug : Level::Info;
+}
+
+struct State {
+    std::mutex rings_mutex; // guards rings; taken once per thread and by the flusher
+    std::vector<std::unique_ptr<Ring>> rings;
+    std::mutex output_mutex;
+    std::FILE* out = nullptr;
+    std::atomic<int> level{static_cast<int>(initialLevel())};
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> dropped{0};
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    std::thread flusher;
+    char batch[kBatchSize];
+};
+
+State& state() {
+    static State* s = new State(); // never destroyed: threads may log during exit
+    return *s;
+}
+
+// Marks the thread's ring abandoned at thread exit so the flusher can
+// reclaim it once drained
+struct RingHandle {
+    Ring* ring = nullptr;
+    ~RingHandle() {
+        if (ring) ring->abandoned.store(true, std::memory_order_release);
+    }
+};
+
+Ring* threadRing() {
+    static thread_local RingHandle handle;
+    if (!handle.ring) {
+        std::unique_ptr<Ring> ring(new Ring());
+        handle.ring = ring.get();
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.rings_mutex);
+        s.rings.push_back(std::move(ring));
+    }
+    return handle.ring;
+}
+
+const char* levelName(Level level) {
+    switch (level) {
+    case Level::Trace: return "TRACE";
+    case Level::Debug: return "DEBUG";
+    case Level::Info:  return "INFO ";
+    case Level::Warn:  return "WARN ";
+    case Level::Error: return "ERROR";
+    }
+    return "?    ";
+}
+
+// Bounded appender; a record that does not fit is cut short
+struct Writer {
+    char* p;
+    char* end;
+
+    void put(const char* text) {
+        while (*text && p < end) *p++ = *text++;
+    }
+    void putChar(char c) {
+        if (p < end) *p++ = c;
+    }
+    void putUnsigned(uint64_t value, int minDigits = 1) {
+        char digits[24];
+        int n = 0;
+        do {
+            digits[n++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0 || n < minDigits);
+        while (n > 0 && p < end) *p++ = digits[--n];
+    }
+    void putSigned(int64_t value) {
+        if (value < 0) {
+            putChar('-');
+            putUnsigned(static_cast<uint64_t>(-(value + 1)) + 1);
+        } else {
+            putUnsigned(static_cast<uint64_t>(value));
+        }
+    }
+    void putDouble(double value) {
+        char* next = formatFixed(p, end, value, 2);
+        if (next) p = next;
+    }
+};
+
+void formatRecord(Writer& w, const Record& r) {
+    const std::time_t seconds = static_cast<std::time_t>(r.wall_ns / 1000000000);
+    std::tm tm;
+#ifdef _WIN32
+    localtime_s(&tm, &seconds);
+#else
+    localtime_r(&seconds, &tm);
+#endif
+    w.putUnsigned(static_cast<uint64_t>(tm.tm_year + 1900), 4);
+    w.putChar('-');
+    w.putUnsigned(static_cast<uint64_t>(tm.tm_mon + 1), 2);
+    w.putChar('-');
+    w.putUnsigned(static_cast<uint64_t>(tm.tm_mday), 2);
+    w.putChar(' ');
+    w.putUnsigned(static_cast<uint64_t>(tm.tm_hour), 2);
+    w.putChar(':');
+    w.putUnsigned(static_cast<uint64_t>(tm.tm_min), 2);
+    w.putChar(':');
+    w.putUnsigned(static_cast<uint64_t>(tm.tm_sec), 2);
+    w.putChar('.');
+    w.putUnsigned(static_cast<uint64_t>((r.wall_ns / 1000000) % 1000), 3);
+    w.putChar(' ');
+    w.put(levelName(r.level));
+    w.putChar(' ');
+    w.put(r.message);
+    for (uint8_t i = 0; i < r.field_count; ++i) {
+        const Field& f = r.fields[i];
+        w.putChar(' ');
+        w.put(f.key);
+        w.putChar('=');
+        switch (f.type) {
+        case Field::Int:    w.putSigned(f.i); break;
+        case Field::Uint:   w.putUnsigned(f.u); break;
+        case Field::Double: w.putDouble(f.d); break;
+        case Field::Text:   w.put(f.text); break;
+        }
+    }
+    w.putChar('\n');
+}
+
+void emit(State& s, const char* data, size_t length) {
+    if (length == 0) return;
+    std::lock_guard<std::mutex> lock(s.output_mutex);
+    std::FILE* out = s.out ? s.out : stderr;
+    std::fwrite(data, 1, length, out);
+    std::fflush(out);
+}
+
+// Move every queued record into batches and write them out; flusher only
+void drain(State& s) {
+    Writer w{s.batch, s.batch + kBatchSize};
+    const size_t kRecordReserve = 512;
+
+    std::lock_guard<std::mutex> lock(s.rings_mutex);
+    for (size_t i = 0; i < s.rings.size();) {
+        Ring& ring = *s.rings[i];
+        size_t t = ring.tail.load(std::memory_order_relaxed);
+        const size_t h = ring.head.load(std::memory_order_acquire);
+        for (; t != h; ++t) {
+            if (static_cast<size_t>(w.end - w.p) < kRecordReserve) {
+                emit(s, s.batch, static_cast<size_t>(w.p - s.batch));
+                w.p = s.batch;
+            }
+            formatRecord(w, ring.records[t & (kRingCapacity - 1)]);
+        }
+        ring.tail.store(t, std::memory_order_release);
+
+        if (ring.abandoned.load(std::memory_order_acquire) && ring.empty()) {
+            s.rings[i] = std::move(s.rings.back());
+            s.rings.pop_back();
+        } else {
+            ++i;
+        }
+    }
+
+    const uint64_t dropped = s.dropped.exchange(0);
+    if (dropped != 0) {
+        Record note{};
+        note.wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        note.message = "Log records dropped (ring full)";
+        note.level = Level::Warn;
+        note.field_count = 1;
+        note.fields[0] = field("count", dropped);
+        formatRecord(w, note);
+    }
+    emit(s, s.batch, static_cast<size_t>(w.p - s.batch));
+}
+
+void flusherLoop() {
+    State& s = state();
+    while (s.running.load()) {
+        {
+            std::unique_lock<std::mutex> lock(s.wake_mutex);
+            s.wake.wait_for(lock, kFlushInterval);
+        }
+        drain(s);
+    }
+    drain(s);
+}
+
+} // namespace
+
+void start() {
+    State& s = state();
+    if (s.running.exchange(true)) {
+        return;
+    }
+    const char* path = std::getenv("SPEED_METER_LOG_FILE");
+    if (path && *path) {
+        std::FILE* file = std::fopen(path, "a");
+        if (file) {
+            std::lock_guard<std::mutex> lock(s.output_mutex);
+            s.out = file;
+        }
+    }
+    s.flusher = std::thread(flusherLoop);
+}
+
+void stop() {
+    State& s = state();
+    if (!s.running.exchange(false)) {
+        return;
+    }
+    s.wake.notify_all();
+    if (s.flusher.joinable()) {
+        s.flusher.join();
+    }
+    std::lock_guard<std::mutex> lock(s.output_mutex);
+    if (s.out) {
+        std::fclose(s.out);
+        s.out = nullptr;
+    }
+}
+
+void setLevel(Level level) {
+    state().level.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+bool enabled(Level level) {
+    return static_cast<int>(level) >= state().level.load(std::memory_order_relaxed);
+}
+
+uint64_t droppedCount() {
+    return state().dropped.load();
+}
+
+void write(Level level, const char* message, const Field* fields, size_t count) {
+    Record record;
+    record.wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    record.message = message;
+    record.level = level;
+    record.field_count = static_cast<uint8_t>(count < kMaxFields ? count : kMaxFields);
+    for (uint8_t i = 0; i < record.field_count; ++i) {
+        record.fields[i] = fields[i];
+    }
+
+    State& s = state();
+    if (!s.running.load(std::memory_order_acquire)) {
+        // No flusher (tools, early start-up): format and write in place
+        char line[1024];
+        Writer w{line, line + sizeof(line)};
+        formatRecord(w, record);
+        emit(s, line, static_cast<size_t>(w.p - line));
+        return;
+    }
+    const size_t queued = threadRing()->push(record);
+    if (queued == 0) {
+        s.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    // Errors and a filling ring should not wait for the next interval
+    if (level >= Level::Warn || queued == kRingCapacity / 2) {
+        s.wake.notify_one();
+    }
+}
+
+} // namespace logging
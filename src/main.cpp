@@ -9,11 +9,17 @@
 #include <string>
 #include <unistd.h>
 #include <cstring>
+#include <cctype>
+#include <cmath>
 #include <curl/curl.h>
 #include "../include/tray_icon.h"
+#include "../include/calendar_day.h"
+#include "../include/meter_client.h"
 #include "../include/speed_monitor.h"
 #include "../include/window.h"
 #include "../include/data_manager.h"
+#include "../include/logger.h"
+#include "../include/terminal_watch.h"
 
 // Forward declarations for auto-startup functions
 void setup_autostart_linux();
@@ -49,34 +55,149 @@ TrayIcon trayIcon;
 std::unique_ptr<SpeedMeter> speedMeter;
 std::unique_ptr<Window> dashboardWindow;
 std::unique_ptr<DataManager> dataManager;
+// Set while a running speed-meterd does the sampling; speedMeter and
+// dataManager stay empty until the daemon goes away
+std::unique_ptr<MeterClient> meterClient;
 
 static int update_counter = 0;
 static uint64_t prev_total_download_bytes = 0;
 static uint64_t prev_total_upload_bytes = 0;
+static MetricsSnapshot prev_saved_snapshot = MetricsSnapshot(); // packet totals at the last save
+
+// Sample and record locally; the usual mode when no daemon is running
+bool start_standalone() {
+    try {
+        speedMeter = std::make_unique<SpeedMeter>();
+        dataManager = std::make_unique<DataManager>();
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to initialize SpeedMeter or DataManager: " << e.what() << std::endl;
+        return false;
+    }
+    if (dashboardWindow) {
+        dashboardWindow->setDataManager(dataManager.get());
+    }
+    return true;
+}
+
+// Use a running speed-meterd instead of a second sampler: the tray and the
+// dashboard show its pushed samples and its usage history
+bool connect_to_daemon() {
+    std::unique_ptr<MeterClient> client(new MeterClient());
+    if (!client->connect() || !client->subscribe()) {
+        return false;
+    }
+    LOG_INFO("Showing speed-meterd samples", logging::field("socket", meter_protocol::defaultSocketPath()));
+    meterClient = std::move(client);
+    return true;
+}
+
+void update_from_daemon() {
+    static MetricsSnapshot latest = MetricsSnapshot();
+    static int history_counter = 0;
+    static const Window* history_window = nullptr;
+
+    MetricsSnapshot sample;
+    while (meterClient->nextSample(sample, 0)) {
+        latest = sample;
+    }
+    if (!meterClient->isConnected()) {
+        LOG_WARN("Lost speed-meterd, sampling locally", logging::field("error", meterClient->error()));
+        meterClient.reset();
+        if (!start_standalone()) {
+            global_running = false;
+            gtk_main_quit();
+        }
+        return;
+    }
+
+    static LabelRenderer trayText;
+    static const std::vector<InterfaceRate> none;
+    const bool label_changed = trayText.updateLabel(latest);
+    const bool tooltip_changed = trayText.updateTooltip(latest, nullptr, none);
+    if (label_changed || tooltip_changed) {
+        trayIcon.set_label(trayText.label(), trayText.tooltip());
+    }
+
+    if (dashboardWindow) {
+        dashboardWindow->updateSpeeds(latest.tx_rate, latest.rx_rate,
+                                      static_cast<double>(latest.total_tx_bytes),
+                                      static_cast<double>(latest.total_rx_bytes),
+                                      latest.iface, "", latest.seq != 0);
+        dashboardWindow->updatePacketRates(latest);
+        dashboardWindow->updateSamplePeriod(latest.sample_period_ms, latest.sampling_idle);
+
+        // Usage totals live in the daemon's DataManager; ask once a minute
+        // and as soon as the dashboard opens
+        if (history_counter-- <= 0 || history_window != dashboardWindow.get()) {
+            history_counter = 60;
+            history_window = dashboardWindow.get();
+            static calendar::LocalToday today;
+            const int32_t day = today.day();
+            std::vector<meter_protocol::HistoryRow> days, months;
+            if (meterClient->days(calendar::formatDate(day), calendar::formatDate(day), days) &&
+                meterClient->months(calendar::formatMonth(day), calendar::formatMonth(day), months)) {
+                dashboardWindow->updateUsageHistory(days.empty() ? nullptr : &days[0],
+                                                    months.empty() ? nullptr : &months[0]);
+            }
+        }
+    }
+}
 
 gboolean update_tray(gpointer) {
+    if (meterClient && global_running) {
+        update_from_daemon();
+        return TRUE;
+    }
     if (speedMeter && global_running) {
-        // The SpeedMeter thread updates stats and label/tooltip
-        trayIcon.set_label(speedMeter->get_label(), speedMeter->get_tooltip());
+        // One consistent view of the latest sample for this whole tick
+        const MetricsSnapshot snapshot = speedMeter->get_snapshot();
+        // Only push text to the indicator when what it shows has changed
+        static LabelRenderer trayText;
+        if (speedMeter->render(trayText, snapshot)) {
+            trayIcon.set_label(trayText.label(), trayText.tooltip());
+        }
 
         // Update dashboard window if it exists and is visible
         if (dashboardWindow) {
             dashboardWindow->updateSpeeds(
-                speedMeter->get_current_upload_speed(),     // Current upload speed in bytes/sec
-                speedMeter->get_current_download_speed(),   // Current download speed in bytes/sec
-                speedMeter->get_total_tx_mb() * 1024 * 1024, // Total upload in bytes
-                speedMeter->get_total_rx_mb() * 1024 * 1024, // Total download in bytes
-                speedMeter->get_iface(),                     // Interface name
-                "",                                          // IP address (not available in GTK version)
-                true                                         // Assume connected if we have stats
+                snapshot.tx_rate,                                 // Current upload speed in bytes/sec
+                snapshot.rx_rate,                                 // Current download speed in bytes/sec
+                static_cast<double>(snapshot.total_tx_bytes),     // Total upload in bytes
+                static_cast<double>(snapshot.total_rx_bytes),     // Total download in bytes
+                snapshot.iface,                                   // Interface name
+                "",                                               // IP address (not available in GTK version)
+                true                                              // Assume connected if we have stats
             );
+            dashboardWindow->updatePacketRates(snapshot);
+            dashboardWindow->updateSessionRates(speedMeter->get_session_rates());
+            dashboardWindow->updateSamplePeriod(snapshot.sample_period_ms, snapshot.sampling_idle);
+            // The dump runs on the sampler thread; only ranking and the
+            // list store update happen here
+            static std::vector<TcpSocketInfo> tcpRows;
+            const bool tcpHealthVisible = dashboardWindow->isTcpHealthVisible();
+            speedMeter->set_tcp_health_tracking(tcpHealthVisible);
+            if (tcpHealthVisible && speedMeter->take_tcp_health(tcpRows)) {
+                dashboardWindow->updateTcpHealth(tcpRows);
+            }
+            const bool nicLoadVisible = dashboardWindow->isNicLoadVisible();
+            speedMeter->set_nic_load_tracking(nicLoadVisible);
+            if (nicLoadVisible) {
+                dashboardWindow->updateNicLoad(speedMeter->get_nic_load());
+            }
+            if (speedMeter->is_all_interfaces()) {
+                dashboardWindow->updateInterfaceTable(speedMeter->get_all_interfaces_total(),
+                                                      speedMeter->get_top_interfaces());
+            }
+            if (speedMeter->is_tracking_processes()) {
+                dashboardWindow->updateProcessTable(speedMeter->get_top_processes());
+            }
         }
 
         // Save data every 60 seconds (1 minute)
         update_counter++;
         if (update_counter >= 60 && dataManager) {
-            uint64_t current_download_bytes = speedMeter->get_total_rx_mb() * 1024 * 1024;
-            uint64_t current_upload_bytes = speedMeter->get_total_tx_mb() * 1024 * 1024;
+            uint64_t current_download_bytes = snapshot.total_rx_bytes;
+            uint64_t current_upload_bytes = snapshot.total_tx_bytes;
             
             // Calculate incremental bytes since last save
             uint64_t incremental_download = current_download_bytes - prev_total_download_bytes;
@@ -85,13 +206,26 @@ gboolean update_tray(gpointer) {
             // Update previous totals
             prev_total_download_bytes = current_download_bytes;
             prev_total_upload_bytes = current_upload_bytes;
+
+            PacketActivity packets = PacketActivity();
+            packets.download_packets = snapshot.total_rx_packets - prev_saved_snapshot.total_rx_packets;
+            packets.upload_packets = snapshot.total_tx_packets - prev_saved_snapshot.total_tx_packets;
+            packets.download_dropped = snapshot.total_rx_dropped - prev_saved_snapshot.total_rx_dropped;
+            packets.upload_dropped = snapshot.total_tx_dropped - prev_saved_snapshot.total_tx_dropped;
+            packets.download_errors = snapshot.total_rx_errors - prev_saved_snapshot.total_rx_errors;
+            packets.upload_errors = snapshot.total_tx_errors - prev_saved_snapshot.total_tx_errors;
+            packets.download_packet_rate = snapshot.rx_packet_rate;
+            packets.upload_packet_rate = snapshot.tx_packet_rate;
+            prev_saved_snapshot = snapshot;
             
+            dataManager->recordRates(speedMeter->take_rate_samples());
             dataManager->updateDailyStats(
                 incremental_download,                          // Incremental download bytes
                 incremental_upload,                            // Incremental upload bytes
-                speedMeter->get_current_download_speed(),
-                speedMeter->get_current_upload_speed(),
-                std::chrono::seconds(update_counter)          // Session time
+                snapshot.rx_rate,
+                snapshot.tx_rate,
+                std::chrono::seconds(update_counter),         // Session time
+                packets
             );
             update_counter = 0; // Reset counter
         }
@@ -427,21 +561,74 @@ void remove_cinnamon_autostart() {
     // Cinnamon cleanup is handled by XDG removal
 }
 
+void watch_signal_handler(int) {
+    global_running = false;
+}
+
+// --watch [SECONDS] [--all]: print samples in the terminal instead of
+// running the tray. GTK, curl and autostart are never touched, so the
+// first frame is out as soon as SpeedMeter has its baseline.
+int run_watch_mode(int argc, char *argv[]) {
+    const char* interval = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--all") == 0) {
+            setenv("SPEED_METER_INTERFACES", "all", 1);
+        } else if (std::strcmp(argv[i], "--watch") == 0 && i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+            interval = argv[++i];
+        }
+    }
+    if (interval) {
+        const long ms = std::lround(std::atof(interval) * 1000.0);
+        const std::string value = std::to_string(ms < 10 ? 10 : ms);
+        setenv("SPEED_METER_INTERVAL_MS", value.c_str(), 1);
+        // A steady frame rate: no idle back-off unless asked for
+        setenv("SPEED_METER_MAX_INTERVAL_MS", value.c_str(), 0);
+    }
+    // Keep info records off the terminal being drawn on
+    if (!getenv("SPEED_METER_DEBUG")) {
+        logging::setLevel(logging::Level::Warn);
+    }
+    std::signal(SIGINT, watch_signal_handler);
+    std::signal(SIGTERM, watch_signal_handler);
+
+    std::unique_ptr<SpeedMeter> meter;
+    try {
+        meter = std::make_unique<SpeedMeter>();
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to initialize SpeedMeter: " << e.what() << std::endl;
+        return 1;
+    }
+    const int status = runTerminalWatch(*meter, global_running);
+    meter->on_quit();
+    return status;
+}
+
 int main(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--watch") == 0) {
+            return run_watch_mode(argc, argv);
+        }
+    }
+
     std::signal(SIGINT, signal_handler);
     std::signal(SIGTERM, signal_handler);
 
     // Initialize CURL globally (thread-safe initialization)
     curl_global_init(CURL_GLOBAL_ALL);
 
+    // Diagnostics go through a background flusher, not the GTK thread
+    logging::start();
+
     gtk_init(&argc, &argv);
     trayIcon.createTrayIcon();
 
-    try {
-        speedMeter = std::make_unique<SpeedMeter>();
-        dataManager = std::make_unique<DataManager>();
-    } catch (const std::exception& e) {
-        std::cerr << "Failed to initialize SpeedMeter or DataManager: " << e.what() << std::endl;
+    bool standalone = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--standalone") == 0) {
+            standalone = true;
+        }
+    }
+    if ((standalone || !connect_to_daemon()) && !start_standalone()) {
         return 1;
     }
 
@@ -471,6 +658,8 @@ int main(int argc, char *argv[]) {
 
     gtk_main();
 
+    logging::stop();
+
     // Cleanup CURL globally
     curl_global_cleanup();
 
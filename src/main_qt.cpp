@@ -17,6 +17,7 @@
 #include "speed_monitor_qt.h"
 #include "mainwindow.h"
 #include "version.h"
+#include "logger.h"
 
 #ifdef Q_OS_WIN
 #include "speed_monitor_win.h"
@@ -95,6 +96,8 @@ int main(int argc, char *argv[]) {
     app.setApplicationVersion(APP_VERSION);
     app.setOrganizationName(APP_ORGANIZATION);
 
+    logging::start();
+
     // Install signal handlers
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
@@ -115,6 +118,7 @@ int main(int argc, char *argv[]) {
     auto speedMonitor = std::make_unique<SpeedMonitorWin>();
 #else
     auto speedMonitor = std::make_unique<SpeedMonitorLinux>();
+    speedMonitor->setStandalone(app.arguments().contains("--standalone"));
 #endif
 
     if (!speedMonitor->initialize()) {
@@ -147,6 +151,7 @@ int main(int argc, char *argv[]) {
     // Cleanup
     speedMonitor->stop();
     global_running = false;
+    logging::stop();
 
     return result;
 }
\ No newline at end of file
@@ -27,6 +27,20 @@ private:
     double currentUploadSpeed = 0.0;
     uint64_t totalDownloadBytes = 0;
     uint64_t totalUploadBytes = 0;
+    double currentDownloadPacketRate = 0.0;
+    double currentUploadPacketRate = 0.0;
+    PacketActivity counters = PacketActivity(); // raw counters of the chosen interface
+
+    static PacketActivity packetCounters(const MIB_IFROW* row) {
+        PacketActivity c = PacketActivity();
+        c.download_packets = static_cast<uint64_t>(row->dwInUcastPkts) + row->dwInNUcastPkts;
+        c.upload_packets = static_cast<uint64_t>(row->dwOutUcastPkts) + row->dwOutNUcastPkts;
+        c.download_dropped = row->dwInDiscards;
+        c.upload_dropped = row->dwOutDiscards;
+        c.download_errors = row->dwInErrors;
+        c.upload_errors = row->dwOutErrors;
+        return c;
+    }
 
 public:
     WindowsSpeedMonitor() {
@@ -82,6 +96,11 @@ public:
 
                 totalDownloadBytes = bestInterface->dwInOctets;
                 totalUploadBytes = bestInterface->dwOutOctets;
+
+                const PacketActivity next = packetCounters(bestInterface);
+                currentDownloadPacketRate = ((double)(next.download_packets - counters.download_packets) * 1000.0) / timeDiff;
+                currentUploadPacketRate = ((double)(next.upload_packets - counters.upload_packets) * 1000.0) / timeDiff;
+                counters = next;
             }
         } else {
             // First update - just store values
@@ -91,6 +110,7 @@ public:
                     row->dwOperStatus == MIB_IF_OPER_STATUS_OPERATIONAL) {
                     totalDownloadBytes = row->dwInOctets;
                     totalUploadBytes = row->dwOutOctets;
+                    counters = packetCounters(row);
                     break;
                 }
             }
@@ -103,6 +123,10 @@ public:
     double get_current_upload_speed() const { return currentUploadSpeed; }
     double get_total_rx_mb() const { return totalDownloadBytes / (1024.0 * 1024.0); }
     double get_total_tx_mb() const { return totalUploadBytes / (1024.0 * 1024.0); }
+    double get_download_packet_rate() const { return currentDownloadPacketRate; }
+    double get_upload_packet_rate() const { return currentUploadPacketRate; }
+    // Packet, drop and error counters as the interface reports them
+    const PacketActivity& get_packet_counters() const { return counters; }
 };
 
 std::string formatSpeed(double speed);
@@ -119,12 +143,15 @@ int main() {
         auto dataManager = std::make_unique<DataManager>();
 
         std::cout << "Monitoring network speed... Press Ctrl+C to exit." << std::endl;
-        std::cout << "Download | Upload | Total Down | Total Up" << std::endl;
-        std::cout << "---------|--------|------------|----------" << std::endl;
+        std::cout << "Download | Upload | Total Down | Total Up | Packets Down/Up" << std::endl;
+        std::cout << "---------|--------|------------|----------|----------------" << std::endl;
 
         int update_counter = 0;
         uint64_t prev_total_download_bytes = 0;
         uint64_t prev_total_upload_bytes = 0;
+        PacketActivity prev_counters = speedMonitor->get_packet_counters();
+        RateDigest session_rates;
+        RateDigest pending_rates; // since the last save
 
         while (running) {
             // Update speed monitor
@@ -139,7 +166,14 @@ int main() {
             std::cout << formatSpeed(download_speed) << " | "
                       << formatSpeed(upload_speed) << " | "
                       << std::to_string(total_download).substr(0, 8) << " MB | "
-                      << std::to_string(total_upload).substr(0, 8) << " MB" << std::endl;
+                      << std::to_string(total_upload).substr(0, 8) << " MB | "
+                      << static_cast<long long>(speedMonitor->get_download_packet_rate()) << "/"
+                      << static_cast<long long>(speedMonitor->get_upload_packet_rate()) << " pkt/s" << std::endl;
+
+            session_rates.download.record(download_speed);
+            session_rates.upload.record(upload_speed);
+            pending_rates.download.record(download_speed);
+            pending_rates.upload.record(upload_speed);
 
             // Save data every minute
             update_counter++;
@@ -154,13 +188,28 @@ int main() {
                 // Update previous totals
                 prev_total_download_bytes = current_download_bytes;
                 prev_total_upload_bytes = current_upload_bytes;
+
+                const PacketActivity& counters = speedMonitor->get_packet_counters();
+                PacketActivity packets = PacketActivity();
+                packets.download_packets = counters.download_packets - prev_counters.download_packets;
+                packets.upload_packets = counters.upload_packets - prev_counters.upload_packets;
+                packets.download_dropped = counters.download_dropped - prev_counters.download_dropped;
+                packets.upload_dropped = counters.upload_dropped - prev_counters.upload_dropped;
+                packets.download_errors = counters.download_errors - prev_counters.download_errors;
+                packets.upload_errors = counters.upload_errors - prev_counters.upload_errors;
+                packets.download_packet_rate = speedMonitor->get_download_packet_rate();
+                packets.upload_packet_rate = speedMonitor->get_upload_packet_rate();
+                prev_counters = counters;
                 
+                dataManager->recordRates(pending_rates);
+                pending_rates.clear();
                 dataManager->updateDailyStats(
                     incremental_download,    // Incremental download bytes
                     incremental_upload,      // Incremental upload bytes
                     download_speed,
                     upload_speed,
-                    std::chrono::seconds(update_counter)
+                    std::chrono::seconds(update_counter),
+                    packets
                 );
                 update_counter = 0;
                 std::cout << "Data saved to persistent storage." << std::endl;
@@ -170,6 +219,18 @@ int main() {
         }
 
         std::cout << std::endl << "Shutting down..." << std::endl;
+        if (session_rates.download.count() > 0) {
+            std::cout << "Session download p50/p95/p99/max: "
+                      << formatSpeed(session_rates.download.percentile(0.50)) << " / "
+                      << formatSpeed(session_rates.download.percentile(0.95)) << " / "
+                      << formatSpeed(session_rates.download.percentile(0.99)) << " / "
+                      << formatSpeed(session_rates.download.max()) << std::endl;
+            std::cout << "Session upload p50/p95/p99/max: "
+                      << formatSpeed(session_rates.upload.percentile(0.50)) << " / "
+                      << formatSpeed(session_rates.upload.percentile(0.95)) << " / "
+                      << formatSpeed(session_rates.upload.percentile(0.99)) << " / "
+                      << formatSpeed(session_rates.upload.max()) << std::endl;
+        }
 
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
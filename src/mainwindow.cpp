@@ -29,6 +29,10 @@ MainWindow::MainWindow(SpeedMonitor* monitor, QWidget* parent)
     , tabWidget_(new QTabWidget(this))
     , startTime_(QDateTime::currentDateTime())
     , sessionSeconds_(0)
+    , packetsLabel_(nullptr)
+    , samplingLabel_(nullptr)
+    , allInterfacesLabel_(nullptr)
+    , lastChartPointMs_(0)
     , trayIcon_(nullptr)
     , darkMode_(false)
 {
@@ -210,8 +214,15 @@ void MainWindow::updateCharts() {
     double downloadSpeed = parseSpeed(speedMonitor_->getDownloadRate()) / 1024;  // Convert to KB/s
     double uploadSpeed = parseSpeed(speedMonitor_->getUploadRate()) / 1024;
 
-    downloadSeries_->append(now.toMSecsSinceEpoch(), downloadSpeed);
-    uploadSeries_->append(now.toMSecsSinceEpoch(), uploadSpeed);
+    // While the sampler is backed off the rate only changes once per
+    // period; plot one point per sample instead of repeating the held value
+    const qint64 nowMs = now.toMSecsSinceEpoch();
+    const int periodMs = speedMonitor_->getSamplePeriodMs();
+    if (periodMs <= 0 || nowMs - lastChartPointMs_ >= periodMs) {
+        downloadSeries_->append(nowMs, downloadSpeed);
+        uploadSeries_->append(nowMs, uploadSpeed);
+        lastChartPointMs_ = nowMs;
+    }
 
     // Keep only last 60 points (60 seconds)
     while (downloadSeries_->count() > 60) {
@@ -413,6 +424,12 @@ void MainWindow::createCurrentSpeedSection(QVBoxLayout* parent) {
     uploadLayout->addWidget(uploadProgressBar_);
     layout->addLayout(uploadLayout);
 
+    // Packet rate, average packet size and drops; small-packet floods and
+    // drops are invisible in the byte rates
+    packetsLabel_ = new QLabel("Packets: 0 /s down, 0 /s up");
+    packetsLabel_->setStyleSheet("color: #566573;");
+    layout->addWidget(packetsLabel_);
+
     // Peak speeds display
     QHBoxLayout* peakLayout = new QHBoxLayout();
     QLabel* peakDownloadLabel = new QLabel("Peak ↓: 0 B/s");
@@ -460,9 +477,17 @@ void MainWindow::createInterfaceSection(QVBoxLayout* parent) {
     statusLayout->addWidget(statusLabel_);
     statusLayout->addStretch();
 
+    samplingLabel_ = new QLabel("-", this);
+
+    // Totals and busiest interfaces (all-interface mode only)
+    allInterfacesLabel_ = new QLabel(this);
+    allInterfacesLabel_->setVisible(false);
+
     layout->addRow("Interface:", interfaceLabel_);
     layout->addRow("IP Address:", ipLabel_);
     layout->addRow("Connection Status:", statusLayout);
+    layout->addRow("Sampling:", samplingLabel_);
+    layout->addRow(allInterfacesLabel_);
 
     parent->addWidget(group);
 }
@@ -475,9 +500,12 @@ void MainWindow::createInterfaceInfoGroup() {
     ipLabel_ = new QLabel("Not available", this);
     statusLabel_ = new QLabel("Disconnected", this);
 
+    samplingLabel_ = new QLabel("-", this);
+
     layout->addRow("Interface:", interfaceLabel_);
     layout->addRow("IP Address:", ipLabel_);
     layout->addRow("Status:", statusLabel_);
+    layout->addRow("Sampling:", samplingLabel_);
 
     mainLayout_->addWidget(interfaceGroup_);
 }
@@ -516,6 +544,36 @@ void MainWindow::updateDisplay() {
 
     bool connected = speedMonitor_->isConnected();
     statusLabel_->setText(connected ? "Connected" : "Disconnected");
+
+    const int periodMs = speedMonitor_->getSamplePeriodMs();
+    if (samplingLabel_ && periodMs > 0) {
+        samplingLabel_->setText(QString("every %1 ms%2")
+            .arg(periodMs)
+            .arg(speedMonitor_->isSamplingIdle() ? " (idle)" : ""));
+    }
+    const PacketRates packets = speedMonitor_->getPacketRates();
+    if (packetsLabel_) {
+        auto averageSize = [](double bytes, double count) { return count > 0.0 ? bytes / count : 0.0; };
+        QString text = QString("Packets: %1 /s down, %2 /s up    Avg size: %3 B down, %4 B up")
+            .arg(packets.downloadPackets, 0, 'f', 0)
+            .arg(packets.uploadPackets, 0, 'f', 0)
+            .arg(averageSize(packets.downloadBytes, packets.downloadPackets), 0, 'f', 0)
+            .arg(averageSize(packets.uploadBytes, packets.uploadPackets), 0, 'f', 0);
+        if (packets.totalDownloadDropped || packets.totalUploadDropped ||
+            packets.totalDownloadErrors || packets.totalUploadErrors) {
+            text += QString("\nDrops: %1 /s down, %2 /s up (%3 / %4 total)    Errors: %5 / %6")
+                .arg(packets.downloadDrops, 0, 'f', 1)
+                .arg(packets.uploadDrops, 0, 'f', 1)
+                .arg(packets.totalDownloadDropped)
+                .arg(packets.totalUploadDropped)
+                .arg(packets.totalDownloadErrors)
+                .arg(packets.totalUploadErrors);
+        }
+        packetsLabel_->setText(text);
+    }
+
+    updateInterfaceTable();
+
     statusIndicator_->setStyleSheet(connected ?
         "color: #4CAF50; font-size: 16px;" :  // Green dot
         "color: #F44336; font-size: 16px;");  // Red dot
@@ -533,6 +591,10 @@ void MainWindow::updateDisplay() {
     record.uploadSpeed = parseSpeed(speedMonitor_->getUploadRate());
     record.totalDownload = parseBytes(speedMonitor_->getTotalDownload());
     record.totalUpload = parseBytes(speedMonitor_->getTotalUpload());
+    record.downloadPacketRate = packets.downloadPackets;
+    record.uploadPacketRate = packets.uploadPackets;
+    record.downloadDropRate = packets.downloadDrops;
+    record.uploadDropRate = packets.uploadDrops;
     
     usageHistory_.append(record);
     
@@ -629,6 +691,22 @@ double MainWindow::parseBytes(const QString& bytesStr) {
     return 0.0;
 }
 
+void MainWindow::updateInterfaceTable() {
+    if (!allInterfacesLabel_ || !speedMonitor_->isAllInterfaces()) {
+        return;
+    }
+
+    const InterfaceRate total = speedMonitor_->getAllInterfacesTotal();
+    QString text = QString("All interfaces: %1 down, %2 up")
+        .arg(formatSpeed(total.rx_rate), formatSpeed(total.tx_rate));
+    for (const InterfaceRate& entry : speedMonitor_->getTopInterfaces()) {
+        text += QString("\n    %1: %2 down, %3 up")
+            .arg(QString::fromStdString(entry.name), formatSpeed(entry.rx_rate), formatSpeed(entry.tx_rate));
+    }
+    allInterfacesLabel_->setText(text);
+    allInterfacesLabel_->setVisible(true);
+}
+
 QString MainWindow::formatSpeed(double bytesPerSecond) {
     if (bytesPerSecond >= 1024 * 1024) {
         return QString("%1 MB/s").arg(bytesPerSecond / (1024 * 1024), 0, 'f', 2);
@@ -0,0 +1,218 @@
+#include "../include/meter_client.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace meter_protocol;
+
+std::string meter_protocol::defaultSocketPath() {
+    const char* path = std::getenv("SPEED_METER_SOCKET");
+    if (path && *path) {
+        return path;
+    }
+    const char* runtime = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime && *runtime) {
+        return std::string(runtime) + "/speed-meterd.sock";
+    }
+    return "/tmp/speed-meterd-" + std::to_string(::getuid()) + ".sock";
+}
+
+MeterClient::MeterClient() : fd_(-1) {}
+
+MeterClient::~MeterClient() {
+    close();
+}
+
+bool MeterClient::connect(const std::string& path) {
+    close();
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        return fail("socket path too long");
+    }
+    path.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        return fail(std::strerror(errno));
+    }
+    if (::connect(fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        const int err = errno;
+        close();
+        return fail(path + ": " + std::strerror(err));
+    }
+    return true;
+}
+
+void MeterClient::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    buffer_.clear();
+}
+
+bool MeterClient::fail(const std::string& reason) {
+    error_ = reason;
+    return false;
+}
+
+bool MeterClient::send(MessageType type, const void* payload, uint32_t length) {
+    if (fd_ < 0) {
+        return fail("not connected");
+    }
+    std::string frame;
+    appendFrame(frame, type, payload, length);
+    size_t sent = 0;
+    while (sent < frame.size()) {
+        const ssize_t n = ::send(fd_, frame.data() + sent, frame.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            const int err = errno;
+            close();
+            return fail(std::strerror(err));
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool MeterClient::receive(FrameHeader& header, std::string& payload, int timeoutMs) {
+    if (fd_ < 0) {
+        return fail("not connected");
+    }
+    for (;;) {
+        if (peekFrame(buffer_.data(), buffer_.size(), header)) {
+            if (header.version != kVersion || header.length > kMaxPayload) {
+                close();
+                return fail("daemon speaks another protocol version");
+            }
+            if (buffer_.size() >= sizeof(FrameHeader) + header.length) {
+                payload.assign(buffer_, sizeof(FrameHeader), header.length);
+                buffer_.erase(0, sizeof(FrameHeader) + header.length);
+                return true;
+            }
+        }
+        pollfd pfd = {fd_, POLLIN, 0};
+        const int ready = ::poll(&pfd, 1, timeoutMs);
+        if (ready == 0) {
+            return fail("timed out");
+        }
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            return fail(std::strerror(errno));
+        }
+        char chunk[16 * 1024];
+        const ssize_t n = ::recv(fd_, chunk, sizeof(chunk), 0);
+        if (n == 0) {
+            close();
+            return fail("daemon closed the connection");
+        }
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            const int err = errno;
+            close();
+            return fail(std::strerror(err));
+        }
+        buffer_.append(chunk, static_cast<size_t>(n));
+    }
+}
+
+bool MeterClient::request(MessageType type, const void* payload, uint32_t length,
+                          MessageType expected, std::string& reply) {
+    if (!send(type, payload, length)) {
+        return false;
+    }
+    FrameHeader header;
+    for (;;) {
+        if (!receive(header, reply, 5000)) {
+            return false;
+        }
+        // Samples still in flight from a subscription are skipped
+        if (header.type == static_cast<uint16_t>(MessageType::Sample)) {
+            continue;
+        }
+        if (header.type == static_cast<uint16_t>(MessageType::Error)) {
+            ErrorReply err;
+            std::memset(&err, 0, sizeof(err));
+            std::memcpy(&err, reply.data(), std::min(reply.size(), sizeof(err)));
+            err.message[sizeof(err.message) - 1] = '\0';
+            return fail(err.message);
+        }
+        if (header.type != static_cast<uint16_t>(expected)) {
+            return fail("unexpected reply");
+        }
+        return true;
+    }
+}
+
+bool MeterClient::snapshot(MetricsSnapshot& out) {
+    std::string reply;
+    if (!request(MessageType::GetSnapshot, nullptr, 0, MessageType::Snapshot, reply)) {
+        return false;
+    }
+    if (reply.size() != sizeof(out)) {
+        return fail("malformed snapshot");
+    }
+    std::memcpy(&out, reply.data(), sizeof(out));
+    return true;
+}
+
+bool MeterClient::history(MessageType type, MessageType expected,
+                          const std::string& first, const std::string& last,
+                          std::vector<HistoryRow>& out) {
+    HistoryRequest query;
+    copyField(query.first, first);
+    copyField(query.last, last);
+    std::string reply;
+    if (!request(type, &query, sizeof(query), expected, reply)) {
+        return false;
+    }
+    if (reply.size() % sizeof(HistoryRow) != 0) {
+        return fail("malformed history");
+    }
+    out.resize(reply.size() / sizeof(HistoryRow));
+    if (!out.empty()) {
+        std::memcpy(&out[0], reply.data(), reply.size());
+    }
+    return true;
+}
+
+bool MeterClient::days(const std::string& first, const std::string& last, std::vector<HistoryRow>& out) {
+    return history(MessageType::GetDays, MessageType::Days, first, last, out);
+}
+
+bool MeterClient::months(const std::string& first, const std::string& last, std::vector<HistoryRow>& out) {
+    return history(MessageType::GetMonths, MessageType::Months, first, last, out);
+}
+
+bool MeterClient::subscribe(uint32_t every) {
+    SubscribeRequest subscription;
+    subscription.every = every;
+    return send(MessageType::Subscribe, &subscription, sizeof(subscription));
+}
+
+bool MeterClient::unsubscribe() {
+    return send(MessageType::Unsubscribe, nullptr, 0);
+}
+
+bool MeterClient::nextSample(MetricsSnapshot& out, int timeoutMs) {
+    FrameHeader header;
+    std::string payload;
+    for (;;) {
+        if (!receive(header, payload, timeoutMs)) {
+            return false;
+        }
+        if (header.type == static_cast<uint16_t>(MessageType::Sample) && payload.size() == sizeof(out)) {
+            std::memcpy(&out, payload.data(), sizeof(out));
+            return true;
+        }
+    }
+}
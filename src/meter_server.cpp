@@ -0,0 +1,682 @@
+#include "../include/meter_server.h"
+#include "../include/data_manager.h"
+#include "../include/logger.h"
+#include "../include/speed_monitor.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace meter_protocol;
+
+namespace {
+
+constexpr int kSaveIntervalSeconds = 60;  // same cadence as the tray
+constexpr int kMaxEvents = 64;
+constexpr size_t kReadChunk = 4096;
+constexpr size_t kMaxHttpRequest = 8192;
+// Input buffered per protocol client: one largest frame and the start of
+// the next one pipelined behind it
+constexpr size_t kMaxFrameInput = 2 * (sizeof(FrameHeader) + kMaxPayload);
+
+const char kNotFound[] =
+    "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: 10\r\n"
+    "Connection: close\r\n\r\nnot found\n";
+const char kBadRequest[] =
+    "HTTP/1.1 400 Bad Request\r\nContent-Type: text/plain\r\nContent-Length: 12\r\n"
+    "Connection: close\r\n\r\nbad request\n";
+const char kMethodNotAllowed[] =
+    "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET\r\nContent-Type: text/plain\r\nContent-Length: 19\r\n"
+    "Connection: close\r\n\r\nmethod not allowed\n";
+
+// "[ADDRESS:]PORT" as an IPv4 socket address
+bool parseListenAddress(const std::string& text, sockaddr_in& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    const size_t colon = text.rfind(':');
+    const std::string host = colon == std::string::npos ? "127.0.0.1" : text.substr(0, colon);
+    const std::string port = colon == std::string::npos ? text : text.substr(colon + 1);
+    char* end = nullptr;
+    const unsigned long number = std::strtoul(port.c_str(), &end, 10);
+    if (port.empty() || *end != '\0' || number == 0 || number > 65535) {
+        return false;
+    }
+    addr.sin_port = htons(static_cast<uint16_t>(number));
+    return ::inet_pton(AF_INET, host.empty() ? "0.0.0.0" : host.c_str(), &addr.sin_addr) == 1;
+}
+
+bool startsWithNoCase(const std::string& text, size_t at, const char* prefix) {
+    for (size_t i = 0; prefix[i] != '\0'; ++i) {
+        if (at + i >= text.size() || std::tolower(static_cast<unsigned char>(text[at + i])) != prefix[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// HTTP/1.1 keeps the connection unless the request says "Connection:
+// close"; HTTP/1.0 closes it
+bool wantsKeepAlive(const std::string& request, size_t headerEnd) {
+    const size_t lineEnd = request.find("\r\n");
+    if (lineEnd == std::string::npos || lineEnd < 8 || request.compare(lineEnd - 8, 8, "HTTP/1.1") != 0) {
+        return false;
+    }
+    for (size_t at = lineEnd + 2; at < headerEnd; at = request.find("\r\n", at) + 2) {
+        if (startsWithNoCase(request, at, "connection:")) {
+            size_t value = at + 11;
+            while (value < headerEnd && request[value] == ' ') ++value;
+            return !startsWithNoCase(request, value, "close");
+        }
+    }
+    return true;
+}
+
+bool fillAddress(const std::string& path, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    path.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+    return true;
+}
+
+// A daemon still answers on path
+bool socketInUse(const sockaddr_un& addr) {
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    const bool answered = ::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0;
+    ::close(fd);
+    return answered;
+}
+
+std::string terminated(const char* field, size_t size) {
+    return std::string(field, strnlen(field, size));
+}
+
+} // namespace
+
+MeterServer::MeterServer(SpeedMeter& meter, DataManager& data)
+    : meter_(meter),
+      data_(data),
+      listenFd_(-1),
+      epollFd_(-1),
+      stopFd_(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
+      saveTimerFd_(-1),
+      metricsFd_(-1),
+      usage_(),
+      usageGeneration_(0),
+      lastSaveNs_(SampleScheduler::monotonicNs()),
+      saved_(meter.get_snapshot()) {
+}
+
+MeterServer::~MeterServer() {
+    std::vector<int> fds;
+    for (const auto& entry : clients_) {
+        fds.push_back(entry.first);
+    }
+    for (int fd : fds) {
+        closeClient(fd);
+    }
+    if (listenFd_ >= 0) {
+        ::close(listenFd_);
+        ::unlink(path_.c_str());
+    }
+    if (metricsFd_ >= 0) ::close(metricsFd_);
+    if (saveTimerFd_ >= 0) ::close(saveTimerFd_);
+    if (epollFd_ >= 0) ::close(epollFd_);
+    if (stopFd_ >= 0) ::close(stopFd_);
+}
+
+bool MeterServer::open(const std::string& path) {
+    sockaddr_un addr;
+    if (!fillAddress(path, addr)) {
+        LOG_ERROR("Socket path unusable", logging::field("path", path));
+        return false;
+    }
+    if (socketInUse(addr)) {
+        LOG_ERROR("Another speed-meterd is serving", logging::field("path", path));
+        return false;
+    }
+    ::unlink(path.c_str()); // stale socket of a daemon that died
+
+    listenFd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (listenFd_ < 0) {
+        LOG_ERROR("socket() failed", logging::field("error", std::strerror(errno)));
+        return false;
+    }
+    // Owner-only from the moment the socket exists
+    const mode_t previous = ::umask(0177);
+    const int bound = ::bind(listenFd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+    ::umask(previous);
+    if (bound != 0 || ::listen(listenFd_, 16) != 0) {
+        LOG_ERROR("Cannot listen", logging::field("path", path), logging::field("error", std::strerror(errno)));
+        ::close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+    path_ = path;
+    LOG_INFO("Listening", logging::field("path", path));
+    return true;
+}
+
+bool MeterServer::openMetrics(const std::string& address) {
+    sockaddr_in addr;
+    if (!parseListenAddress(address, addr)) {
+        LOG_ERROR("Metrics address unusable", logging::field("address", address));
+        return false;
+    }
+    metricsFd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (metricsFd_ < 0) {
+        LOG_ERROR("socket() failed", logging::field("error", std::strerror(errno)));
+        return false;
+    }
+    const int on = 1;
+    ::setsockopt(metricsFd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (::bind(metricsFd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(metricsFd_, 16) != 0) {
+        LOG_ERROR("Cannot listen for metrics", logging::field("address", address),
+                  logging::field("error", std::strerror(errno)));
+        ::close(metricsFd_);
+        metricsFd_ = -1;
+        return false;
+    }
+    LOG_INFO("Serving Prometheus metrics", logging::field("address", address));
+    return true;
+}
+
+void MeterServer::stop() {
+    if (stopFd_ >= 0) {
+        const uint64_t one = 1;
+        ssize_t ignored = ::write(stopFd_, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+bool MeterServer::run() {
+    const int sampleFd = meter_.sample_event_fd();
+    saveTimerFd_ = ::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    if (listenFd_ < 0 || sampleFd < 0 || stopFd_ < 0 || saveTimerFd_ < 0 || epollFd_ < 0) {
+        LOG_ERROR("Cannot set up the event loop");
+        return false;
+    }
+    itimerspec every = itimerspec();
+    every.it_value.tv_sec = kSaveIntervalSeconds;
+    every.it_interval.tv_sec = kSaveIntervalSeconds;
+    ::timerfd_settime(saveTimerFd_, 0, &every, nullptr);
+
+    refreshUsage();
+
+    for (int fd : {listenFd_, sampleFd, stopFd_, saveTimerFd_, metricsFd_}) {
+        if (fd < 0) {
+            continue; // no metrics listener
+        }
+        epoll_event event = epoll_event();
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            LOG_ERROR("epoll_ctl failed", logging::field("error", std::strerror(errno)));
+            return false;
+        }
+    }
+
+    epoll_event events[kMaxEvents];
+    bool running = true;
+    while (running) {
+        const int ready = ::epoll_wait(epollFd_, events, kMaxEvents, -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            LOG_ERROR("epoll_wait failed", logging::field("error", std::strerror(errno)));
+            break;
+        }
+        for (int i = 0; i < ready; ++i) {
+            const int fd = events[i].data.fd;
+            uint64_t count;
+            if (fd == stopFd_) {
+                running = false;
+            } else if (fd == listenFd_) {
+                accept(listenFd_, false);
+            } else if (fd == metricsFd_) {
+                accept(metricsFd_, true);
+            } else if (fd == sampleFd) {
+                ssize_t ignored = ::read(sampleFd, &count, sizeof(count));
+                (void)ignored;
+                publishSample();
+            } else if (fd == saveTimerFd_) {
+                ssize_t ignored = ::read(saveTimerFd_, &count, sizeof(count));
+                (void)ignored;
+                saveUsage();
+            } else {
+                auto it = clients_.find(fd);
+                if (it == clients_.end()) {
+                    continue; // closed earlier in this batch
+                }
+                Client& client = it->second;
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    closeClient(fd);
+                    continue;
+                }
+                if ((events[i].events & EPOLLOUT) && !flush(client)) {
+                    continue;
+                }
+                if (events[i].events & EPOLLIN) {
+                    readFrom(client);
+                }
+            }
+        }
+    }
+    saveUsage();
+    return true;
+}
+
+void MeterServer::accept(int listenFd, bool http) {
+    for (;;) {
+        const int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                LOG_WARN("accept failed", logging::field("error", std::strerror(errno)));
+            }
+            return;
+        }
+        epoll_event event = epoll_event();
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            ::close(fd);
+            continue;
+        }
+        Client client = Client();
+        client.fd = fd;
+        client.every = 1;
+        client.http = http;
+        clients_[fd] = client;
+        LOG_DEBUG("Client connected", logging::field("fd", fd),
+                  logging::field("clients", static_cast<unsigned long>(clients_.size())));
+    }
+}
+
+// Reads at most one request's worth past what is buffered: epoll is
+// level-triggered, so the rest is read once this much has been handled,
+// and a peer that keeps writing cannot grow the buffer or hold the loop.
+void MeterServer::readFrom(Client& client) {
+    const int fd = client.fd;
+    if (client.closeAfterFlush) {
+        // Its last response is queued; ignore anything else it sends
+        watch(client);
+        return;
+    }
+    const size_t limit = client.http ? kMaxHttpRequest : kMaxFrameInput;
+    char chunk[kReadChunk];
+    while (client.in.size() < limit) {
+        const size_t wanted = std::min(sizeof(chunk), limit - client.in.size());
+        const ssize_t n = ::recv(fd, chunk, wanted, 0);
+        if (n == 0) {
+            closeClient(fd);
+            return;
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                closeClient(fd);
+                return;
+            }
+            break;
+        }
+        client.in.append(chunk, static_cast<size_t>(n));
+    }
+    if (client.http) {
+        serveHttp(client);
+        return;
+    }
+
+    size_t offset = 0;
+    FrameHeader header;
+    while (peekFrame(client.in.data() + offset, client.in.size() - offset, header)) {
+        if (header.version != kVersion || header.length > kMaxPayload) {
+            LOG_WARN("Dropping client with a bad frame", logging::field("fd", fd),
+                     logging::field("version", static_cast<unsigned>(header.version)));
+            closeClient(fd);
+            return;
+        }
+        if (client.in.size() - offset < sizeof(FrameHeader) + header.length) {
+            break; // rest of the frame still in flight
+        }
+        if (!handleFrame(client, header, client.in.data() + offset + sizeof(FrameHeader))) {
+            return; // client closed
+        }
+        offset += sizeof(FrameHeader) + header.length;
+    }
+    client.in.erase(0, offset);
+}
+
+bool MeterServer::handleFrame(Client& client, const FrameHeader& header, const char* payload) {
+    switch (static_cast<MessageType>(header.type)) {
+    case MessageType::GetSnapshot: {
+        const MetricsSnapshot snapshot = meter_.get_snapshot();
+        std::string frame;
+        appendFrame(frame, MessageType::Snapshot, &snapshot, sizeof(snapshot));
+        return enqueue(client, frame, false);
+    }
+    case MessageType::Subscribe: {
+        SubscribeRequest subscription;
+        if (header.length != sizeof(subscription)) {
+            break;
+        }
+        std::memcpy(&subscription, payload, sizeof(subscription));
+        client.subscribed = true;
+        client.every = std::max<uint32_t>(1, subscription.every);
+        client.seen = 0;
+        return true;
+    }
+    case MessageType::Unsubscribe:
+        client.subscribed = false;
+        return true;
+    case MessageType::GetDays:
+    case MessageType::GetMonths: {
+        HistoryRequest query;
+        if (header.length != sizeof(query)) {
+            break;
+        }
+        std::memcpy(&query, payload, sizeof(query));
+        const int fd = client.fd;
+        history(client, header.type == static_cast<uint16_t>(MessageType::GetMonths), query);
+        return clients_.count(fd) != 0;
+    }
+    default:
+        break;
+    }
+    const int fd = client.fd;
+    sendError(client, ErrorCode::BadRequest, "malformed or unknown request");
+    return clients_.count(fd) != 0;
+}
+
+// One response per complete request; pipelined requests are answered in
+// order. A metrics response is the exposition's prebuilt buffer, so a
+// scrape between two samples does no formatting at all.
+void MeterServer::serveHttp(Client& client) {
+    const int fd = client.fd;
+    for (;;) {
+        const size_t headerEnd = client.in.find("\r\n\r\n");
+        if (headerEnd == std::string::npos) {
+            if (client.in.size() >= kMaxHttpRequest) {
+                client.closeAfterFlush = true;
+                enqueue(client, kBadRequest, false);
+            }
+            return;
+        }
+        const size_t methodEnd = client.in.find(' ');
+        const size_t targetEnd = methodEnd == std::string::npos ? std::string::npos : client.in.find(' ', methodEnd + 1);
+        if (targetEnd == std::string::npos || targetEnd > headerEnd) {
+            client.closeAfterFlush = true;
+            enqueue(client, kBadRequest, false);
+            return;
+        }
+        const std::string method = client.in.substr(0, methodEnd);
+        std::string target = client.in.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+        target = target.substr(0, target.find('?'));
+        const bool keepAlive = wantsKeepAlive(client.in, headerEnd);
+        client.in.erase(0, headerEnd + 4);
+
+        if (method != "GET") {
+            client.closeAfterFlush = true;
+            enqueue(client, kMethodNotAllowed, false);
+            return;
+        }
+        if (target != "/metrics") {
+            client.closeAfterFlush = true;
+            enqueue(client, kNotFound, false);
+            return;
+        }
+
+        // The writer commits on its own schedule, so its figures are read
+        // per scrape; the response is rendered again only if they moved
+        const PersistenceStats persistence = data_.getPersistenceStats();
+        if (persistence.commits != usage_.persistence.commits ||
+            persistence.queue_depth != usage_.persistence.queue_depth) {
+            usage_.persistence = persistence;
+            ++usageGeneration_;
+        }
+        MetricsSnapshot snapshot = meter_.get_snapshot();
+        UsageTotals usage = usage_;
+        // Add what has been counted since the last save
+        usage.today_download_bytes += snapshot.total_rx_bytes - saved_.total_rx_bytes;
+        usage.today_upload_bytes += snapshot.total_tx_bytes - saved_.total_tx_bytes;
+        usage.month_download_bytes += snapshot.total_rx_bytes - saved_.total_rx_bytes;
+        usage.month_upload_bytes += snapshot.total_tx_bytes - saved_.total_tx_bytes;
+        client.closeAfterFlush = !keepAlive;
+        if (!enqueue(client, exposition_.response(snapshot, usage, usageGeneration_, keepAlive), false) ||
+            clients_.count(fd) == 0 || !keepAlive) {
+            return;
+        }
+    }
+}
+
+void MeterServer::history(Client& client, bool months, const HistoryRequest& query) {
+    const std::string first = terminated(query.first, sizeof(query.first));
+    std::string last = terminated(query.last, sizeof(query.last));
+    if (last.empty()) {
+        last = "9999"; // sorts after every date and month
+    }
+
+    std::vector<HistoryRow> rows;
+    auto fill = [&rows](const std::string& period, uint32_t activeDays,
+                        uint64_t down, uint64_t up, uint64_t downPackets, uint64_t upPackets,
+                        uint64_t downDropped, uint64_t upDropped,
+                        double peakDown, double peakUp, const RateDigest& rates) {
+        HistoryRow row = HistoryRow();
+        copyField(row.period, period);
+        row.active_days = activeDays;
+        row.download_bytes = down;
+        row.upload_bytes = up;
+        row.download_packets = downPackets;
+        row.upload_packets = upPackets;
+        row.download_dropped = downDropped;
+        row.upload_dropped = upDropped;
+        row.peak_download = peakDown;
+        row.peak_upload = peakUp;
+        const double quantiles[3] = {0.50, 0.95, 0.99};
+        for (int i = 0; i < 3; ++i) {
+            row.download_percentiles[i] = rates.download.percentile(quantiles[i]);
+            row.upload_percentiles[i] = rates.upload.percentile(quantiles[i]);
+        }
+        rows.push_back(row);
+    };
+    if (months) {
+        for (const MonthlyStats& m : data_.getMonthlyStatsRange(first, last)) {
+            fill(m.month, m.active_days, m.total_download_bytes, m.total_upload_bytes,
+                 m.total_download_packets, m.total_upload_packets, m.download_dropped, m.upload_dropped,
+                 m.peak_download_speed, m.peak_upload_speed, m.rates);
+        }
+    } else {
+        for (const DailyStats& d : data_.getDailyStatsRange(first, last)) {
+            fill(d.date, 1, d.total_download_bytes, d.total_upload_bytes,
+                 d.total_download_packets, d.total_upload_packets, d.download_dropped, d.upload_dropped,
+                 d.peak_download_speed, d.peak_upload_speed, d.rates);
+        }
+    }
+    // Keep the most recent rows when the range is longer than one reply
+    if (rows.size() > kMaxHistoryRows) {
+        rows.erase(rows.begin(), rows.end() - kMaxHistoryRows);
+    }
+
+    std::string frame;
+    appendFrame(frame, months ? MessageType::Months : MessageType::Days,
+                rows.empty() ? nullptr : &rows[0], static_cast<uint32_t>(rows.size() * sizeof(HistoryRow)));
+    enqueue(client, frame, false);
+}
+
+void MeterServer::sendError(Client& client, ErrorCode code, const char* message) {
+    ErrorReply reply = ErrorReply();
+    reply.code = static_cast<uint32_t>(code);
+    std::strncpy(reply.message, message, sizeof(reply.message) - 1);
+    std::string frame;
+    appendFrame(frame, MessageType::Error, &reply, sizeof(reply));
+    enqueue(client, frame, false);
+}
+
+void MeterServer::publishSample() {
+    const MetricsSnapshot snapshot = meter_.get_snapshot();
+    sampleFrame_.clear();
+    appendFrame(sampleFrame_, MessageType::Sample, &snapshot, sizeof(snapshot));
+
+    std::vector<int> subscribers;
+    for (auto& entry : clients_) {
+        Client& client = entry.second;
+        if (client.subscribed && client.seen++ % client.every == 0) {
+            subscribers.push_back(entry.first);
+        }
+    }
+    // enqueue() may close a client, so walk a copy of the fds
+    for (int fd : subscribers) {
+        auto it = clients_.find(fd);
+        if (it != clients_.end()) {
+            enqueue(it->second, sampleFrame_, true);
+        }
+    }
+}
+
+bool MeterServer::enqueue(Client& client, const std::string& frame, bool droppable) {
+    const size_t queued = client.out.size() - client.sent;
+    if (queued + frame.size() > kMaxQueuedBytes) {
+        if (droppable) {
+            ++client.dropped;
+            return true;
+        }
+        LOG_WARN("Client not reading; disconnecting", logging::field("fd", client.fd),
+                 logging::field("queued", static_cast<unsigned long>(queued)));
+        closeClient(client.fd);
+        return false;
+    }
+    if (client.sent > 0 && client.sent == client.out.size()) {
+        client.out.clear();
+        client.sent = 0;
+    }
+    client.out += frame;
+    // Nothing else queued: try to write right away and skip the EPOLLOUT
+    // round trip
+    return client.waitingWritable || flush(client);
+}
+
+bool MeterServer::flush(Client& client) {
+    while (client.sent < client.out.size()) {
+        const ssize_t n = ::send(client.fd, client.out.data() + client.sent,
+                                 client.out.size() - client.sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                setWritable(client, true);
+                // Drop what was written so the buffer does not grow forever
+                if (client.sent > kMaxQueuedBytes / 2) {
+                    client.out.erase(0, client.sent);
+                    client.sent = 0;
+                }
+                return true;
+            }
+            closeClient(client.fd);
+            return false;
+        }
+        client.sent += static_cast<size_t>(n);
+    }
+    client.out.clear();
+    client.sent = 0;
+    if (client.closeAfterFlush) {
+        closeClient(client.fd);
+        return false;
+    }
+    setWritable(client, false);
+    return true;
+}
+
+void MeterServer::setWritable(Client& client, bool wanted) {
+    if (client.waitingWritable == wanted) {
+        return;
+    }
+    client.waitingWritable = wanted;
+    watch(client);
+}
+
+void MeterServer::watch(Client& client) {
+    epoll_event event = epoll_event();
+    if (!client.closeAfterFlush) {
+        event.events |= EPOLLIN;
+    }
+    if (client.waitingWritable) {
+        event.events |= EPOLLOUT;
+    }
+    event.data.fd = client.fd;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_MOD, client.fd, &event);
+}
+
+void MeterServer::closeClient(int fd) {
+    auto it = clients_.find(fd);
+    if (it == clients_.end()) {
+        return;
+    }
+    if (it->second.dropped > 0) {
+        LOG_INFO("Slow subscriber lost samples", logging::field("fd", fd),
+                 logging::field("dropped", static_cast<unsigned long long>(it->second.dropped)));
+    }
+    if (epollFd_ >= 0) {
+        ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+    }
+    ::close(fd);
+    clients_.erase(it);
+}
+
+// Same bookkeeping as the tray's once-a-minute save: increments since the
+// previous save plus the rate samples taken in between
+void MeterServer::saveUsage() {
+    const MetricsSnapshot now = meter_.get_snapshot();
+    const int64_t nowNs = SampleScheduler::monotonicNs();
+    const long long seconds = std::llround(static_cast<double>(nowNs - lastSaveNs_) / 1e9);
+    lastSaveNs_ = nowNs;
+
+    PacketActivity packets = PacketActivity();
+    packets.download_packets = now.total_rx_packets - saved_.total_rx_packets;
+    packets.upload_packets = now.total_tx_packets - saved_.total_tx_packets;
+    packets.download_dropped = now.total_rx_dropped - saved_.total_rx_dropped;
+    packets.upload_dropped = now.total_tx_dropped - saved_.total_tx_dropped;
+    packets.download_errors = now.total_rx_errors - saved_.total_rx_errors;
+    packets.upload_errors = now.total_tx_errors - saved_.total_tx_errors;
+    packets.download_packet_rate = now.rx_packet_rate;
+    packets.upload_packet_rate = now.tx_packet_rate;
+
+    data_.recordRates(meter_.take_rate_samples());
+    data_.updateDailyStats(now.total_rx_bytes - saved_.total_rx_bytes,
+                           now.total_tx_bytes - saved_.total_tx_bytes,
+                           now.rx_rate, now.tx_rate,
+                           std::chrono::seconds(seconds), packets);
+    saved_ = now;
+    refreshUsage();
+}
+
+void MeterServer::refreshUsage() {
+    if (metricsFd_ < 0) {
+        return;
+    }
+    const DailyStats today = data_.getTodayStats();
+    const MonthlyStats month = data_.getCurrentMonthStats();
+    usage_.today_download_bytes = today.total_download_bytes;
+    usage_.today_upload_bytes = today.total_upload_bytes;
+    usage_.month_download_bytes = month.total_download_bytes;
+    usage_.month_upload_bytes = month.total_upload_bytes;
+    usage_.data_limit_bytes = data_.getDataLimit();
+    usage_.has_speed_test = data_.getLastSpeedTest(usage_.speed_test);
+    ++usageGeneration_;
+}
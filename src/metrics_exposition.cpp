@@ -0,0 +1,181 @@
+#include "../include/metrics_exposition.h"
+#include <cinttypes>
+#include <cstdio>
+
+namespace {
+
+// Appends "# HELP", "# TYPE" and one sample line per metric
+class Writer {
+public:
+    Writer(std::string& out, const std::string& labels) : out_(out), labels_(labels) {}
+
+    void counter(const char* name, const char* help, uint64_t value) {
+        header(name, help, "counter");
+        char number[32];
+        std::snprintf(number, sizeof(number), "%" PRIu64, value);
+        sample(name, number);
+    }
+
+    void gauge(const char* name, const char* help, double value) {
+        header(name, help, "gauge");
+        char number[32];
+        std::snprintf(number, sizeof(number), "%.12g", value);
+        sample(name, number);
+    }
+
+    void gauge(const char* name, const char* help, uint64_t value) {
+        header(name, help, "gauge");
+        char number[32];
+        std::snprintf(number, sizeof(number), "%" PRIu64, value);
+        sample(name, number);
+    }
+
+private:
+    void sample(const char* name, const char* number) {
+        out_ += name;
+        out_ += labels_;
+        out_ += ' ';
+        out_ += number;
+        out_ += '\n';
+    }
+
+    void header(const char* name, const char* help, const char* type) {
+        out_ += "# HELP ";
+        out_ += name;
+        out_ += ' ';
+        out_ += help;
+        out_ += "\n# TYPE ";
+        out_ += name;
+        out_ += ' ';
+        out_ += type;
+        out_ += '\n';
+    }
+
+    std::string& out_;
+    const std::string& labels_;
+};
+
+// Label value with \, " and newline escaped as the text format requires
+std::string labelValue(const char* value, size_t size) {
+    std::string escaped;
+    for (size_t i = 0; i < size && value[i] != '\0'; ++i) {
+        const char c = value[i];
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+void buildResponse(std::string& out, const std::string& body, bool keepAlive) {
+    char headers[192];
+    std::snprintf(headers, sizeof(headers),
+                  "HTTP/1.1 200 OK\r\n"
+                  "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                  "Content-Length: %zu\r\n"
+                  "Connection: %s\r\n\r\n",
+                  body.size(), keepAlive ? "keep-alive" : "close");
+    out.clear();
+    out += headers;
+    out += body;
+}
+
+} // namespace
+
+MetricsExposition::MetricsExposition()
+    : seq_(0), generation_(0), valid_(false), renders_(0) {
+}
+
+const std::string& MetricsExposition::response(const MetricsSnapshot& snapshot, const UsageTotals& usage,
+                                               uint64_t usageGeneration, bool keepAlive) {
+    if (!valid_ || snapshot.seq != seq_ || usageGeneration != generation_) {
+        render(snapshot, usage);
+        buildResponse(response_, body_, true);
+        buildResponse(closing_, body_, false);
+        seq_ = snapshot.seq;
+        generation_ = usageGeneration;
+        valid_ = true;
+        ++renders_;
+    }
+    return keepAlive ? response_ : closing_;
+}
+
+void MetricsExposition::render(const MetricsSnapshot& s, const UsageTotals& usage) {
+    body_.clear();
+    const std::string iface = "{interface=\"" + labelValue(s.iface, sizeof(s.iface)) + "\"}";
+    const std::string none;
+
+    Writer link(body_, iface);
+    link.gauge("speed_meter_up", "1 while the monitored interface is being sampled", uint64_t(1));
+    link.counter("speed_meter_samples_total", "Samples taken since the collector started", s.seq);
+    link.gauge("speed_meter_sample_period_seconds", "Current sampling period",
+               s.sample_period_ms / 1000.0);
+    link.counter("speed_meter_receive_bytes_total", "Bytes received since the collector started",
+                 s.total_rx_bytes);
+    link.counter("speed_meter_transmit_bytes_total", "Bytes sent since the collector started",
+                 s.total_tx_bytes);
+    link.counter("speed_meter_receive_packets_total", "Packets received since the collector started",
+                 s.total_rx_packets);
+    link.counter("speed_meter_transmit_packets_total", "Packets sent since the collector started",
+                 s.total_tx_packets);
+    link.counter("speed_meter_receive_drops_total", "Received packets dropped since the collector started",
+                 s.total_rx_dropped);
+    link.counter("speed_meter_transmit_drops_total", "Sent packets dropped since the collector started",
+                 s.total_tx_dropped);
+    link.counter("speed_meter_receive_errors_total", "Receive errors since the collector started",
+                 s.total_rx_errors);
+    link.counter("speed_meter_transmit_errors_total", "Transmit errors since the collector started",
+                 s.total_tx_errors);
+    link.gauge("speed_meter_receive_bytes_per_second", "Smoothed download rate", s.rx_rate);
+    link.gauge("speed_meter_transmit_bytes_per_second", "Smoothed upload rate", s.tx_rate);
+    link.gauge("speed_meter_receive_packets_per_second", "Smoothed received packet rate", s.rx_packet_rate);
+    link.gauge("speed_meter_transmit_packets_per_second", "Smoothed sent packet rate", s.tx_packet_rate);
+
+    Writer totals(body_, none);
+    totals.gauge("speed_meter_today_download_bytes", "Bytes downloaded today", usage.today_download_bytes);
+    totals.gauge("speed_meter_today_upload_bytes", "Bytes uploaded today", usage.today_upload_bytes);
+    totals.gauge("speed_meter_month_download_bytes", "Bytes downloaded this month", usage.month_download_bytes);
+    totals.gauge("speed_meter_month_upload_bytes", "Bytes uploaded this month", usage.month_upload_bytes);
+    totals.gauge("speed_meter_data_limit_bytes", "Monthly data limit; 0 when none is set",
+                 usage.data_limit_bytes);
+    if (usage.data_limit_bytes > 0) {
+        const double used = static_cast<double>(usage.month_download_bytes + usage.month_upload_bytes);
+        totals.gauge("speed_meter_data_limit_used_ratio", "Share of the monthly data limit used",
+                     used / static_cast<double>(usage.data_limit_bytes));
+    }
+
+    const PersistenceStats& p = usage.persistence;
+    totals.counter("speed_meter_persist_commits_total", "Batches committed by the usage writer", p.commits);
+    totals.counter("speed_meter_persist_records_total", "Usage journal records made durable", p.records);
+    totals.counter("speed_meter_persist_snapshots_total", "Rewrites of usage_data.txt", p.snapshots);
+    totals.counter("speed_meter_persist_failures_total", "Usage writer batches that hit an I/O error",
+                   p.failures);
+    totals.gauge("speed_meter_persist_commit_seconds_total", "Time spent committing usage batches",
+                 p.commit_seconds_total);
+    totals.gauge("speed_meter_persist_last_commit_seconds", "Duration of the latest usage commit",
+                 p.last_commit_seconds);
+    totals.gauge("speed_meter_persist_max_commit_seconds", "Longest usage commit", p.max_commit_seconds);
+    totals.gauge("speed_meter_persist_queue_depth", "Usage journal records waiting for a commit",
+                 static_cast<uint64_t>(p.queue_depth));
+
+    if (usage.has_speed_test) {
+        const std::string server = "{server=\"" +
+            labelValue(usage.speed_test.server.c_str(), usage.speed_test.server.size()) + "\"}";
+        Writer test(body_, server);
+        test.gauge("speed_meter_speed_test_timestamp_seconds", "Unix time the last speed test finished",
+                   static_cast<double>(usage.speed_test.unix_time));
+        test.gauge("speed_meter_speed_test_download_bits_per_second", "Download speed of the last speed test",
+                   usage.speed_test.download_mbps * 1e6);
+        test.gauge("speed_meter_speed_test_upload_bits_per_second", "Upload speed of the last speed test",
+                   usage.speed_test.upload_mbps * 1e6);
+        test.gauge("speed_meter_speed_test_ping_seconds", "Ping of the last speed test",
+                   usage.speed_test.ping_ms / 1000.0);
+        test.gauge("speed_meter_speed_test_jitter_seconds", "Ping jitter of the last speed test",
+                   usage.speed_test.jitter_ms / 1000.0);
+    }
+}
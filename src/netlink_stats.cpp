@@ -0,0 +1,173 @@
+#include "../include/netlink_stats.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_link.h>
+
+namespace {
+
+// One RTM_NEWLINK reply is a few KB; leave room for drivers that attach
+// large IFLA_AF_SPEC / VF blocks
+constexpr size_t kReceiveBufferSize = 32 * 1024;
+
+struct LinkRequest {
+    nlmsghdr header;
+    ifinfomsg info;
+};
+
+// Same folding as /proc/net/dev, so both backends report identical values
+template <typename LinkStats>
+void copyStats(const LinkStats& src, NetStats& stats) {
+    stats.rx_bytes = src.rx_bytes;
+    stats.tx_bytes = src.tx_bytes;
+    stats.rx_packets = src.rx_packets;
+    stats.tx_packets = src.tx_packets;
+    stats.rx_errors = src.rx_errors;
+    stats.tx_errors = src.tx_errors;
+    stats.rx_dropped = static_cast<uint64_t>(src.rx_dropped) + src.rx_missed_errors;
+    stats.tx_dropped = src.tx_dropped;
+    stats.rx_fifo = src.rx_fifo_errors;
+    stats.tx_fifo = src.tx_fifo_errors;
+    stats.rx_frame = static_cast<uint64_t>(src.rx_length_errors) + src.rx_over_errors + src.rx_crc_errors +
+                     src.rx_frame_errors;
+    stats.tx_collisions = src.collisions;
+    stats.tx_carrier = static_cast<uint64_t>(src.tx_carrier_errors) + src.tx_aborted_errors +
+                       src.tx_window_errors + src.tx_heartbeat_errors;
+    stats.rx_compressed = src.rx_compressed;
+    stats.tx_compressed = src.tx_compressed;
+    stats.rx_multicast = src.multicast;
+}
+
+// A kernel sends the stats struct as it had it: 4.6 added rx_nohandler
+// and 5.19 rx_otherhost_dropped, so older kernels send less than this
+// build's header. Copy what arrived over zeros; enough if it reaches the
+// last field copyStats() reads.
+template <typename LinkStats>
+bool readStats(rtattr* attr, LinkStats& out) {
+    const size_t size = RTA_PAYLOAD(attr);
+    if (size < offsetof(LinkStats, tx_compressed) + sizeof(out.tx_compressed)) {
+        return false;
+    }
+    std::memset(&out, 0, sizeof(out));
+    std::memcpy(&out, RTA_DATA(attr), std::min(size, sizeof(out)));
+    return true;
+}
+
+} // namespace
+
+NetlinkStatsBackend::NetlinkStatsBackend()
+    : fd_(-1), ifindex_(0), seq_(0), buf_(kReceiveBufferSize) {
+    fd_ = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd_ < 0) {
+        return;
+    }
+
+    sockaddr_nl local;
+    std::memset(&local, 0, sizeof(local));
+    local.nl_family = AF_NETLINK;
+    if (::bind(fd_, reinterpret_cast<sockaddr*>(&local), sizeof(local)) < 0) {
+        ::close(fd_);
+        fd_ = -1;
+        return;
+    }
+
+    // Never let a lost reply hang the sampler thread
+    timeval timeout;
+    timeout.tv_sec = 1;
+    timeout.tv_usec = 0;
+    ::setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+}
+
+NetlinkStatsBackend::~NetlinkStatsBackend() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+bool NetlinkStatsBackend::setInterface(const std::string& iface) {
+    unsigned int index = ::if_nametoindex(iface.c_str());
+    if (index == 0) {
+        return false;
+    }
+    ifindex_ = static_cast<int>(index);
+    return true;
+}
+
+bool NetlinkStatsBackend::read(NetStats& stats) {
+    return ifindex_ > 0 && readIndex(ifindex_, stats);
+}
+
+bool NetlinkStatsBackend::readIndex(int ifindex, NetStats& stats) {
+    if (fd_ < 0) {
+        return false;
+    }
+
+    LinkRequest request;
+    std::memset(&request, 0, sizeof(request));
+    request.header.nlmsg_len = NLMSG_LENGTH(sizeof(ifinfomsg));
+    request.header.nlmsg_type = RTM_GETLINK;
+    request.header.nlmsg_flags = NLM_F_REQUEST;
+    request.header.nlmsg_seq = ++seq_;
+    request.info.ifi_family = AF_UNSPEC;
+    request.info.ifi_index = ifindex;
+
+    ssize_t sent;
+    do {
+        sent = ::send(fd_, &request, request.header.nlmsg_len, 0);
+    } while (sent < 0 && errno == EINTR);
+    if (sent < 0) {
+        return false;
+    }
+
+    for (;;) {
+        ssize_t received = ::recv(fd_, buf_.data(), buf_.size(), 0);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        int remaining = static_cast<int>(received);
+        for (nlmsghdr* msg = reinterpret_cast<nlmsghdr*>(buf_.data());
+             NLMSG_OK(msg, remaining); msg = NLMSG_NEXT(msg, remaining)) {
+            if (msg->nlmsg_seq != seq_) {
+                continue; // late reply to an earlier, timed-out request
+            }
+            if (msg->nlmsg_type == NLMSG_ERROR) {
+                return false;
+            }
+            if (msg->nlmsg_type != RTM_NEWLINK) {
+                continue;
+            }
+
+            ifinfomsg* info = static_cast<ifinfomsg*>(NLMSG_DATA(msg));
+            int attrLen = static_cast<int>(IFLA_PAYLOAD(msg));
+            bool haveLegacy = false;
+            rtnl_link_stats legacy;
+            for (rtattr* attr = IFLA_RTA(info); RTA_OK(attr, attrLen);
+                 attr = RTA_NEXT(attr, attrLen)) {
+                rtnl_link_stats64 stats64;
+                if (attr->rta_type == IFLA_STATS64 && readStats(attr, stats64)) {
+                    copyStats(stats64, stats);
+                    return true;
+                }
+                if (attr->rta_type == IFLA_STATS && readStats(attr, legacy)) {
+                    haveLegacy = true;
+                }
+            }
+            if (haveLegacy) {
+                copyStats(legacy, stats);
+                return true;
+            }
+            return false;
+        }
+    }
+}
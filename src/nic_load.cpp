@@ -0,0 +1,525 @@
+#include "../include/nic_load.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/ethtool.h>
+#include <linux/sockios.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr size_t kInitialBufferSize = 16 * 1024;
+constexpr size_t kIrqBufferSize = 1024; // grows for hosts with hundreds of CPUs
+constexpr size_t kStatNameLength = 32; // ETH_GSTRING_LEN
+
+inline bool isBlank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+inline bool isAlnum(char c) {
+    return isDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+const char* nextLine(const char* p, const char* end) {
+    const void* nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return nl ? static_cast<const char*>(nl) + 1 : end;
+}
+
+// Parse one unsigned column, skipping leading blanks; p stays put on failure
+bool parseColumn(const char*& p, const char* end, uint64_t& value) {
+    const char* q = p;
+    while (q < end && isBlank(*q)) ++q;
+    if (q >= end || !isDigit(*q)) {
+        return false;
+    }
+    uint64_t v = 0;
+    while (q < end && isDigit(*q)) {
+        v = v * 10 + static_cast<uint64_t>(*q - '0');
+        ++q;
+    }
+    value = v;
+    p = q;
+    return true;
+}
+
+// "CPU0 CPU1 CPU3" header -> CPU ids per column; returns the next line
+const char* parseCpuHeader(const char* p, const char* end, std::vector<int>& columnCpu) {
+    columnCpu.clear();
+    const char* lineEnd = nextLine(p, end);
+    while (p < lineEnd) {
+        while (p < lineEnd && (isBlank(*p) || *p == '\n')) ++p;
+        if (lineEnd - p > 3 && std::memcmp(p, "CPU", 3) == 0) {
+            p += 3;
+            uint64_t id;
+            if (parseColumn(p, lineEnd, id)) {
+                columnCpu.push_back(static_cast<int>(id));
+                continue;
+            }
+        }
+        while (p < lineEnd && !isBlank(*p) && *p != '\n') ++p;
+    }
+    return lineEnd;
+}
+
+// /proc counters are 32-bit and wrap
+inline uint64_t counterDelta(uint64_t current, uint64_t last) {
+    if (current >= last) {
+        return current - last;
+    }
+    return last <= 0xffffffffULL ? current + 0x100000000ULL - last : 0;
+}
+
+// Is token present in [p, end) as a whole word ("virtio3" must not match "virtio30")?
+bool containsWord(const char* p, const char* end, const std::string& token) {
+    if (token.empty()) {
+        return false;
+    }
+    const char* first = p;
+    for (;;) {
+        p = std::search(p, end, token.begin(), token.end());
+        if (p == end) {
+            return false;
+        }
+        const char* after = p + token.size();
+        const bool startOk = p == first || !isAlnum(p[-1]);
+        const bool endOk = after == end || !isAlnum(*after);
+        if (startOk && endOk) {
+            return true;
+        }
+        ++p;
+    }
+}
+
+// Recognise a driver's per-queue byte counter and report its direction and
+// queue: "rx_queue_0_bytes" (virtio, ixgbe), "rx0_bytes" (mlx5),
+// "rx-0.bytes" (i40e), "[0]: rx_ucast_bytes" (bnxt). Sub-counters such as
+// "rx0_lro_bytes" or "tx0_tso_bytes" are rejected so nothing is counted twice.
+bool parseQueueStat(const char* name, bool& rx, unsigned& queue) {
+    const char* p = name;
+    bool haveQueue = false;
+    if (*p == '[') {
+        ++p;
+        if (!isDigit(*p)) return false;
+        queue = 0;
+        while (isDigit(*p)) queue = queue * 10 + static_cast<unsigned>(*p++ - '0');
+        if (std::strncmp(p, "]: ", 3) != 0) return false;
+        p += 3;
+        haveQueue = true;
+    }
+    if (std::strncmp(p, "rx", 2) == 0) {
+        rx = true;
+    } else if (std::strncmp(p, "tx", 2) == 0) {
+        rx = false;
+    } else {
+        return false;
+    }
+    p += 2;
+    if (!haveQueue) {
+        if (std::strncmp(p, "_queue_", 7) == 0) {
+            p += 7;
+        } else if (*p == '_' || *p == '-') {
+            ++p;
+        }
+        if (!isDigit(*p)) return false;
+        queue = 0;
+        while (isDigit(*p)) queue = queue * 10 + static_cast<unsigned>(*p++ - '0');
+    }
+    while (*p == '_' || *p == '.' || *p == '-') ++p;
+    return std::strcmp(p, "bytes") == 0 ||
+           (haveQueue && (std::strcmp(p, "ucast_bytes") == 0 || std::strcmp(p, "mcast_bytes") == 0 ||
+                          std::strcmp(p, "bcast_bytes") == 0));
+}
+
+} // namespace
+
+bool NicLoadSampler::ProcFile::open(const char* path, size_t initialSize) {
+#ifdef __linux__
+    fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    buf.resize(initialSize);
+    return fd >= 0;
+#else
+    (void)path;
+    (void)initialSize;
+    return false;
+#endif
+}
+
+bool NicLoadSampler::ProcFile::read() {
+    len = 0;
+    if (fd < 0) {
+        return false;
+    }
+#ifdef __linux__
+    for (;;) {
+        if (len == buf.size()) {
+            // Grow and read the whole file again so it comes from one pass
+            buf.resize(buf.size() * 2);
+            len = 0;
+        }
+        const ssize_t n = ::pread(fd, buf.data() + len, buf.size() - len, static_cast<off_t>(len));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            len = 0;
+            return false;
+        }
+        if (n == 0) {
+            return len > 0;
+        }
+        len += static_cast<size_t>(n);
+    }
+#else
+    return false;
+#endif
+}
+
+void NicLoadSampler::ProcFile::close() {
+#ifdef __linux__
+    if (fd >= 0) {
+        ::close(fd);
+    }
+#endif
+    fd = -1;
+}
+
+NicLoadSampler::NicLoadSampler() : ethtoolFd_(-1), haveBaseline_(false) {
+    iface_[0] = '\0';
+    load_.nic_irq_lines = 0;
+    load_.queue_bytes_known = false;
+#ifdef __linux__
+    softirqs_.open("/proc/softirqs", kInitialBufferSize);
+    interrupts_.open("/proc/interrupts", kInitialBufferSize);
+    ethtoolFd_ = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+#endif
+}
+
+NicLoadSampler::~NicLoadSampler() {
+    softirqs_.close();
+    interrupts_.close();
+    for (ProcFile& file : irqFiles_) {
+        file.close();
+    }
+#ifdef __linux__
+    if (ethtoolFd_ >= 0) {
+        ::close(ethtoolFd_);
+    }
+#endif
+}
+
+void NicLoadSampler::setInterface(const std::string& iface) {
+    std::memset(iface_, 0, sizeof(iface_));
+    iface.copy(iface_, sizeof(iface_) - 1);
+    findIrqs(iface);
+    findQueueStats(iface);
+    haveBaseline_ = false;
+}
+
+void NicLoadSampler::findIrqs(const std::string& iface) {
+    irqs_.clear();
+    for (ProcFile& file : irqFiles_) {
+        file.close();
+    }
+    irqFiles_.clear();
+#ifdef __linux__
+    // Vectors are named after the interface ("eth0-TxRx-0") or after the
+    // device ("virtio3-input.0", "mlx5_comp0@pci:0000:03:00.0")
+    std::string device;
+    char path[128];
+    char link[256];
+    std::snprintf(path, sizeof(path), "/sys/class/net/%s/device", iface.c_str());
+    const ssize_t length = ::readlink(path, link, sizeof(link) - 1);
+    if (length > 0) {
+        link[length] = '\0';
+        const char* slash = std::strrchr(link, '/');
+        device = slash ? slash + 1 : link;
+    }
+
+    if (interrupts_.read()) {
+        const char* p = interrupts_.buf.data();
+        const char* end = p + interrupts_.len;
+        p = parseCpuHeader(p, end, columnCpu_);
+        while (p < end) {
+            const char* lineEnd = nextLine(p, end);
+            uint64_t irq;
+            const char* q = p;
+            if (parseColumn(q, lineEnd, irq) && q < lineEnd && *q == ':' &&
+                (containsWord(q, lineEnd, iface) || containsWord(q, lineEnd, device))) {
+                irqs_.push_back(static_cast<unsigned>(irq));
+            }
+            p = lineEnd;
+        }
+    }
+
+    if (irqs_.empty()) {
+        // Unnamed vectors: take every MSI vector of the device
+        std::snprintf(path, sizeof(path), "/sys/class/net/%s/device/msi_irqs", iface.c_str());
+        if (DIR* dir = ::opendir(path)) {
+            while (const dirent* entry = ::readdir(dir)) {
+                if (isDigit(entry->d_name[0])) {
+                    irqs_.push_back(static_cast<unsigned>(std::strtoul(entry->d_name, nullptr, 10)));
+                }
+            }
+            ::closedir(dir);
+        }
+    }
+    std::sort(irqs_.begin(), irqs_.end());
+
+    for (unsigned irq : irqs_) {
+        std::snprintf(path, sizeof(path), "/sys/kernel/irq/%u/per_cpu_count", irq);
+        ProcFile file;
+        if (!file.open(path, kIrqBufferSize)) {
+            // Older kernel: fall back to /proc/interrupts for all of them
+            for (ProcFile& opened : irqFiles_) {
+                opened.close();
+            }
+            irqFiles_.clear();
+            break;
+        }
+        irqFiles_.push_back(std::move(file));
+    }
+#else
+    (void)iface;
+#endif
+    load_.nic_irq_lines = static_cast<int>(irqs_.size());
+}
+
+void NicLoadSampler::findQueueStats(const std::string& iface) {
+    queueStats_.clear();
+    load_.queues.clear();
+    load_.queue_bytes_known = false;
+#ifdef __linux__
+    if (ethtoolFd_ < 0) {
+        return;
+    }
+    ifreq request;
+    std::memset(&request, 0, sizeof(request));
+    iface.copy(request.ifr_name, IFNAMSIZ - 1);
+
+    uint64_t setInfo[4] = {0}; // ethtool_sset_info + one count; u64 for alignment
+    ethtool_sset_info* info = reinterpret_cast<ethtool_sset_info*>(setInfo);
+    info->cmd = ETHTOOL_GSSET_INFO;
+    info->sset_mask = 1ULL << ETH_SS_STATS;
+    request.ifr_data = reinterpret_cast<char*>(info);
+    if (::ioctl(ethtoolFd_, SIOCETHTOOL, &request) != 0 || !(info->sset_mask & (1ULL << ETH_SS_STATS))) {
+        return;
+    }
+    const uint32_t count = info->data[0];
+    if (count == 0) {
+        return;
+    }
+
+    std::vector<uint64_t> names((sizeof(ethtool_gstrings) + count * kStatNameLength) / sizeof(uint64_t) + 1);
+    ethtool_gstrings* strings = reinterpret_cast<ethtool_gstrings*>(names.data());
+    strings->cmd = ETHTOOL_GSTRINGS;
+    strings->string_set = ETH_SS_STATS;
+    strings->len = count;
+    request.ifr_data = reinterpret_cast<char*>(strings);
+    if (::ioctl(ethtoolFd_, SIOCETHTOOL, &request) != 0) {
+        return;
+    }
+
+    // Queue slots: rx queues by index, then tx queues by index
+    std::vector<std::pair<uint32_t, uint32_t>> found; // ((tx << 16) | queue, stat index)
+    for (uint32_t i = 0; i < strings->len && i < count; ++i) {
+        char name[kStatNameLength + 1];
+        std::memcpy(name, strings->data + i * kStatNameLength, kStatNameLength);
+        name[kStatNameLength] = '\0';
+        bool rx;
+        unsigned queue;
+        if (parseQueueStat(name, rx, queue) && queue < 0x10000) {
+            found.push_back(std::make_pair((rx ? 0u : 0x10000u) | queue, i));
+        }
+    }
+    std::sort(found.begin(), found.end());
+    uint32_t lastKey = 0xffffffffu;
+    for (const auto& entry : found) {
+        if (entry.first != lastKey) {
+            NicQueueLoad queue;
+            std::snprintf(queue.name, sizeof(queue.name), "%s-%u", entry.first & 0x10000u ? "tx" : "rx",
+                          entry.first & 0xffffu);
+            queue.bytes_per_sec = 0.0;
+            load_.queues.push_back(queue);
+            lastKey = entry.first;
+        }
+        queueStats_.push_back(std::make_pair(entry.second, static_cast<uint32_t>(load_.queues.size() - 1)));
+    }
+
+    statsBuf_.assign((sizeof(ethtool_stats) + count * sizeof(uint64_t)) / sizeof(uint64_t) + 1, 0);
+    load_.queue_bytes_known = !queueStats_.empty();
+#else
+    (void)iface;
+#endif
+}
+
+bool NicLoadSampler::readSoftirqs(CpuCounters& counters) {
+    if (!softirqs_.read()) {
+        return false;
+    }
+    const char* p = softirqs_.buf.data();
+    const char* end = p + softirqs_.len;
+    p = parseCpuHeader(p, end, columnCpu_);
+    if (columnCpu_.empty()) {
+        return false;
+    }
+    const size_t cpus = static_cast<size_t>(*std::max_element(columnCpu_.begin(), columnCpu_.end())) + 1;
+    counters.net_rx.assign(cpus, 0);
+    counters.net_tx.assign(cpus, 0);
+
+    while (p < end) {
+        const char* lineEnd = nextLine(p, end);
+        const char* q = p;
+        while (q < lineEnd && isBlank(*q)) ++q;
+        std::vector<uint64_t>* row = nullptr;
+        if (lineEnd - q > 7 && std::memcmp(q, "NET_RX:", 7) == 0) {
+            row = &counters.net_rx;
+        } else if (lineEnd - q > 7 && std::memcmp(q, "NET_TX:", 7) == 0) {
+            row = &counters.net_tx;
+        }
+        if (row) {
+            q += 7;
+            for (int cpu : columnCpu_) {
+                uint64_t value;
+                if (!parseColumn(q, lineEnd, value)) break;
+                (*row)[static_cast<size_t>(cpu)] = value;
+            }
+        }
+        p = lineEnd;
+    }
+    return true;
+}
+
+bool NicLoadSampler::readInterrupts(CpuCounters& counters) {
+    counters.irqs.assign(counters.net_rx.size(), 0);
+    if (irqs_.empty()) {
+        return false;
+    }
+    if (!irqFiles_.empty()) {
+        // "12,0,3,...": one count per possible CPU, in CPU id order
+        for (ProcFile& file : irqFiles_) {
+            if (!file.read()) {
+                continue;
+            }
+            const char* p = file.buf.data();
+            const char* end = p + file.len;
+            for (size_t cpu = 0; p < end; ++cpu) {
+                uint64_t value;
+                if (!parseColumn(p, end, value)) break;
+                if (cpu >= counters.irqs.size()) {
+                    counters.irqs.resize(cpu + 1, 0);
+                }
+                counters.irqs[cpu] += value;
+                if (p < end && *p == ',') ++p;
+            }
+        }
+        return true;
+    }
+    if (!interrupts_.read()) {
+        return false;
+    }
+    const char* p = interrupts_.buf.data();
+    const char* end = p + interrupts_.len;
+    p = parseCpuHeader(p, end, columnCpu_);
+    for (int cpu : columnCpu_) {
+        if (static_cast<size_t>(cpu) >= counters.irqs.size()) {
+            counters.irqs.resize(static_cast<size_t>(cpu) + 1, 0);
+        }
+    }
+
+    while (p < end) {
+        const char* lineEnd = nextLine(p, end);
+        uint64_t irq;
+        const char* q = p;
+        if (parseColumn(q, lineEnd, irq) && q < lineEnd && *q == ':' &&
+            std::binary_search(irqs_.begin(), irqs_.end(), static_cast<unsigned>(irq))) {
+            ++q;
+            for (int cpu : columnCpu_) {
+                uint64_t value;
+                if (!parseColumn(q, lineEnd, value)) break;
+                counters.irqs[static_cast<size_t>(cpu)] += value;
+            }
+        }
+        p = lineEnd;
+    }
+    return true;
+}
+
+bool NicLoadSampler::readQueueBytes(std::vector<uint64_t>& bytes) {
+    bytes.assign(load_.queues.size(), 0);
+#ifdef __linux__
+    if (queueStats_.empty() || ethtoolFd_ < 0) {
+        return false;
+    }
+    ethtool_stats* stats = reinterpret_cast<ethtool_stats*>(statsBuf_.data());
+    stats->cmd = ETHTOOL_GSTATS;
+    stats->n_stats = static_cast<uint32_t>((statsBuf_.size() * sizeof(uint64_t) - sizeof(ethtool_stats)) /
+                                           sizeof(uint64_t));
+    ifreq request;
+    std::memset(&request, 0, sizeof(request));
+    std::memcpy(request.ifr_name, iface_, IFNAMSIZ);
+    request.ifr_data = reinterpret_cast<char*>(stats);
+    if (::ioctl(ethtoolFd_, SIOCETHTOOL, &request) != 0) {
+        return false;
+    }
+    for (const auto& stat : queueStats_) {
+        if (stat.first < stats->n_stats) {
+            bytes[stat.second] += stats->data[stat.first];
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool NicLoadSampler::sample(double elapsedSeconds) {
+    if (!readSoftirqs(current_)) {
+        return false;
+    }
+    readInterrupts(current_);
+    const bool queuesOk = readQueueBytes(queueBytes_);
+
+    const size_t cpus = current_.net_rx.size();
+    load_.cpus.resize(cpus);
+    const bool rated = haveBaseline_ && elapsedSeconds > 0.0 && last_.net_rx.size() == cpus;
+    for (size_t cpu = 0; cpu < cpus; ++cpu) {
+        CpuNetLoad& row = load_.cpus[cpu];
+        row.cpu = static_cast<int>(cpu);
+        if (!rated) {
+            row.net_rx = row.net_tx = row.nic_irqs = 0.0;
+            continue;
+        }
+        row.net_rx = counterDelta(current_.net_rx[cpu], last_.net_rx[cpu]) / elapsedSeconds;
+        row.net_tx = counterDelta(current_.net_tx[cpu], last_.net_tx[cpu]) / elapsedSeconds;
+        row.nic_irqs = cpu < current_.irqs.size() && cpu < last_.irqs.size()
+                           ? counterDelta(current_.irqs[cpu], last_.irqs[cpu]) / elapsedSeconds
+                           : 0.0;
+    }
+
+    const bool queuesRated = rated && queuesOk && lastQueueBytes_.size() == queueBytes_.size();
+    for (size_t i = 0; i < load_.queues.size(); ++i) {
+        load_.queues[i].bytes_per_sec =
+            queuesRated && queueBytes_[i] >= lastQueueBytes_[i]
+                ? static_cast<double>(queueBytes_[i] - lastQueueBytes_[i]) / elapsedSeconds
+                : 0.0;
+    }
+
+    std::swap(last_, current_);
+    lastQueueBytes_.swap(queueBytes_);
+    haveBaseline_ = true;
+    return true;
+}
@@ -1,9 +1,9 @@
 #include "../include/ping_test.h"
 #include "../include/curl_wrapper.h"
+#include "../include/logger.h"
 #include <curl/curl.h>
 #include <chrono>
 #include <thread>
-#include <iostream>
 #include <algorithm>
 #include <cmath>
 
@@ -17,17 +17,17 @@ PingResults PingTest::run(const std::string& host, int port, int count) {
     std::vector<double> samples;
     samples.reserve(count);
     
-    std::cout << "Running ping test to " << host << ":" << port 
-              << " (" << count << " samples)..." << std::endl;
+    LOG_INFO("Running ping test", logging::field("host", host), logging::field("port", port),
+             logging::field("samples", count));
     
     for (int i = 0; i < count; ++i) {
         double pingTime = singlePing(host, port);
         
         if (pingTime > 0) {
             samples.push_back(pingTime);
-            std::cout << "Ping " << (i + 1) << ": " << pingTime << " ms" << std::endl;
+            LOG_DEBUG("Ping", logging::field("seq", i + 1), logging::field("ms", pingTime));
         } else {
-            std::cout << "Ping " << (i + 1) << ": failed" << std::endl;
+            LOG_DEBUG("Ping failed", logging::field("seq", i + 1));
         }
         
         // Small delay between pings
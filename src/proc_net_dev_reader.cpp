@@ -0,0 +1,138 @@
+#include "../include/proc_net_dev_reader.h"
+#include <cstring>
+#include <cerrno>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Large enough for a few dozen interfaces; grown on demand for hosts with
+// many virtual devices and then kept at that size.
+constexpr size_t kInitialBufferSize = 16 * 1024;
+
+inline bool isBlank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+// Positions p just past the "name:" prefix of an interface row and reports
+// the trimmed name, or returns nullptr for header lines.
+const char* scanName(const char* p, const char* end,
+                     const char** name, size_t* nameLen) {
+    while (p < end && isBlank(*p)) ++p;
+    const char* nameStart = p;
+    while (p < end && *p != ':' && *p != '\n') ++p;
+    if (p >= end || *p != ':') {
+        return nullptr;
+    }
+    const char* nameEnd = p;
+    while (nameEnd > nameStart && isBlank(nameEnd[-1])) --nameEnd;
+    *name = nameStart;
+    *nameLen = static_cast<size_t>(nameEnd - nameStart);
+    return p + 1;
+}
+
+const char* nextLine(const char* p, const char* end) {
+    const void* nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return nl ? static_cast<const char*>(nl) + 1 : end;
+}
+
+} // namespace
+
+ProcNetDevReader::ProcNetDevReader(const char* path)
+    : fd_(-1), buf_(kInitialBufferSize), len_(0) {
+#ifndef _WIN32
+    fd_ = ::open(path, O_RDONLY | O_CLOEXEC);
+#else
+    (void)path;
+#endif
+}
+
+ProcNetDevReader::~ProcNetDevReader() {
+#ifndef _WIN32
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+#endif
+}
+
+bool ProcNetDevReader::refresh() {
+    len_ = 0;
+    if (fd_ < 0) {
+        return false;
+    }
+#ifndef _WIN32
+    for (;;) {
+        if (len_ == buf_.size()) {
+            // The table no longer fits: grow and read the whole file again
+            // so the contents come from a single pass over the device list.
+            buf_.resize(buf_.size() * 2);
+            len_ = 0;
+        }
+        ssize_t n = ::pread(fd_, buf_.data() + len_, buf_.size() - len_,
+                            static_cast<off_t>(len_));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            len_ = 0;
+            return false;
+        }
+        if (n == 0) {
+            break;
+        }
+        len_ += static_cast<size_t>(n);
+    }
+    return len_ > 0;
+#else
+    return false;
+#endif
+}
+
+const char* ProcNetDevReader::parseRow(const char* p, const char* end,
+                                       const char** name, size_t* nameLen,
+                                       uint64_t* fields) {
+    *name = nullptr;
+    *nameLen = 0;
+
+    const char* q = scanName(p, end, name, nameLen);
+    if (!q) {
+        *name = nullptr;
+        return nextLine(p, end);
+    }
+
+    for (int i = 0; i < kFieldCount; ++i) {
+        while (q < end && isBlank(*q)) ++q;
+        uint64_t value = 0;
+        while (q < end && static_cast<unsigned>(*q - '0') <= 9u) {
+            value = value * 10 + static_cast<uint64_t>(*q - '0');
+            ++q;
+        }
+        fields[i] = value;
+    }
+    return nextLine(q, end);
+}
+
+bool ProcNetDevReader::find(const char* iface, size_t ifaceLen, NetStats& stats) const {
+    const char* p = buf_.data();
+    const char* end = p + len_;
+    while (p < end) {
+        const char* name;
+        size_t nameLen;
+        const char* q = scanName(p, end, &name, &nameLen);
+        if (q && nameLen == ifaceLen && std::memcmp(name, iface, ifaceLen) == 0) {
+            uint64_t fields[kFieldCount];
+            parseRow(p, end, &name, &nameLen, fields);
+            netStatsFromProcFields(fields, stats);
+            return true;
+        }
+        p = nextLine(q ? q : p, end);
+    }
+    return false;
+}
+
+bool ProcNetDevReader::read(const std::string& iface, NetStats& stats) {
+    return refresh() && find(iface.data(), iface.size(), stats);
+}
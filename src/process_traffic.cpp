@@ -0,0 +1,365 @@
+#include "../include/process_traffic.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <netinet/tcp.h>
+#endif
+
+namespace {
+
+constexpr uint32_t kMissRetry = 30; // resolves between retries of an unplaceable inode
+constexpr uint32_t kNotSocket = 0;  // fd entry of a file, pipe or unreadable link
+
+#ifdef __linux__
+bool parsePid(const char* name, int& pid) {
+    if (*name < '1' || *name > '9') {
+        return false;
+    }
+    char* end = nullptr;
+    const long value = std::strtol(name, &end, 10);
+    if (*end != '\0') {
+        return false;
+    }
+    pid = static_cast<int>(value);
+    return true;
+}
+
+// "socket:[12345]" -> 12345
+bool parseSocketLink(const char* link, size_t length, uint32_t& inode) {
+    static const char kPrefix[] = "socket:[";
+    const size_t prefix = sizeof(kPrefix) - 1;
+    if (length <= prefix + 1 || std::memcmp(link, kPrefix, prefix) != 0 || link[length - 1] != ']') {
+        return false;
+    }
+    uint32_t value = 0;
+    for (size_t i = prefix; i < length - 1; ++i) {
+        if (link[i] < '0' || link[i] > '9') {
+            return false;
+        }
+        value = value * 10 + static_cast<uint32_t>(link[i] - '0');
+    }
+    inode = value;
+    return true;
+}
+
+std::string readComm(int pid) {
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%d/comm", pid);
+    char name[64];
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::string();
+    }
+    const ssize_t length = ::read(fd, name, sizeof(name) - 1);
+    ::close(fd);
+    if (length <= 0) {
+        return std::string();
+    }
+    size_t end = static_cast<size_t>(length);
+    if (name[end - 1] == '\n') {
+        --end;
+    }
+    return std::string(name, end);
+}
+#endif
+
+} // namespace
+
+size_t SocketOwnerIndex::listPids(std::vector<int>& pids) const {
+    pids.clear();
+#ifdef __linux__
+    DIR* proc = ::opendir("/proc");
+    if (!proc) {
+        return 0;
+    }
+    while (const dirent* entry = ::readdir(proc)) {
+        int pid;
+        if (parsePid(entry->d_name, pid)) {
+            pids.push_back(pid);
+        }
+    }
+    ::closedir(proc);
+#endif
+    return pids.size();
+}
+
+void SocketOwnerIndex::scanProcess(int pid, Process& process, bool relinkAll) {
+    process.scanGeneration = generation_;
+#ifdef __linux__
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%d/fd", pid);
+    DIR* dir = ::opendir(path);
+    if (!dir) {
+        return; // exited, or not ours to read
+    }
+    fdScratch_.clear();
+    while (const dirent* entry = ::readdir(dir)) {
+        if (entry->d_name[0] >= '0' && entry->d_name[0] <= '9') {
+            fdScratch_.push_back(std::atoi(entry->d_name));
+        }
+    }
+    ::closedir(dir);
+    std::sort(fdScratch_.begin(), fdScratch_.end());
+
+    // Merge the sorted listing with the known fds: keep the ones still
+    // present, readlink() only new fds and sockets that have since gone
+    // away (the fd number may now hold a new socket)
+    std::vector<std::pair<int, uint32_t>> merged;
+    merged.reserve(fdScratch_.size());
+    auto known = process.fds.begin();
+    for (int fd : fdScratch_) {
+        while (known != process.fds.end() && known->first < fd) {
+            forget(known->second);
+            ++known;
+        }
+        if (known != process.fds.end() && known->first == fd) {
+            const uint32_t inode = known->second;
+            ++known;
+            if (!relinkAll && (inode == kNotSocket || owners_.count(inode))) {
+                merged.push_back(std::make_pair(fd, inode));
+                continue;
+            }
+        }
+        char linkPath[96];
+        std::snprintf(linkPath, sizeof(linkPath), "/proc/%d/fd/%d", pid, fd);
+        char link[64];
+        const ssize_t length = ::readlink(linkPath, link, sizeof(link));
+        ++linksRead_;
+        if (length <= 0 && errno == ENOENT) {
+            continue; // closed since the listing
+        }
+        uint32_t inode;
+        if (length > 0 && parseSocketLink(link, static_cast<size_t>(length), inode)) {
+            merged.push_back(std::make_pair(fd, inode));
+            owners_[inode] = pid;
+            misses_.erase(inode);
+        } else {
+            merged.push_back(std::make_pair(fd, kNotSocket));
+        }
+    }
+    for (; known != process.fds.end(); ++known) {
+        forget(known->second);
+    }
+    process.fds.swap(merged);
+#else
+    (void)pid;
+    (void)relinkAll;
+#endif
+}
+
+void SocketOwnerIndex::resolve(const std::vector<uint32_t>& inodes) {
+    linksRead_ = 0;
+    ++generation_;
+
+    size_t missing = 0;
+    bool retrying = false;
+    for (uint32_t inode : inodes) {
+        if (owners_.count(inode)) {
+            continue;
+        }
+        auto miss = misses_.find(inode);
+        if (miss != misses_.end()) {
+            if (generation_ - miss->second < kMissRetry) {
+                continue;
+            }
+            retrying = true;
+        }
+        ++missing;
+    }
+    if (missing == 0) {
+        return;
+    }
+
+    // New processes first: a new socket usually belongs to one
+    listPids(pids_);
+    std::sort(pids_.begin(), pids_.end());
+    for (auto it = processes_.begin(); it != processes_.end();) {
+        if (!std::binary_search(pids_.begin(), pids_.end(), it->first)) {
+            for (const auto& fd : it->second.fds) {
+                forget(fd.second);
+            }
+            it = processes_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (int pid : pids_) {
+        if (processes_.count(pid)) {
+            continue;
+        }
+        Process& process = processes_[pid];
+#ifdef __linux__
+        process.name = readComm(pid);
+#endif
+        scanProcess(pid, process, true);
+    }
+
+    auto stillMissing = [&]() {
+        for (uint32_t inode : inodes) {
+            if (!owners_.count(inode) && !misses_.count(inode)) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // Then new fds in processes we already know. A retried miss may sit
+    // behind an fd number that held a file when it was last read, so at
+    // most once per kMissRetry resolves every fd is read again.
+    const bool relinkAll = retrying && generation_ - lastRelink_ >= kMissRetry;
+    if (stillMissing() || relinkAll) {
+        if (relinkAll) {
+            lastRelink_ = generation_;
+        }
+        for (auto& entry : processes_) {
+            if (entry.second.scanGeneration != generation_) {
+                scanProcess(entry.first, entry.second, relinkAll);
+            }
+        }
+    }
+
+    for (uint32_t inode : inodes) {
+        if (!owners_.count(inode)) {
+            misses_[inode] = generation_;
+        }
+    }
+}
+
+int SocketOwnerIndex::owner(uint32_t inode) const {
+    auto it = owners_.find(inode);
+    return it == owners_.end() ? -1 : it->second;
+}
+
+const std::string& SocketOwnerIndex::processName(int pid) const {
+    static const std::string unknown;
+    auto it = processes_.find(pid);
+    return it == processes_.end() ? unknown : it->second.name;
+}
+
+void SocketOwnerIndex::forget(uint32_t inode) {
+    if (inode == kNotSocket) {
+        return;
+    }
+    owners_.erase(inode);
+    misses_.erase(inode);
+}
+
+ProcessTraffic::ProcessTraffic() : generation_(0) {
+}
+
+bool ProcessTraffic::refresh(double elapsedSeconds) {
+#ifdef __linux__
+    ++generation_;
+    const bool baseline = generation_ == 1;
+    deltas_.clear();
+    unknown_.clear();
+
+    // Established sockets only: the kernel fills a tcp_info for every
+    // socket it dumps, and LISTEN, TIME_WAIT, request socks and the closing
+    // states carry little or no new data. Bytes a socket moves after it
+    // leaves ESTABLISHED are not attributed.
+    size_t seen = 0;
+    const bool ok = diag_.dumpTcp(tcpStateBit(TCP_ESTABLISHED), [&](const TcpSocketInfo& info) {
+        if (info.inode == 0) {
+            return;
+        }
+        ++seen;
+        auto inserted = sockets_.insert(std::make_pair(info.inode, SocketCounters{0, 0, 0}));
+        SocketCounters& counters = inserted.first->second;
+        // A socket first seen now opened since the last refresh, so all of
+        // its bytes belong to this interval (except on the very first dump)
+        const bool fresh = inserted.second;
+        if (!baseline) {
+            const uint64_t tx = info.bytes_acked >= counters.acked ? info.bytes_acked - counters.acked : 0;
+            const uint64_t rx = info.bytes_received >= counters.received ? info.bytes_received - counters.received : 0;
+            if (tx != 0 || rx != 0 || fresh) {
+                deltas_.push_back(Delta{info.inode, tx, rx});
+                if (index_.owner(info.inode) < 0) {
+                    unknown_.push_back(info.inode);
+                }
+            }
+        }
+        counters.acked = info.bytes_acked;
+        counters.received = info.bytes_received;
+        counters.generation = generation_;
+    });
+    if (!ok) {
+        return false;
+    }
+
+    // Every socket on record was in this dump unless the table is larger
+    // than the dump, so the sweep for closed ones is usually skipped
+    for (auto it = sockets_.begin(); seen != sockets_.size() && it != sockets_.end();) {
+        if (it->second.generation != generation_) {
+            index_.forget(it->first);
+            it = sockets_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    index_.resolve(unknown_); // no /proc access unless an inode is new
+
+    // Sum the deltas per PID into rates_, reusing rows
+    for (ProcessRate& row : rates_) {
+        row.rx_rate = 0.0;
+        row.tx_rate = 0.0;
+    }
+    if (elapsedSeconds <= 0.0) {
+        elapsedSeconds = 1.0;
+    }
+    for (const Delta& delta : deltas_) {
+        const int pid = index_.owner(delta.inode);
+        if (pid < 0) {
+            continue;
+        }
+        auto row = rowOfPid_.find(pid);
+        if (row == rowOfPid_.end()) {
+            row = rowOfPid_.insert(std::make_pair(pid, rates_.size())).first;
+            rates_.push_back(ProcessRate{pid, index_.processName(pid), 0.0, 0.0});
+        }
+        ProcessRate& rate = rates_[row->second];
+        rate.rx_rate += static_cast<double>(delta.rx) / elapsedSeconds;
+        rate.tx_rate += static_cast<double>(delta.tx) / elapsedSeconds;
+    }
+
+    // Drop rows that stayed idle so exited processes do not pile up
+    size_t kept = 0;
+    for (size_t i = 0; i < rates_.size(); ++i) {
+        if (rates_[i].rx_rate > 0.0 || rates_[i].tx_rate > 0.0) {
+            if (kept != i) {
+                rates_[kept] = std::move(rates_[i]);
+            }
+            ++kept;
+        }
+    }
+    if (kept != rates_.size()) {
+        rates_.resize(kept);
+        rowOfPid_.clear();
+        for (size_t i = 0; i < rates_.size(); ++i) {
+            rowOfPid_[rates_[i].pid] = i;
+        }
+    }
+    return true;
+#else
+    (void)elapsedSeconds;
+    return false;
+#endif
+}
+
+void ProcessTraffic::top(size_t n, std::vector<ProcessRate>& out) const {
+    out.assign(rates_.begin(), rates_.end());
+    const size_t count = std::min(n, out.size());
+    std::partial_sort(out.begin(), out.begin() + count, out.end(),
+                      [](const ProcessRate& a, const ProcessRate& b) {
+                          return a.rx_rate + a.tx_rate > b.rx_rate + b.tx_rate;
+                      });
+    out.resize(count);
+}
@@ -0,0 +1,64 @@
+#include "../include/rate_filter.h"
+#include <cstdlib>
+#include <cstring>
+
+RateFilterKind parseRateFilterKind(const char* value, RateFilterKind fallback) {
+    if (!value) {
+        return fallback;
+    }
+    if (std::strcmp(value, "ema") == 0) {
+        return RateFilterKind::Ema;
+    }
+    if (std::strcmp(value, "ema-dt") == 0) {
+        return RateFilterKind::TimeConstantEma;
+    }
+    if (std::strcmp(value, "mean") == 0) {
+        return RateFilterKind::WindowMean;
+    }
+    if (std::strcmp(value, "median") == 0) {
+        return RateFilterKind::Median;
+    }
+    if (std::strcmp(value, "kalman") == 0) {
+        return RateFilterKind::Kalman;
+    }
+    if (std::strcmp(value, "median-ema") == 0) {
+        return RateFilterKind::MedianEma;
+    }
+    if (std::strcmp(value, "none") == 0) {
+        return RateFilterKind::None;
+    }
+    return fallback;
+}
+
+RateFilterKind rateFilterFromEnvironment() {
+    return parseRateFilterKind(std::getenv("SPEED_METER_FILTER"), RateFilterKind::Ema);
+}
+
+double RateFilter::update(double x, double dtSeconds) {
+    switch (kind_) {
+    case RateFilterKind::Ema:
+        return ema_.apply(x, dtSeconds);
+    case RateFilterKind::TimeConstantEma:
+        return timeConstantEma_.apply(x, dtSeconds);
+    case RateFilterKind::WindowMean:
+        return mean_.apply(x, dtSeconds);
+    case RateFilterKind::Median:
+        return median_.apply(x, dtSeconds);
+    case RateFilterKind::Kalman:
+        return kalman_.apply(x, dtSeconds);
+    case RateFilterKind::MedianEma:
+        return medianEma_.apply(x, dtSeconds);
+    case RateFilterKind::None:
+        break;
+    }
+    return x;
+}
+
+void RateFilter::reset() {
+    ema_.reset();
+    timeConstantEma_.reset();
+    mean_.reset();
+    median_.reset();
+    kalman_.reset();
+    medianEma_.reset();
+}
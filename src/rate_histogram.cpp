@@ -0,0 +1,155 @@
+#include "../include/rate_histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+constexpr uint64_t kLinearBuckets = 1u << RateHistogram::kSubBucketBits;   // 32
+constexpr uint64_t kHalfBuckets = kLinearBuckets / 2;                      // 16 per octave
+constexpr uint64_t kMaxValue = (uint64_t(1) << RateHistogram::kMaxExponent) - 1;
+constexpr uint64_t kMaxBucketCount = 0xffffffffu;
+
+// Add to a 32-bit bucket, stopping at its maximum; returns what was added
+// so the 64-bit total stays the sum of the buckets
+uint64_t addSaturating(uint32_t& bucket, uint64_t count) {
+    const uint64_t added = std::min<uint64_t>(count, kMaxBucketCount - bucket);
+    bucket += static_cast<uint32_t>(added);
+    return added;
+}
+
+int highestBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while (value >>= 1) ++bit;
+    return bit;
+#endif
+}
+
+} // namespace
+
+size_t RateHistogram::bucketIndex(uint64_t value) {
+    if (value > kMaxValue) value = kMaxValue;
+    if (value < kLinearBuckets) {
+        return static_cast<size_t>(value);
+    }
+    const int exponent = highestBit(value);
+    const int shift = exponent - (kSubBucketBits - 1);
+    const uint64_t sub = (value >> shift) - kHalfBuckets;
+    return static_cast<size_t>(kLinearBuckets + (exponent - kSubBucketBits) * kHalfBuckets + sub);
+}
+
+uint64_t RateHistogram::bucketLow(size_t index) {
+    if (index < kLinearBuckets) {
+        return index;
+    }
+    const size_t octave = (index - kLinearBuckets) / kHalfBuckets;
+    const uint64_t sub = (index - kLinearBuckets) % kHalfBuckets + kHalfBuckets;
+    return sub << (octave + 1);
+}
+
+uint64_t RateHistogram::bucketWidth(size_t index) {
+    if (index < kLinearBuckets) {
+        return 1;
+    }
+    return uint64_t(1) << ((index - kLinearBuckets) / kHalfBuckets + 1);
+}
+
+void RateHistogram::record(double bytesPerSecond, uint32_t count) {
+    if (!std::isfinite(bytesPerSecond) || bytesPerSecond < 0.0) {
+        bytesPerSecond = 0.0;
+    }
+    const uint64_t value = bytesPerSecond >= static_cast<double>(kMaxValue)
+                               ? kMaxValue
+                               : static_cast<uint64_t>(bytesPerSecond + 0.5);
+    count_ += addSaturating(counts_[bucketIndex(value)], count);
+    max_ = std::max(max_, bytesPerSecond);
+}
+
+void RateHistogram::merge(const RateHistogram& other) {
+    if (other.count_ == 0) return;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        count_ += addSaturating(counts_[i], other.counts_[i]);
+    }
+    max_ = std::max(max_, other.max_);
+}
+
+void RateHistogram::addToBucket(size_t index, uint32_t count, double max) {
+    if (index >= kBuckets) return;
+    count_ += addSaturating(counts_[index], count);
+    max_ = std::max(max_, max);
+}
+
+void RateHistogram::clear() {
+    std::memset(counts_, 0, sizeof(counts_));
+    count_ = 0;
+    max_ = 0.0;
+}
+
+double RateHistogram::percentile(double q) const {
+    if (count_ == 0) return 0.0;
+    q = std::min(std::max(q, 0.0), 1.0);
+    uint64_t rank = static_cast<uint64_t>(std::ceil(q * static_cast<double>(count_)));
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += counts_[i];
+        if (seen >= rank) {
+            // Midpoint of the bucket, never above the largest rate recorded
+            const double mid = static_cast<double>(bucketLow(i)) + (bucketWidth(i) - 1) / 2.0;
+            return std::min(mid, max_);
+        }
+    }
+    return max_;
+}
+
+std::string RateHistogram::encode() const {
+    if (count_ == 0) return std::string();
+    std::ostringstream out;
+    out << std::setprecision(15) << max_ << ';';
+    bool first = true;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        if (counts_[i] == 0) continue;
+        if (!first) out << ' ';
+        out << i << ':' << counts_[i];
+        first = false;
+    }
+    return out.str();
+}
+
+bool RateHistogram::decode(const std::string& text) {
+    clear();
+    if (text.empty()) return true;
+
+    const size_t semicolon = text.find(';');
+    if (semicolon == std::string::npos) return false;
+    char* end = nullptr;
+    const double max = std::strtod(text.c_str(), &end);
+    if (end != text.c_str() + semicolon) return false;
+
+    const char* p = text.c_str() + semicolon + 1;
+    while (*p) {
+        const unsigned long long index = std::strtoull(p, &end, 10);
+        if (end == p || *end != ':' || index >= kBuckets) {
+            clear();
+            return false;
+        }
+        p = end + 1;
+        const unsigned long long count = std::strtoull(p, &end, 10);
+        if (end == p) {
+            clear();
+            return false;
+        }
+        count_ += addSaturating(counts_[index], count);
+        p = end;
+        while (*p == ' ') ++p;
+    }
+    max_ = max;
+    return true;
+}
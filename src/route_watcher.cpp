@@ -0,0 +1,272 @@
+#include "../include/route_watcher.h"
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <vector>
+
+#ifdef __linux__
+#include <net/if.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#endif
+
+#ifdef __linux__
+namespace {
+
+constexpr size_t kReceiveBufferSize = 64 * 1024;
+
+int openRouteSocket(uint32_t groups) {
+    int fd = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) {
+        return -1;
+    }
+    sockaddr_nl local;
+    std::memset(&local, 0, sizeof(local));
+    local.nl_family = AF_NETLINK;
+    local.nl_groups = groups;
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool isDefaultRoute(const rtmsg* route) {
+    return route->rtm_dst_len == 0 &&
+           route->rtm_table == RT_TABLE_MAIN &&
+           route->rtm_type == RTN_UNICAST;
+}
+
+// Output interface and metric of a default route message
+bool parseDefaultRoute(const nlmsghdr* msg, int* ifindex, uint32_t* metric) {
+    const rtmsg* route = static_cast<const rtmsg*>(NLMSG_DATA(msg));
+    if (!isDefaultRoute(route)) {
+        return false;
+    }
+    *ifindex = 0;
+    *metric = 0;
+    int len = static_cast<int>(RTM_PAYLOAD(msg));
+    for (const rtattr* attr = RTM_RTA(route); RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+        if (attr->rta_type == RTA_OIF) {
+            std::memcpy(ifindex, RTA_DATA(attr), sizeof(int));
+        } else if (attr->rta_type == RTA_PRIORITY) {
+            std::memcpy(metric, RTA_DATA(attr), sizeof(uint32_t));
+        } else if (attr->rta_type == RTA_MULTIPATH && *ifindex == 0 &&
+                   RTA_PAYLOAD(attr) >= sizeof(rtnexthop)) {
+            const rtnexthop* hop = static_cast<const rtnexthop*>(RTA_DATA(attr));
+            *ifindex = hop->rtnh_ifindex;
+        }
+    }
+    return *ifindex > 0;
+}
+
+// Best default route for one address family, or an empty string
+std::string dumpDefaultRoute(int fd, unsigned char family, uint32_t seq,
+                             std::vector<char>& buf) {
+    struct {
+        nlmsghdr header;
+        rtmsg route;
+    } request;
+    std::memset(&request, 0, sizeof(request));
+    request.header.nlmsg_len = NLMSG_LENGTH(sizeof(rtmsg));
+    request.header.nlmsg_type = RTM_GETROUTE;
+    request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.header.nlmsg_seq = seq;
+    request.route.rtm_family = family;
+
+    if (::send(fd, &request, request.header.nlmsg_len, 0) < 0) {
+        return std::string();
+    }
+
+    int bestIndex = 0;
+    uint32_t bestMetric = 0;
+    for (;;) {
+        ssize_t received = ::recv(fd, buf.data(), buf.size(), 0);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        int remaining = static_cast<int>(received);
+        bool done = received == 0;
+        for (const nlmsghdr* msg = reinterpret_cast<const nlmsghdr*>(buf.data());
+             NLMSG_OK(msg, remaining); msg = NLMSG_NEXT(msg, remaining)) {
+            if (msg->nlmsg_seq != seq) {
+                continue;
+            }
+            if (msg->nlmsg_type == NLMSG_DONE || msg->nlmsg_type == NLMSG_ERROR) {
+                done = true;
+                break;
+            }
+            int ifindex;
+            uint32_t metric;
+            if (msg->nlmsg_type == RTM_NEWROUTE && parseDefaultRoute(msg, &ifindex, &metric)) {
+                if (bestIndex == 0 || metric < bestMetric) {
+                    bestIndex = ifindex;
+                    bestMetric = metric;
+                }
+            }
+        }
+        if (done) {
+            break;
+        }
+    }
+
+    char name[IF_NAMESIZE];
+    if (bestIndex > 0 && ::if_indextoname(static_cast<unsigned>(bestIndex), name)) {
+        return std::string(name);
+    }
+    return std::string();
+}
+
+// Whether a notification can change which interface carries the default route
+bool affectsDefaultRoute(const nlmsghdr* msg) {
+    switch (msg->nlmsg_type) {
+    case RTM_NEWROUTE:
+    case RTM_DELROUTE:
+        return isDefaultRoute(static_cast<const rtmsg*>(NLMSG_DATA(msg)));
+    case RTM_NEWLINK:
+    case RTM_DELLINK:
+        return true;
+    default:
+        return false;
+    }
+}
+
+} // namespace
+#endif
+
+RouteWatcher::RouteWatcher(Callback onChange)
+    : callback_(std::move(onChange)), fd_(-1), wakeFd_(-1), running_(false) {
+}
+
+RouteWatcher::~RouteWatcher() {
+    stop();
+}
+
+std::string RouteWatcher::queryDefaultInterface() {
+#ifdef __linux__
+    int fd = openRouteSocket(0);
+    if (fd < 0) {
+        return std::string();
+    }
+    std::vector<char> buf(kReceiveBufferSize);
+    std::string iface = dumpDefaultRoute(fd, AF_INET, 1, buf);
+    if (iface.empty()) {
+        iface = dumpDefaultRoute(fd, AF_INET6, 2, buf);
+    }
+    ::close(fd);
+    return iface;
+#else
+    return std::string();
+#endif
+}
+
+bool RouteWatcher::start(const std::string& current) {
+#ifdef __linux__
+    if (running_.load()) {
+        return true;
+    }
+    fd_ = openRouteSocket(RTMGRP_LINK | RTMGRP_IPV4_ROUTE | RTMGRP_IPV6_ROUTE);
+    if (fd_ < 0) {
+        return false;
+    }
+    wakeFd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeFd_ < 0) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    current_ = current;
+    running_.store(true);
+    thread_ = std::thread(&RouteWatcher::run, this);
+    return true;
+#else
+    (void)current;
+    return false;
+#endif
+}
+
+void RouteWatcher::stop() {
+#ifdef __linux__
+    if (!running_.exchange(false)) {
+        return;
+    }
+    uint64_t one = 1;
+    ssize_t written = ::write(wakeFd_, &one, sizeof(one));
+    (void)written;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    ::close(fd_);
+    ::close(wakeFd_);
+    fd_ = -1;
+    wakeFd_ = -1;
+#endif
+}
+
+void RouteWatcher::run() {
+#ifdef __linux__
+    std::vector<char> buf(kReceiveBufferSize);
+    pollfd fds[2];
+    fds[0].fd = fd_;
+    fds[0].events = POLLIN;
+    fds[1].fd = wakeFd_;
+    fds[1].events = POLLIN;
+
+    while (running_.load()) {
+        fds[0].revents = 0;
+        fds[1].revents = 0;
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+        if (!(fds[0].revents & POLLIN)) {
+            continue;
+        }
+
+        // Drain everything that is queued so a burst of notifications
+        // (e.g. a VPN bringing up several routes) costs one re-query
+        bool relevant = false;
+        for (;;) {
+            ssize_t received = ::recv(fd_, buf.data(), buf.size(), MSG_DONTWAIT);
+            if (received < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == ENOBUFS) {
+                    relevant = true; // missed events; resynchronise
+                    continue;
+                }
+                break;
+            }
+            int remaining = static_cast<int>(received);
+            for (const nlmsghdr* msg = reinterpret_cast<const nlmsghdr*>(buf.data());
+                 NLMSG_OK(msg, remaining); msg = NLMSG_NEXT(msg, remaining)) {
+                if (affectsDefaultRoute(msg)) {
+                    relevant = true;
+                }
+            }
+        }
+        if (!relevant) {
+            continue;
+        }
+
+        std::string iface = queryDefaultInterface();
+        if (iface != current_) {
+            current_ = iface;
+            callback_(iface);
+        }
+    }
+#endif
+}
@@ -0,0 +1,302 @@
+#include "../include/rrd_store.h"
+#include "../include/logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace rrd;
+
+namespace {
+
+constexpr int kReadAttempts = 4;
+
+static_assert(sizeof(FileHeader) == 64, "history file header layout changed");
+static_assert(sizeof(Slot) == 64, "history slot layout changed");
+
+int64_t alignDown(int64_t t, uint32_t resolution) {
+    return t - t % static_cast<int64_t>(resolution);
+}
+
+size_t slotIndex(int64_t start, const TierSpec& spec) {
+    return static_cast<size_t>((start / spec.resolution) % spec.capacity);
+}
+
+bool headerMatches(const FileHeader* header, const TierSpec& spec) {
+    return header->magic == kMagic && header->schema_version == kSchemaVersion &&
+           header->resolution == spec.resolution && header->capacity == spec.capacity &&
+           header->slot_size == sizeof(Slot);
+}
+
+// mkdir -p
+bool makeDirectories(const std::string& path) {
+    for (size_t pos = 1; pos <= path.size(); ++pos) {
+        if (pos != path.size() && path[pos] != '/') {
+            continue;
+        }
+        const std::string prefix = path.substr(0, pos);
+        if (::mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Copy a slot the writer may be updating; false if it kept changing
+bool readSlot(const Slot& slot, Point& out) {
+    for (int attempt = 0; attempt < kReadAttempts; ++attempt) {
+        const uint32_t before = slot.stamp.load(std::memory_order_acquire);
+        if (before & 1u) {
+            continue;
+        }
+        out.start = slot.start;
+        out.samples = slot.samples;
+        out.rx_bytes = slot.rx_bytes;
+        out.tx_bytes = slot.tx_bytes;
+        out.seconds = slot.seconds;
+        out.rx_min = slot.rx_min;
+        out.rx_max = slot.rx_max;
+        out.tx_min = slot.tx_min;
+        out.tx_max = slot.tx_max;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.stamp.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+std::string rrd::defaultDirectory() {
+    const char* home = std::getenv("HOME");
+    return std::string(home ? home : ".") + "/.config/linux-speed-meter";
+}
+
+std::string rrd::directoryFromEnvironment() {
+    const char* value = std::getenv("SPEED_METER_HISTORY");
+    if (!value || !*value || std::strcmp(value, "0") == 0 || std::strcmp(value, "off") == 0) {
+        return std::string();
+    }
+    if (std::strcmp(value, "1") == 0 || std::strcmp(value, "on") == 0) {
+        return defaultDirectory();
+    }
+    if (value[0] == '~') {
+        const char* home = std::getenv("HOME");
+        if (home) {
+            return std::string(home) + (value + 1);
+        }
+    }
+    return value;
+}
+
+bool rrd::read(const std::string& directory, Tier tier, int64_t from, int64_t to, std::vector<Point>& out) {
+    out.clear();
+    const TierSpec& spec = kTiers[static_cast<size_t>(tier)];
+    const std::string path = directory + "/" + spec.file;
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    const size_t size = fileBytes(spec);
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != size) {
+        ::close(fd);
+        return false;
+    }
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    const FileHeader* header = static_cast<const FileHeader*>(map);
+    if (!headerMatches(header, spec)) {
+        ::munmap(map, size);
+        return false;
+    }
+    const Slot* slots = reinterpret_cast<const Slot*>(static_cast<const char*>(map) + sizeof(FileHeader));
+
+    // Only the newest `capacity` slots of the window can still be on file
+    if (to > from) {
+        const int64_t last = alignDown(to - 1, spec.resolution);
+        const int64_t oldest = last - static_cast<int64_t>(spec.capacity - 1) * spec.resolution;
+        int64_t start = std::max(alignDown(from, spec.resolution), oldest);
+        if (start < from) {
+            start += spec.resolution;
+        }
+        for (; start <= last; start += spec.resolution) {
+            Point point;
+            if (readSlot(slots[slotIndex(start, spec)], point) && point.start == start && point.samples > 0) {
+                out.push_back(point);
+            }
+        }
+    }
+    ::munmap(map, size);
+    return true;
+}
+
+RrdStore::RrdStore() : last_rx_bytes_(0), last_tx_bytes_(0) {
+    for (Mapping& tier : tiers_) {
+        tier = Mapping{-1, nullptr, 0, nullptr};
+    }
+}
+
+RrdStore::~RrdStore() {
+    close();
+}
+
+bool RrdStore::open(const std::string& directory) {
+    close();
+    if (!makeDirectories(directory)) {
+        LOG_WARN("Cannot create history directory", logging::field("dir", directory),
+                 logging::field("error", std::strerror(errno)));
+        return false;
+    }
+    for (size_t i = 0; i < kTierCount; ++i) {
+        const TierSpec& spec = kTiers[i];
+        const std::string path = directory + "/" + spec.file;
+        const size_t size = fileBytes(spec);
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            LOG_WARN("Cannot open history file", logging::field("path", path),
+                     logging::field("error", std::strerror(errno)));
+            close();
+            return false;
+        }
+        tiers_[i].fd = fd;
+        if (::flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            LOG_WARN("History files are in use by another collector", logging::field("path", path));
+            close();
+            return false;
+        }
+
+        struct stat st;
+        bool fresh = ::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != size;
+        void* map = MAP_FAILED;
+        if (!fresh) {
+            map = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (map != MAP_FAILED && !headerMatches(static_cast<FileHeader*>(map), spec)) {
+                LOG_WARN("Discarding history file of another layout", logging::field("path", path));
+                ::munmap(map, size);
+                map = MAP_FAILED;
+                fresh = true;
+            }
+        }
+        if (fresh) {
+            // Reserve every block now so later writes never need space
+            int error = ::ftruncate(fd, 0) == 0 ? 0 : errno;
+            if (error == 0) {
+                error = ::posix_fallocate(fd, 0, static_cast<off_t>(size));
+            }
+            if (error != 0) {
+                LOG_WARN("Cannot allocate history file", logging::field("path", path),
+                         logging::field("bytes", static_cast<long long>(size)),
+                         logging::field("error", std::strerror(error)));
+                close();
+                return false;
+            }
+            map = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        if (map == MAP_FAILED) {
+            LOG_WARN("Cannot map history file", logging::field("path", path),
+                     logging::field("error", std::strerror(errno)));
+            close();
+            return false;
+        }
+        tiers_[i].map = map;
+        tiers_[i].size = size;
+        tiers_[i].slots = reinterpret_cast<Slot*>(static_cast<char*>(map) + sizeof(FileHeader));
+
+        if (fresh) {
+            // Slots are zero (never written); the magic goes last so a
+            // crash mid-layout leaves a file the next open lays out again
+            FileHeader* header = static_cast<FileHeader*>(map);
+            header->schema_version = kSchemaVersion;
+            header->resolution = spec.resolution;
+            header->capacity = spec.capacity;
+            header->slot_size = static_cast<uint32_t>(sizeof(Slot));
+            header->created = static_cast<int64_t>(std::time(nullptr));
+            std::atomic_thread_fence(std::memory_order_release);
+            header->magic = kMagic;
+            ::msync(map, sizeof(FileHeader), MS_SYNC);
+        }
+    }
+    last_rx_bytes_ = 0;
+    last_tx_bytes_ = 0;
+    LOG_INFO("Recording history", logging::field("dir", directory),
+             logging::field("bytes", static_cast<long long>(kTotalFileBytes)));
+    return true;
+}
+
+void RrdStore::close() {
+    for (Mapping& tier : tiers_) {
+        if (tier.map) {
+            ::munmap(tier.map, tier.size);
+        }
+        if (tier.fd >= 0) {
+            ::close(tier.fd);  // drops the flock
+        }
+        tier = Mapping{-1, nullptr, 0, nullptr};
+    }
+}
+
+void RrdStore::record(const MetricsSnapshot& metrics, double seconds, int64_t now) {
+    if (!tiers_[0].slots) {
+        return;
+    }
+    if (metrics.total_rx_bytes < last_rx_bytes_ || metrics.total_tx_bytes < last_tx_bytes_) {
+        // Totals restarted; nothing sensible to attribute
+        last_rx_bytes_ = metrics.total_rx_bytes;
+        last_tx_bytes_ = metrics.total_tx_bytes;
+        return;
+    }
+    const uint64_t rx_bytes = metrics.total_rx_bytes - last_rx_bytes_;
+    const uint64_t tx_bytes = metrics.total_tx_bytes - last_tx_bytes_;
+    last_rx_bytes_ = metrics.total_rx_bytes;
+    last_tx_bytes_ = metrics.total_tx_bytes;
+    if (now <= 0 || seconds <= 0.0) {
+        return;
+    }
+    const float rx_rate = static_cast<float>(metrics.instant_rx_rate);
+    const float tx_rate = static_cast<float>(metrics.instant_tx_rate);
+    for (size_t i = 0; i < kTierCount; ++i) {
+        fold(kTiers[i], tiers_[i].slots, now, seconds, rx_bytes, tx_bytes, rx_rate, tx_rate);
+    }
+}
+
+void RrdStore::fold(const TierSpec& spec, Slot* slots, int64_t now, double seconds,
+                    uint64_t rx_bytes, uint64_t tx_bytes, float rx_rate, float tx_rate) {
+    const int64_t start = alignDown(now, spec.resolution);
+    Slot& slot = slots[slotIndex(start, spec)];
+    const uint32_t stamp = slot.stamp.load(std::memory_order_relaxed);
+    slot.stamp.store(stamp | 1u, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    if (slot.start != start) {
+        // Left from an earlier lap, or never written
+        slot.samples = 0;
+        slot.start = start;
+        slot.rx_bytes = 0;
+        slot.tx_bytes = 0;
+        slot.seconds = 0.0;
+        slot.rx_min = rx_rate;
+        slot.rx_max = rx_rate;
+        slot.tx_min = tx_rate;
+        slot.tx_max = tx_rate;
+    }
+    slot.samples += 1;
+    slot.rx_bytes += rx_bytes;
+    slot.tx_bytes += tx_bytes;
+    slot.seconds += seconds;
+    slot.rx_min = std::min(slot.rx_min, rx_rate);
+    slot.rx_max = std::max(slot.rx_max, rx_rate);
+    slot.tx_min = std::min(slot.tx_min, tx_rate);
+    slot.tx_max = std::max(slot.tx_max, tx_rate);
+    slot.stamp.store((stamp | 1u) + 1, std::memory_order_release);
+}
@@ -0,0 +1,112 @@
+#include "../include/sample_engine.h"
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// A filter fed garbage (inf after a zero interval, NaN) never reaches the UI
+double finiteRate(double rate) {
+    return std::isfinite(rate) && rate > 0.0 ? rate : 0.0;
+}
+
+} // namespace
+
+SampleEngine::SampleEngine(RateFilterKind filter)
+    : metrics_(),
+      last_(),
+      haveBaseline_(false),
+      lastSampleNs_(0),
+      deltaBytes_(0),
+      elapsedSeconds_(0.0),
+      rxFilter_(filter),
+      txFilter_(filter),
+      rxPacketFilter_(filter),
+      txPacketFilter_(filter) {
+}
+
+void SampleEngine::rebaseline(const NetStats& stats, int64_t sampleNs) {
+    last_ = stats;
+    haveBaseline_ = true;
+    lastSampleNs_ = sampleNs;
+    deltaBytes_ = 0;
+    elapsedSeconds_ = 0.0;
+    rxFilter_.reset();
+    txFilter_.reset();
+    rxPacketFilter_.reset();
+    txPacketFilter_.reset();
+    metrics_.instant_rx_rate = 0.0;
+    metrics_.instant_tx_rate = 0.0;
+    metrics_.rx_rate = 0.0;
+    metrics_.tx_rate = 0.0;
+    metrics_.rx_packet_rate = 0.0;
+    metrics_.tx_packet_rate = 0.0;
+    metrics_.rx_drop_rate = 0.0;
+    metrics_.tx_drop_rate = 0.0;
+    metrics_.rx_error_rate = 0.0;
+    metrics_.tx_error_rate = 0.0;
+    metrics_.sample_ns = sampleNs;
+}
+
+bool SampleEngine::update(const NetStats& stats, int64_t sampleNs, double nominalSeconds) {
+    if (!haveBaseline_) {
+        rebaseline(stats, sampleNs);
+        return false;
+    }
+    // Rates use the real time between the two reads, not the nominal
+    // period, so a late wakeup never shows up as a burst
+    double elapsed = static_cast<double>(sampleNs - lastSampleNs_) / 1e9;
+    if (elapsed <= 0.0) {
+        elapsed = nominalSeconds > 0.0 ? nominalSeconds : 1.0;
+    }
+    lastSampleNs_ = sampleNs;
+
+    const uint64_t rx = netCounterDelta(stats.rx_bytes, last_.rx_bytes);
+    const uint64_t tx = netCounterDelta(stats.tx_bytes, last_.tx_bytes);
+    const uint64_t rxPackets = netCounterDelta(stats.rx_packets, last_.rx_packets);
+    const uint64_t txPackets = netCounterDelta(stats.tx_packets, last_.tx_packets);
+    const uint64_t rxDropped = netCounterDelta(stats.rx_dropped, last_.rx_dropped);
+    const uint64_t txDropped = netCounterDelta(stats.tx_dropped, last_.tx_dropped);
+    const uint64_t rxErrors = netCounterDelta(stats.rx_errors, last_.rx_errors);
+    const uint64_t txErrors = netCounterDelta(stats.tx_errors, last_.tx_errors);
+    last_ = stats;
+    deltaBytes_ = rx + tx;
+    elapsedSeconds_ = elapsed;
+
+    const double instantRx = static_cast<double>(rx) / elapsed;
+    const double instantTx = static_cast<double>(tx) / elapsed;
+    metrics_.instant_rx_rate = instantRx;
+    metrics_.instant_tx_rate = instantTx;
+    metrics_.rx_rate = finiteRate(rxFilter_.update(instantRx, elapsed));
+    metrics_.tx_rate = finiteRate(txFilter_.update(instantTx, elapsed));
+    metrics_.rx_packet_rate = finiteRate(rxPacketFilter_.update(static_cast<double>(rxPackets) / elapsed, elapsed));
+    metrics_.tx_packet_rate = finiteRate(txPacketFilter_.update(static_cast<double>(txPackets) / elapsed, elapsed));
+    metrics_.rx_drop_rate = static_cast<double>(rxDropped) / elapsed;
+    metrics_.tx_drop_rate = static_cast<double>(txDropped) / elapsed;
+    metrics_.rx_error_rate = static_cast<double>(rxErrors) / elapsed;
+    metrics_.tx_error_rate = static_cast<double>(txErrors) / elapsed;
+    metrics_.total_rx_bytes += rx;
+    metrics_.total_tx_bytes += tx;
+    metrics_.total_rx_packets += rxPackets;
+    metrics_.total_tx_packets += txPackets;
+    metrics_.total_rx_dropped += rxDropped;
+    metrics_.total_tx_dropped += txDropped;
+    metrics_.total_rx_errors += rxErrors;
+    metrics_.total_tx_errors += txErrors;
+    metrics_.sample_ns = sampleNs;
+    return true;
+}
+
+void SampleEngine::setInterface(const std::string& name) {
+    std::memset(metrics_.iface, 0, sizeof(metrics_.iface));
+    name.copy(metrics_.iface, sizeof(metrics_.iface) - 1);
+}
+
+void SampleEngine::setSampling(int32_t periodMs, bool idle) {
+    metrics_.sample_period_ms = periodMs;
+    metrics_.sampling_idle = idle;
+}
+
+void SampleEngine::publish(Seqlock<MetricsSnapshot>& out) {
+    ++metrics_.seq;
+    out.store(metrics_);
+}
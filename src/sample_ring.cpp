@@ -0,0 +1,306 @@
+#include "../include/sample_ring.h"
+#include "../include/logger.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace sample_ring;
+
+namespace {
+
+uint32_t roundUpPowerOfTwo(uint32_t value) {
+    uint32_t capacity = 1;
+    while (capacity < value && capacity < (1u << 30)) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+uint64_t clockEpoch() {
+    timespec ts;
+    ::clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+Slot* slotAt(char* slots, uint64_t index, uint32_t mask) {
+    return reinterpret_cast<Slot*>(slots + (index & mask) * kSlotStride);
+}
+
+const Slot* slotAt(const char* slots, uint64_t index, uint32_t mask) {
+    return reinterpret_cast<const Slot*>(slots + (index & mask) * kSlotStride);
+}
+
+// Tell readers of an object about to be replaced that its writer is gone
+void retire(int fd, size_t size) {
+    if (size < sizeof(Header)) {
+        return;
+    }
+    void* map = ::mmap(nullptr, sizeof(Header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map != MAP_FAILED) {
+        static_cast<Header*>(map)->writer_open.store(0, std::memory_order_release);
+        ::munmap(map, sizeof(Header));
+    }
+}
+
+} // namespace
+
+std::string sample_ring::defaultRingName() {
+    return "/speed-meter-" + std::to_string(::getuid());
+}
+
+std::string sample_ring::ringNameFromEnvironment() {
+    const char* value = std::getenv("SPEED_METER_RING");
+    if (!value || !*value || std::strcmp(value, "0") == 0 || std::strcmp(value, "off") == 0) {
+        return std::string();
+    }
+    if (std::strcmp(value, "1") == 0 || std::strcmp(value, "on") == 0) {
+        return defaultRingName();
+    }
+    return value[0] == '/' ? std::string(value) : "/" + std::string(value);
+}
+
+SampleRingWriter::SampleRingWriter()
+    : header_(nullptr), slots_(nullptr), next_(0), mask_(0), size_(0), fd_(-1) {
+}
+
+SampleRingWriter::~SampleRingWriter() {
+    close();
+}
+
+bool SampleRingWriter::open(const std::string& name, uint32_t capacity) {
+    close();
+    capacity = roundUpPowerOfTwo(capacity == 0 ? 1 : capacity);
+    const size_t size = mappingSize(capacity);
+
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_WARN("Cannot create sample ring", logging::field("name", name),
+                 logging::field("error", std::strerror(errno)));
+        return false;
+    }
+    // One writer per ring: a second one would reset the index under the
+    // first and interleave stamps in the same slots
+    if (::flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        LOG_WARN("Sample ring is in use by another writer", logging::field("name", name));
+        ::close(fd);
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size != 0 && static_cast<size_t>(st.st_size) != size) {
+        // A ring of another size: readers keep their old mapping, so give
+        // them a fresh object rather than resizing theirs under them
+        retire(fd, static_cast<size_t>(st.st_size));
+        ::shm_unlink(name.c_str());
+        const int fresh = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        ::close(fd);
+        fd = fresh;
+        if (fd < 0 || ::flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            return false;
+        }
+    }
+    ::fchmod(fd, 0644); // whatever the umask
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        ::close(fd);
+        return false;
+    }
+    void* map = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+
+    fd_ = fd;
+    header_ = static_cast<Header*>(map);
+    slots_ = static_cast<char*>(map) + kHeaderSize;
+    mask_ = capacity - 1;
+    size_ = size;
+    next_ = 0;
+
+    // A new epoch first, so readers of a previous writer resync before the
+    // index and stamps start over
+    const uint64_t previous = header_->epoch.load(std::memory_order_relaxed);
+    const uint64_t epoch = clockEpoch();
+    header_->epoch.store(epoch > previous ? epoch : previous + 1, std::memory_order_release);
+    header_->write_index.store(0, std::memory_order_release);
+    for (uint32_t i = 0; i < capacity; ++i) {
+        slotAt(slots_, i, mask_)->stamp.store(0, std::memory_order_relaxed);
+    }
+    header_->magic = kMagic;
+    header_->schema_version = kSchemaVersion;
+    header_->slot_stride = static_cast<uint32_t>(kSlotStride);
+    header_->capacity = capacity;
+    header_->payload_size = static_cast<uint32_t>(sizeof(MetricsSnapshot));
+    header_->writer_open.store(1, std::memory_order_release);
+    LOG_INFO("Publishing samples to shared memory", logging::field("name", name),
+             logging::field("slots", static_cast<unsigned>(capacity)));
+    return true;
+}
+
+void SampleRingWriter::close() {
+    if (!header_) {
+        return;
+    }
+    header_->writer_open.store(0, std::memory_order_release);
+    ::munmap(header_, size_);
+    ::close(fd_);  // drops the flock
+    header_ = nullptr;
+    slots_ = nullptr;
+    fd_ = -1;
+}
+
+void SampleRingWriter::publish(const MetricsSnapshot& snapshot) {
+    if (!header_) {
+        return;
+    }
+    uint64_t words[kPayloadWords] = {};
+    std::memcpy(words, &snapshot, sizeof(snapshot));
+
+    const uint64_t index = next_++;
+    Slot* slot = slotAt(slots_, index, mask_);
+    slot->stamp.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kPayloadWords; ++i) {
+        slot->words[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot->stamp.store(2 * index + 2, std::memory_order_release);
+    header_->write_index.store(index + 1, std::memory_order_release);
+}
+
+SampleRingReader::SampleRingReader()
+    : header_(nullptr), slots_(nullptr), cursor_(0), epoch_(0), mask_(0), size_(0) {
+}
+
+SampleRingReader::~SampleRingReader() {
+    close();
+}
+
+bool SampleRingReader::open(const std::string& name) {
+    close();
+    const int fd = ::shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < kHeaderSize) {
+        ::close(fd);
+        return false;
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    const Header* header = static_cast<const Header*>(map);
+    const uint32_t capacity = header->capacity;
+    if (header->magic != kMagic || header->schema_version != kSchemaVersion ||
+        header->payload_size != sizeof(MetricsSnapshot) || header->slot_stride != kSlotStride ||
+        capacity == 0 || (capacity & (capacity - 1)) != 0 || mappingSize(capacity) > size) {
+        ::munmap(map, size);
+        return false;
+    }
+    header_ = header;
+    slots_ = static_cast<const char*>(map) + kHeaderSize;
+    mask_ = capacity - 1;
+    size_ = size;
+    skipToEnd();
+    return true;
+}
+
+void SampleRingReader::close() {
+    if (!header_) {
+        return;
+    }
+    ::munmap(const_cast<Header*>(header_), size_);
+    header_ = nullptr;
+    slots_ = nullptr;
+}
+
+uint64_t SampleRingReader::writeIndex() const {
+    return header_ ? header_->write_index.load(std::memory_order_acquire) : 0;
+}
+
+bool SampleRingReader::writerGone() const {
+    return !header_ || header_->writer_open.load(std::memory_order_acquire) == 0;
+}
+
+void SampleRingReader::skipToEnd() {
+    if (!header_) {
+        return;
+    }
+    epoch_ = header_->epoch.load(std::memory_order_acquire);
+    cursor_ = header_->write_index.load(std::memory_order_acquire);
+}
+
+bool SampleRingReader::readSlot(uint64_t index, MetricsSnapshot& out) const {
+    const Slot* slot = slotAt(slots_, index, mask_);
+    const uint64_t want = 2 * index + 2;
+    if (slot->stamp.load(std::memory_order_acquire) != want) {
+        return false;
+    }
+    uint64_t words[kPayloadWords];
+    for (size_t i = 0; i < kPayloadWords; ++i) {
+        words[i] = slot->words[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot->stamp.load(std::memory_order_relaxed) != want) {
+        return false; // lapped by the writer mid-copy
+    }
+    std::memcpy(&out, words, sizeof(out));
+    return true;
+}
+
+bool SampleRingReader::latest(MetricsSnapshot& out) const {
+    if (!header_) {
+        return false;
+    }
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        const uint64_t written = header_->write_index.load(std::memory_order_acquire);
+        if (written == 0) {
+            return false;
+        }
+        if (readSlot(written - 1, out)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SampleRingReader::next(MetricsSnapshot& out, uint64_t* lost) {
+    if (!header_) {
+        return false;
+    }
+    if (header_->epoch.load(std::memory_order_acquire) != epoch_) {
+        // A new writer started over; follow it from its first sample
+        epoch_ = header_->epoch.load(std::memory_order_acquire);
+        cursor_ = 0;
+    }
+    for (;;) {
+        const uint64_t written = header_->write_index.load(std::memory_order_acquire);
+        if (cursor_ >= written) {
+            return false;
+        }
+        const uint64_t capacity = static_cast<uint64_t>(mask_) + 1;
+        if (written - cursor_ > capacity) {
+            if (lost) *lost += written - cursor_ - capacity;
+            cursor_ = written - capacity;
+        }
+        if (readSlot(cursor_, out)) {
+            ++cursor_;
+            return true;
+        }
+        // Overwritten between the index load and the copy
+        if (lost) ++*lost;
+        ++cursor_;
+    }
+}
@@ -0,0 +1,245 @@
+#include "../include/sample_scheduler.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <ctime>
+#include <thread>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr int64_t kNsPerSecond = 1000 * 1000 * 1000;
+
+int64_t clampPeriod(std::chrono::milliseconds period) {
+    const int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(period).count();
+    return ns < SampleScheduler::kMinPeriodNs ? SampleScheduler::kMinPeriodNs : ns;
+}
+
+#ifdef __linux__
+int64_t readClock(clockid_t clock) {
+    timespec ts;
+    ::clock_gettime(clock, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * kNsPerSecond + ts.tv_nsec;
+}
+
+timespec toTimespec(int64_t ns) {
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(ns / kNsPerSecond);
+    ts.tv_nsec = static_cast<long>(ns % kNsPerSecond);
+    return ts;
+}
+#endif
+
+} // namespace
+
+constexpr int64_t SampleScheduler::kMinPeriodNs;
+
+SampleScheduler::SampleScheduler(std::chrono::milliseconds period)
+    : period_ns_(clampPeriod(period)),
+      armed_period_ns_(0),
+      next_deadline_ns_(0),
+      last_monotonic_ns_(monotonicNs()),
+      last_boottime_ns_(boottimeNs()),
+      stopped_(false),
+      timer_fd_(-1),
+      wake_fd_(-1) {
+#ifdef __linux__
+    timer_fd_ = ::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    wake_fd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+#endif
+    const int64_t period_ns = period_ns_.load();
+    arm(last_monotonic_ns_ + period_ns, period_ns);
+}
+
+SampleScheduler::~SampleScheduler() {
+    stop();
+#ifdef __linux__
+    if (timer_fd_ >= 0) ::close(timer_fd_);
+    if (wake_fd_ >= 0) ::close(wake_fd_);
+#endif
+}
+
+int64_t SampleScheduler::monotonicNs() {
+#ifdef __linux__
+    return readClock(CLOCK_MONOTONIC);
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+int64_t SampleScheduler::boottimeNs() {
+#ifdef __linux__
+    return readClock(CLOCK_BOOTTIME);
+#else
+    return monotonicNs(); // no suspend-aware clock; suspend goes unnoticed
+#endif
+}
+
+void SampleScheduler::setPeriod(std::chrono::milliseconds period) {
+    period_ns_.store(clampPeriod(period));
+}
+
+std::chrono::milliseconds SampleScheduler::period() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::nanoseconds(period_ns_.load()));
+}
+
+bool SampleScheduler::arm(int64_t deadline_ns, int64_t period_ns) {
+    next_deadline_ns_ = deadline_ns;
+    armed_period_ns_ = period_ns;
+#ifdef __linux__
+    if (timer_fd_ < 0) {
+        return false;
+    }
+    itimerspec spec;
+    spec.it_value = toTimespec(deadline_ns);
+    spec.it_interval = toTimespec(period_ns);
+    return ::timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr) == 0;
+#else
+    return true;
+#endif
+}
+
+bool SampleScheduler::wait(SampleTick& tick) {
+    if (stopped_.load()) {
+        return false;
+    }
+
+    // A period change keeps the grid anchored at the last deadline
+    const int64_t period_ns = period_ns_.load();
+    if (period_ns != armed_period_ns_) {
+        int64_t deadline = next_deadline_ns_ - armed_period_ns_ + period_ns;
+        const int64_t now = monotonicNs();
+        if (deadline <= now) {
+            deadline = now + period_ns;
+        }
+        arm(deadline, period_ns);
+    }
+
+    uint64_t expirations = 1;
+#ifdef __linux__
+    if (timer_fd_ >= 0) {
+        pollfd fds[2];
+        fds[0].fd = timer_fd_;
+        fds[0].events = POLLIN;
+        fds[1].fd = wake_fd_;
+        fds[1].events = POLLIN;
+        for (;;) {
+            fds[0].revents = 0;
+            fds[1].revents = 0;
+            const int ready = ::poll(fds, wake_fd_ >= 0 ? 2 : 1, -1);
+            if (ready < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ready < 0 || stopped_.load() || (fds[1].revents & POLLIN)) {
+                return false;
+            }
+            if ((fds[0].revents & POLLIN) &&
+                ::read(timer_fd_, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+                break;
+            }
+        }
+        next_deadline_ns_ += static_cast<int64_t>(expirations) * armed_period_ns_;
+    } else
+#endif
+    {
+        // Portable path: sleep until the absolute deadline on the same grid
+        const auto deadline = std::chrono::steady_clock::time_point(
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::nanoseconds(next_deadline_ns_)));
+        std::unique_lock<std::mutex> lock(wait_mutex_);
+        if (wait_cv_.wait_until(lock, deadline, [this] { return stopped_.load(); })) {
+            return false;
+        }
+        const int64_t now = monotonicNs();
+        expirations = 1 + static_cast<uint64_t>((now - next_deadline_ns_) / armed_period_ns_);
+        next_deadline_ns_ += static_cast<int64_t>(expirations) * armed_period_ns_;
+    }
+
+    tick.monotonic_ns = monotonicNs();
+    tick.boottime_ns = boottimeNs();
+    tick.expirations = expirations;
+
+    const int64_t monotonic_delta = tick.monotonic_ns - last_monotonic_ns_;
+    const int64_t boottime_delta = tick.boottime_ns - last_boottime_ns_;
+    // CLOCK_MONOTONIC stops during suspend, CLOCK_BOOTTIME does not
+    tick.resumed = boottime_delta - monotonic_delta > armed_period_ns_;
+    tick.interval_seconds = static_cast<double>(boottime_delta) / kNsPerSecond;
+    last_monotonic_ns_ = tick.monotonic_ns;
+    last_boottime_ns_ = tick.boottime_ns;
+    return true;
+}
+
+void SampleScheduler::stop() {
+    if (stopped_.exchange(true)) {
+        return;
+    }
+#ifdef __linux__
+    if (wake_fd_ >= 0) {
+        uint64_t one = 1;
+        ssize_t written = ::write(wake_fd_, &one, sizeof(one));
+        (void)written;
+    }
+#endif
+    std::lock_guard<std::mutex> lock(wait_mutex_);
+    wait_cv_.notify_all();
+}
+
+constexpr std::chrono::milliseconds AdaptiveSampling::kIdleGrace;
+
+AdaptiveSampling::AdaptiveSampling(std::chrono::milliseconds fast, std::chrono::milliseconds slow)
+    : fast_(fast),
+      slow_(slow > fast ? slow : fast),
+      current_(fast),
+      quiet_for_(0) {
+}
+
+std::chrono::milliseconds AdaptiveSampling::next(uint64_t delta_bytes) {
+    if (delta_bytes != 0) {
+        reset();
+        return current_;
+    }
+    quiet_for_ += current_;
+    if (quiet_for_ >= kIdleGrace) {
+        current_ = std::min(current_ * 2, slow_);
+    }
+    return current_;
+}
+
+void AdaptiveSampling::reset() {
+    current_ = fast_;
+    quiet_for_ = std::chrono::milliseconds(0);
+}
+
+static std::chrono::milliseconds intervalFromEnvironment(const char* name,
+                                                         std::chrono::milliseconds fallback) {
+    const char* value = std::getenv(name);
+    if (!value || !*value) {
+        return fallback;
+    }
+    char* end = nullptr;
+    const long ms = std::strtol(value, &end, 10);
+    if (*end != '\0' || ms <= 0) {
+        return fallback;
+    }
+    return std::chrono::milliseconds(ms < 10 ? 10 : ms);
+}
+
+std::chrono::milliseconds sampleIntervalFromEnvironment(std::chrono::milliseconds fallback) {
+    return intervalFromEnvironment("SPEED_METER_INTERVAL_MS", fallback);
+}
+
+std::chrono::milliseconds maxSampleIntervalFromEnvironment(std::chrono::milliseconds fallback) {
+    return intervalFromEnvironment("SPEED_METER_MAX_INTERVAL_MS", fallback);
+}
+
+std::chrono::milliseconds processIntervalFromEnvironment(std::chrono::milliseconds fallback) {
+    return intervalFromEnvironment("SPEED_METER_PROCESS_INTERVAL_MS", fallback);
+}
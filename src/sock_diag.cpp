@@ -0,0 +1,152 @@
+#include "../include/sock_diag.h"
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/sock_diag.h>
+#include <linux/inet_diag.h>
+#include <linux/tcp.h>
+#endif
+
+namespace {
+
+constexpr size_t kReceiveBufferSize = 256 * 1024; // ~1500 sockets per recv
+
+} // namespace
+
+SockDiag::SockDiag() : fd_(-1), seq_(0) {
+#ifdef __linux__
+    fd_ = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+    if (fd_ < 0) {
+        return;
+    }
+    timeval timeout{1, 0};
+    ::setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    buf_.resize(kReceiveBufferSize);
+#endif
+}
+
+SockDiag::~SockDiag() {
+#ifdef __linux__
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+#endif
+}
+
+bool SockDiag::dumpAll(uint32_t statesMask, Visitor visit, void* context) {
+#ifdef __linux__
+    const bool v4 = dump(AF_INET, statesMask, visit, context);
+    const bool v6 = dump(AF_INET6, statesMask, visit, context);
+    return v4 && v6;
+#else
+    (void)statesMask;
+    (void)visit;
+    (void)context;
+    return false;
+#endif
+}
+
+bool SockDiag::dump(uint8_t family, uint32_t statesMask, Visitor visit, void* context) {
+#ifdef __linux__
+    if (fd_ < 0) {
+        return false;
+    }
+
+    struct {
+        nlmsghdr header;
+        inet_diag_req_v2 request;
+    } message;
+    std::memset(&message, 0, sizeof(message));
+    message.header.nlmsg_len = sizeof(message);
+    message.header.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    message.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    message.header.nlmsg_seq = ++seq_;
+    message.request.sdiag_family = family;
+    message.request.sdiag_protocol = IPPROTO_TCP;
+    message.request.idiag_states = statesMask;
+    message.request.idiag_ext = 1 << (INET_DIAG_INFO - 1);
+
+    sockaddr_nl kernel;
+    std::memset(&kernel, 0, sizeof(kernel));
+    kernel.nl_family = AF_NETLINK;
+    if (::sendto(fd_, &message, sizeof(message), 0,
+                 reinterpret_cast<sockaddr*>(&kernel), sizeof(kernel)) < 0) {
+        return false;
+    }
+
+    TcpSocketInfo info;
+    for (;;) {
+        const ssize_t received = ::recv(fd_, buf_.data(), buf_.size(), 0);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        int remaining = static_cast<int>(received);
+        for (const nlmsghdr* msg = reinterpret_cast<const nlmsghdr*>(buf_.data());
+             NLMSG_OK(msg, remaining); msg = NLMSG_NEXT(msg, remaining)) {
+            if (msg->nlmsg_seq != seq_) {
+                continue; // late reply to an earlier, abandoned dump
+            }
+            if (msg->nlmsg_type == NLMSG_DONE) {
+                return true;
+            }
+            if (msg->nlmsg_type == NLMSG_ERROR) {
+                return false;
+            }
+            if (msg->nlmsg_type != SOCK_DIAG_BY_FAMILY) {
+                continue;
+            }
+
+            const inet_diag_msg* diag = static_cast<const inet_diag_msg*>(NLMSG_DATA(msg));
+            std::memset(&info, 0, sizeof(info));
+            info.inode = diag->idiag_inode;
+            info.uid = diag->idiag_uid;
+            info.family = diag->idiag_family;
+            info.state = diag->idiag_state;
+            info.local_port = ntohs(diag->id.idiag_sport);
+            info.remote_port = ntohs(diag->id.idiag_dport);
+            std::memcpy(info.local_addr, diag->id.idiag_src, sizeof(info.local_addr));
+            std::memcpy(info.remote_addr, diag->id.idiag_dst, sizeof(info.remote_addr));
+
+            int attrLength = static_cast<int>(msg->nlmsg_len - NLMSG_LENGTH(sizeof(*diag)));
+            for (const rtattr* attr = reinterpret_cast<const rtattr*>(diag + 1);
+                 RTA_OK(attr, attrLength); attr = RTA_NEXT(attr, attrLength)) {
+                if (attr->rta_type != INET_DIAG_INFO) {
+                    continue;
+                }
+                // Older kernels send a shorter tcp_info; missing tail fields stay zero
+                tcp_info tcp;
+                std::memset(&tcp, 0, sizeof(tcp));
+                const size_t length = RTA_PAYLOAD(attr) < sizeof(tcp) ? RTA_PAYLOAD(attr) : sizeof(tcp);
+                std::memcpy(&tcp, RTA_DATA(attr), length);
+                info.rtt_us = tcp.tcpi_rtt;
+                info.rttvar_us = tcp.tcpi_rttvar;
+                info.min_rtt_us = tcp.tcpi_min_rtt;
+                info.snd_cwnd = tcp.tcpi_snd_cwnd;
+                info.retransmits = tcp.tcpi_retransmits;
+                info.total_retrans = tcp.tcpi_total_retrans;
+                info.pacing_rate = tcp.tcpi_pacing_rate;
+                info.delivery_rate = tcp.tcpi_delivery_rate;
+                info.bytes_acked = tcp.tcpi_bytes_acked;
+                info.bytes_received = tcp.tcpi_bytes_received;
+            }
+            visit(context, info);
+        }
+    }
+#else
+    (void)family;
+    (void)statesMask;
+    (void)visit;
+    (void)context;
+    return false;
+#endif
+}
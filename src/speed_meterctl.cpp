@@ -0,0 +1,192 @@
+// speed-meterctl: command-line client of speed-meterd.
+//
+//   speed-meterctl [--socket PATH] snapshot
+//   speed-meterctl [--socket PATH] watch [EVERY]
+//   speed-meterctl [--socket PATH] days [FIRST [LAST]]
+//   speed-meterctl [--socket PATH] months [FIRST [LAST]]
+//   speed-meterctl ring [NAME]      watch through the shared-memory ring
+//   speed-meterctl history [1s|1m|1h [COUNT]]
+//                                   read the daemon's history files
+
+#include "../include/helpers.h"
+#include "../include/meter_client.h"
+#include "../include/rrd_store.h"
+#include "../include/sample_ring.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void usage(const char* argv0) {
+    std::fprintf(stderr,
+                 "usage: %s [--socket PATH] snapshot | watch [EVERY] | days [FIRST [LAST]] | months [FIRST [LAST]]"
+                 " | ring [NAME] | history [1s|1m|1h [COUNT]]\n",
+                 argv0);
+}
+
+void printSnapshot(const MetricsSnapshot& s) {
+    std::printf("%-8s down %10.1f KB/s  up %10.1f KB/s  total %s / %s  packets %.0f/%.0f pps  period %d ms%s\n",
+                s.iface, s.rx_rate / 1024.0, s.tx_rate / 1024.0,
+                formatDataUsage(static_cast<long long>(s.total_rx_bytes)).c_str(),
+                formatDataUsage(static_cast<long long>(s.total_tx_bytes)).c_str(),
+                s.rx_packet_rate, s.tx_packet_rate, s.sample_period_ms,
+                s.sampling_idle ? " (idle)" : "");
+}
+
+void printHistory(const std::vector<meter_protocol::HistoryRow>& rows) {
+    std::printf("%-10s %12s %12s %12s %12s %12s\n",
+                "period", "download", "upload", "peak down", "p95 down", "p95 up");
+    for (const meter_protocol::HistoryRow& row : rows) {
+        std::printf("%-10s %12s %12s %9.1f KB/s %7.1f KB/s %7.1f KB/s\n", row.period,
+                    formatDataUsage(static_cast<long long>(row.download_bytes)).c_str(),
+                    formatDataUsage(static_cast<long long>(row.upload_bytes)).c_str(),
+                    row.peak_download / 1024.0, row.download_percentiles[1] / 1024.0,
+                    row.upload_percentiles[1] / 1024.0);
+    }
+}
+
+// The last count slots of one history tier, straight from the files in
+// SPEED_METER_HISTORY or the default data directory; no socket
+int showHistory(const std::string& tier_name, const std::string& count_text) {
+    size_t tier = 0;
+    while (tier < rrd::kTierCount && tier_name != rrd::kTiers[tier].name) {
+        ++tier;
+    }
+    if (tier == rrd::kTierCount) {
+        std::fprintf(stderr, "unknown history tier %s (1s, 1m or 1h)\n", tier_name.c_str());
+        return 2;
+    }
+    const long count = count_text.empty() ? 60 : std::strtol(count_text.c_str(), nullptr, 10);
+    if (count <= 0) {
+        std::fprintf(stderr, "bad count %s\n", count_text.c_str());
+        return 2;
+    }
+    std::string directory = rrd::directoryFromEnvironment();
+    if (directory.empty()) {
+        directory = rrd::defaultDirectory();
+    }
+    const int64_t to = static_cast<int64_t>(std::time(nullptr)) + 1;
+    const int64_t from = to - count * static_cast<int64_t>(rrd::kTiers[tier].resolution);
+    std::vector<rrd::Point> points;
+    if (!rrd::read(directory, static_cast<rrd::Tier>(tier), from, to, points)) {
+        std::fprintf(stderr, "no %s history in %s\n", rrd::kTiers[tier].name, directory.c_str());
+        return 1;
+    }
+    std::printf("%-19s %12s %12s %12s %12s %12s %12s\n",
+                "start", "download", "upload", "avg down", "max down", "avg up", "max up");
+    for (const rrd::Point& point : points) {
+        const std::time_t start = static_cast<std::time_t>(point.start);
+        std::tm local = std::tm();
+        localtime_r(&start, &local);
+        char when[32];
+        std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &local);
+        std::printf("%-19s %12s %12s %7.1f KB/s %7.1f KB/s %7.1f KB/s %7.1f KB/s\n", when,
+                    formatDataUsage(static_cast<long long>(point.rx_bytes)).c_str(),
+                    formatDataUsage(static_cast<long long>(point.tx_bytes)).c_str(),
+                    point.rxAverage() / 1024.0, point.rx_max / 1024.0,
+                    point.txAverage() / 1024.0, point.tx_max / 1024.0);
+    }
+    return 0;
+}
+
+// Follow the daemon's samples straight from shared memory, no socket
+int watchRing(const std::string& name) {
+    SampleRingReader reader;
+    if (!reader.open(name)) {
+        std::fprintf(stderr, "cannot map sample ring %s\n", name.c_str());
+        return 1;
+    }
+    MetricsSnapshot sample;
+    if (reader.latest(sample)) {
+        printSnapshot(sample);
+    }
+    uint64_t lost = 0;
+    for (;;) {
+        while (reader.next(sample, &lost)) {
+            if (lost != 0) {
+                std::printf("(%llu samples lost)\n", static_cast<unsigned long long>(lost));
+                lost = 0;
+            }
+            printSnapshot(sample);
+        }
+        std::fflush(stdout);
+        if (reader.writerGone()) {
+            std::fprintf(stderr, "speed-meterd closed the ring\n");
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string socket_path = meter_protocol::defaultSocketPath();
+    int arg = 1;
+    if (arg + 1 < argc && std::strcmp(argv[arg], "--socket") == 0) {
+        socket_path = argv[arg + 1];
+        arg += 2;
+    }
+    const std::string command = arg < argc ? argv[arg++] : "snapshot";
+    const std::string first = arg < argc ? argv[arg++] : "";
+    const std::string last = arg < argc ? argv[arg++] : "";
+
+    if (command == "ring") {
+        return watchRing(first.empty() ? sample_ring::defaultRingName() : first);
+    }
+    if (command == "history") {
+        return showHistory(first.empty() ? "1m" : first, last);
+    }
+
+    MeterClient client;
+    if (!client.connect(socket_path)) {
+        std::fprintf(stderr, "cannot reach speed-meterd: %s\n", client.error().c_str());
+        return 1;
+    }
+
+    if (command == "snapshot") {
+        MetricsSnapshot snapshot;
+        if (!client.snapshot(snapshot)) {
+            std::fprintf(stderr, "snapshot failed: %s\n", client.error().c_str());
+            return 1;
+        }
+        printSnapshot(snapshot);
+    } else if (command == "watch") {
+        const uint32_t every = first.empty() ? 1 : static_cast<uint32_t>(std::strtoul(first.c_str(), nullptr, 10));
+        if (!client.subscribe(every)) {
+            std::fprintf(stderr, "subscribe failed: %s\n", client.error().c_str());
+            return 1;
+        }
+        MetricsSnapshot sample;
+        uint64_t last_seq = 0;
+        while (client.nextSample(sample)) {
+            if (last_seq != 0 && sample.seq > last_seq + every) {
+                std::printf("(%llu samples lost)\n",
+                            static_cast<unsigned long long>(sample.seq - last_seq - every));
+            }
+            last_seq = sample.seq;
+            printSnapshot(sample);
+            std::fflush(stdout);
+        }
+        std::fprintf(stderr, "%s\n", client.error().c_str());
+        return 1;
+    } else if (command == "days" || command == "months") {
+        std::vector<meter_protocol::HistoryRow> rows;
+        const bool ok = command == "days" ? client.days(first, last, rows) : client.months(first, last, rows);
+        if (!ok) {
+            std::fprintf(stderr, "%s failed: %s\n", command.c_str(), client.error().c_str());
+            return 1;
+        }
+        printHistory(rows);
+    } else {
+        usage(argv[0]);
+        return 2;
+    }
+    return 0;
+}
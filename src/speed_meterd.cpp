@@ -0,0 +1,119 @@
+// speed-meterd: headless collector. Runs one SpeedMeter and DataManager
+// and serves them to any number of clients over a Unix socket (see
+// meter_protocol.h). No GTK or Qt is linked. Samples are also published
+// to a shared-memory ring (sample_ring.h) unless --no-ring is given,
+// recorded to round-robin history files in the data directory
+// (rrd_store.h) unless --no-history is given, and served to Prometheus on
+// --metrics.
+//
+//   speed-meterd [--socket PATH] [--data-dir DIR] [--no-ring] [--no-history] [--metrics [ADDRESS:]PORT]
+
+#include "../include/data_manager.h"
+#include "../include/logger.h"
+#include "../include/meter_protocol.h"
+#include "../include/meter_server.h"
+#include "../include/sample_ring.h"
+#include "../include/speed_monitor.h"
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace {
+
+MeterServer* server = nullptr;
+
+void on_signal(int) {
+    if (server) {
+        server->stop();
+    }
+}
+
+void usage(const char* argv0) {
+    std::cerr << "usage: " << argv0
+              << " [--socket PATH] [--data-dir DIR] [--no-ring] [--no-history] [--metrics [ADDRESS:]PORT]\n"
+              << "  --socket PATH    listen here (default " << meter_protocol::defaultSocketPath() << ")\n"
+              << "  --data-dir DIR   usage history directory (default ~/.config/linux-speed-meter)\n"
+              << "  --no-ring        do not publish samples to " << sample_ring::defaultRingName() << "\n"
+              << "  --no-history     do not record 1s/1m/1h history files in the data directory\n"
+              << "  --metrics [ADDRESS:]PORT\n"
+              << "                   serve Prometheus metrics at http://ADDRESS:PORT/metrics\n"
+              << "                   (ADDRESS defaults to 127.0.0.1)\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string socket_path = meter_protocol::defaultSocketPath();
+    std::string data_dir = "~/.config/linux-speed-meter";
+    bool ring = true;
+    bool history = true;
+    std::string metrics_address;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--data-dir") == 0 && i + 1 < argc) {
+            data_dir = argv[++i];
+        } else if (std::strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+            metrics_address = argv[++i];
+        } else if (std::strcmp(argv[i], "--no-ring") == 0) {
+            ring = false;
+        } else if (std::strcmp(argv[i], "--no-history") == 0) {
+            history = false;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    // The ring is on by default here; SPEED_METER_RING still picks its name
+    if (!ring) {
+        ::setenv("SPEED_METER_RING", "0", 1);
+    } else {
+        ::setenv("SPEED_METER_RING", "1", 0);
+    }
+    // So is the history, next to the usage data unless SPEED_METER_HISTORY
+    // points elsewhere
+    if (!history) {
+        ::setenv("SPEED_METER_HISTORY", "0", 1);
+    } else {
+        ::setenv("SPEED_METER_HISTORY", data_dir.c_str(), 0);
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+    logging::start();
+
+    std::unique_ptr<SpeedMeter> meter;
+    std::unique_ptr<DataManager> data;
+    try {
+        meter.reset(new SpeedMeter());
+        data.reset(new DataManager(data_dir));
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to initialize SpeedMeter or DataManager: " << e.what() << std::endl;
+        logging::stop();
+        return 1;
+    }
+
+    int status = 1;
+    {
+        MeterServer meter_server(*meter, *data);
+        if (meter_server.open(socket_path) &&
+            (metrics_address.empty() || meter_server.openMetrics(metrics_address))) {
+            server = &meter_server;
+            std::signal(SIGINT, on_signal);
+            std::signal(SIGTERM, on_signal);
+            if (meter_server.run()) {
+                status = 0;
+            }
+            std::signal(SIGINT, SIG_DFL);
+            std::signal(SIGTERM, SIG_DFL);
+            server = nullptr;
+        }
+    }
+
+    meter->on_quit();
+    meter.reset();
+    logging::stop();
+    return status;
+}
@@ -1,5 +1,6 @@
 
 #include "../include/speed_monitor.h"
+#include "../include/logger.h"
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -8,20 +9,38 @@
 #include <chrono>
 #include <atomic>
 #include <algorithm>
-#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <ctime>
 
+#ifdef __linux__
+#include "../include/rrd_store.h"
+#include "../include/sample_ring.h"
+#include "../include/tcp_health.h"
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
 
-constexpr int UPDATE_INTERVAL = 1; // seconds
+
+constexpr std::chrono::milliseconds UPDATE_INTERVAL(1000); // default; SPEED_METER_INTERVAL_MS overrides
+constexpr std::chrono::milliseconds IDLE_INTERVAL(5000); // longest period on a quiet link
+constexpr size_t TOP_INTERFACES = 5; // rows shown in all-interface mode
+constexpr size_t TOP_PROCESSES = 5;
+constexpr std::chrono::milliseconds PROCESS_INTERVAL(1000); // default shortest time between socket dumps
+constexpr int64_t PROCESS_COST_RATIO = 100; // keep dumps under ~1% of a core on hosts with huge socket tables
 constexpr SpeedUnit DISPLAY_UNIT = SpeedUnit::KB;
 
 // Improved interface detection: prefer non-loopback, up, and with traffic
 static std::string get_active_interface() {
+    std::string iface = RouteWatcher::queryDefaultInterface();
+    if (!iface.empty()) return iface;
     std::ifstream route("/proc/net/route");
     if (!route.is_open()) {
-        std::cerr << "Error: Cannot open /proc/net/route" << std::endl;
+        LOG_WARN("Cannot open /proc/net/route");
         return "eth0";
     }
-    std::string line, iface;
+    std::string line;
     while (std::getline(route, line)) {
         std::istringstream iss(line);
         std::string ifname, destination;
@@ -35,7 +54,7 @@ static std::string get_active_interface() {
     // Fallback: first non-loopback interface in /proc/net/dev
     std::ifstream netdev("/proc/net/dev");
     if (!netdev.is_open()) {
-        std::cerr << "Error: Cannot open /proc/net/dev" << std::endl;
+        LOG_WARN("Cannot open /proc/net/dev");
         return "eth0";
     }
     while (std::getline(netdev, line)) {
@@ -49,143 +68,435 @@ static std::string get_active_interface() {
     return "eth0"; // last fallback
 }
 
-static NetStats get_net_stats(const std::string& iface) {
-    std::ifstream netdev("/proc/net/dev");
-    if (!netdev.is_open()) {
-        std::cerr << "Error: Cannot open /proc/net/dev for interface " << iface << std::endl;
-        return {0, 0};
-    }
-    std::string line;
-    while (std::getline(netdev, line)) {
-        if (line.find(iface + ":") != std::string::npos) {
-            size_t colon = line.find(":");
-            std::istringstream iss(line.substr(colon + 1));
-            NetStats stats;
-            iss >> stats.rx_bytes;
-            for (int i = 0; i < 7; ++i) iss >> line; // skip fields
-            iss >> stats.tx_bytes;
-            return stats;
-        }
-    }
-    std::cerr << "Warning: Interface " << iface << " not found in /proc/net/dev" << std::endl;
-    return {0, 0};
-}
-
 SpeedMeter::SpeedMeter()
     : running(true),
-      total_rx(0),
-      total_tx(0),
-      current_download_speed(0.0),
-      current_upload_speed(0.0),
-      smoothed_download_speed_(0.0),
-      smoothed_upload_speed_(0.0),
-      first_sample_(true) {
+      scheduler_(sampleIntervalFromEnvironment(UPDATE_INTERVAL)),
+      sampling_(scheduler_.period(), maxSampleIntervalFromEnvironment(IDLE_INTERVAL)),
+      engine_(rateFilterFromEnvironment()),
+      sample_event_fd_(-1),
+      all_interfaces_(false),
+      interfaces_total_{"all", 0.0, 0.0},
+      last_process_ns_(0),
+      process_min_interval_ns_(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          processIntervalFromEnvironment(PROCESS_INTERVAL)).count()),
+      process_interval_ns_(process_min_interval_ns_),
+      nic_load_wanted_(false),
+      nic_load_active_(false),
+      nic_load_published_(),
+      tcp_health_wanted_(false),
+      last_tcp_health_ns_(0),
+      tcp_health_interval_ns_(process_min_interval_ns_),
+      tcp_health_fresh_(false),
+      retarget_pending_(false) {
     iface = get_active_interface();
     if (iface.empty()) {
         throw std::runtime_error("No active network interface found.");
     }
-    std::cout << "Monitoring interface: " << iface << std::endl;
-    last_stats = get_net_stats(iface);
-    last_update_time_ = std::chrono::steady_clock::now();
+    LOG_INFO("Monitoring interface", logging::field("iface", iface));
+    backend_ = openCounterBackend(counterSourceFromEnvironment(), iface);
+    LOG_INFO("Counter backend", logging::field("backend", backend_->name()));
+    NetStats baseline;
+    if (read_counters(baseline)) {
+        engine_.rebaseline(baseline, SampleScheduler::monotonicNs());
+    } else {
+        LOG_WARN("Interface counters not found", logging::field("iface", iface));
+    }
+
+    const char* mode = std::getenv("SPEED_METER_INTERFACES");
+    if (mode && std::strcmp(mode, "all") == 0) {
+        table_reader_.reset(new ProcNetDevReader());
+        all_interfaces_ = table_reader_->isOpen();
+        if (all_interfaces_ && table_reader_->refresh()) {
+            table_.update(*table_reader_, 0.0); // baseline for every interface
+            LOG_INFO("Tracking all interfaces", logging::field("count", table_.presentCount()));
+        }
+    }
+
+    const char* processes = std::getenv("SPEED_METER_PROCESSES");
+    if (processes && std::strcmp(processes, "1") == 0) {
+        process_traffic_.reset(new ProcessTraffic());
+        if (process_traffic_->isAvailable() && process_traffic_->refresh(0.0)) {
+            LOG_INFO("Tracking per-process traffic", logging::field("sockets", process_traffic_->socketCount()));
+        } else {
+            LOG_WARN("sock_diag unavailable; per-process traffic disabled");
+            process_traffic_.reset();
+        }
+    }
+
+    route_watcher_.reset(new RouteWatcher([this](const std::string& new_iface) {
+        request_retarget(new_iface);
+    }));
+    if (!route_watcher_->start(iface)) {
+        route_watcher_.reset();
+    }
+
+    LOG_INFO("Sampling", logging::field("period_ms", static_cast<long long>(sampling_.fast().count())),
+             logging::field("idle_period_ms", static_cast<long long>(sampling_.slow().count())));
+    last_process_ns_ = SampleScheduler::monotonicNs();
+    engine_.setSampling(static_cast<int32_t>(sampling_.fast().count()), false);
+    engine_.setInterface(iface);
+    snapshot_.store(engine_.metrics()); // seq 0: interface known, no rates yet
+#ifdef __linux__
+    const std::string ring_name = sample_ring::ringNameFromEnvironment();
+    if (!ring_name.empty()) {
+        ring_.reset(new SampleRingWriter());
+        if (!ring_->open(ring_name)) {
+            ring_.reset();
+        }
+    }
+    const std::string history_dir = rrd::directoryFromEnvironment();
+    if (!history_dir.empty()) {
+        history_.reset(new RrdStore());
+        if (!history_->open(history_dir)) {
+            history_.reset();
+        }
+    }
+#endif
     thread = std::thread(&SpeedMeter::update_loop, this);
 }
 
 SpeedMeter::~SpeedMeter() {
+    if (route_watcher_) route_watcher_->stop();
     running = false;
+    scheduler_.stop();
     if (thread.joinable()) thread.join();
+#ifdef __linux__
+    const int fd = sample_event_fd_.load();
+    if (fd >= 0) ::close(fd);
+#endif
 }
 
 void SpeedMeter::on_quit() {
     running = false;
+    scheduler_.stop();
 }
 
 void SpeedMeter::update_loop() {
-    while (running) {
-        std::this_thread::sleep_for(std::chrono::seconds(UPDATE_INTERVAL));
-        update_stats();
+    SampleTick tick;
+    while (running && scheduler_.wait(tick)) {
+        update_stats(tick);
     }
 }
 
-void SpeedMeter::update_stats() {
-    auto curr_stats = get_net_stats(iface);
-    auto now = std::chrono::steady_clock::now();
-    double elapsed_seconds = std::chrono::duration<double>(now - last_update_time_).count();
-    if (elapsed_seconds <= 0.0) {
-        elapsed_seconds = static_cast<double>(UPDATE_INTERVAL);
+void SpeedMeter::request_retarget(const std::string& new_iface) {
+    if (new_iface.empty()) {
+        return; // no default route right now; keep sampling the last one
     }
-    last_update_time_ = now;
+    std::lock_guard<std::mutex> lock(retarget_mutex_);
+    pending_iface_ = new_iface;
+    retarget_pending_.store(true);
+}
 
-    uint64_t rx = curr_stats.rx_bytes - last_stats.rx_bytes;
-    uint64_t tx = curr_stats.tx_bytes - last_stats.tx_bytes;
-    total_rx += rx;
-    total_tx += tx;
-    last_stats = curr_stats;
+// Switch to the pending interface and take a fresh baseline so the next
+// delta never mixes counters from two interfaces
+bool SpeedMeter::apply_retarget() {
+    std::string new_iface;
+    {
+        std::lock_guard<std::mutex> lock(retarget_mutex_);
+        new_iface.swap(pending_iface_);
+        retarget_pending_.store(false);
+    }
+    if (new_iface.empty() || new_iface == iface) {
+        return false;
+    }
+    LOG_INFO("Default route moved", logging::field("from", iface), logging::field("to", new_iface));
+    iface = new_iface;
+    engine_.setInterface(iface);
+    if (!backend_->setInterface(iface)) {
+        backend_ = openCounterBackend(counterSourceFromEnvironment(), iface);
+    }
+    if (nic_load_) {
+        nic_load_->setInterface(iface);
+    }
+    NetStats baseline;
+    if (read_counters(baseline)) {
+        engine_.rebaseline(baseline, SampleScheduler::monotonicNs());
+    } else {
+        engine_.forgetBaseline();
+    }
+    adapt_period(1); // back to the fast period on the new interface
+    publish();
+    return true;
+}
 
-    // Calculate instantaneous speeds (bytes per second)
-    double instant_download = static_cast<double>(rx) / elapsed_seconds;
-    double instant_upload = static_cast<double>(tx) / elapsed_seconds;
+void SpeedMeter::update_stats(const SampleTick& tick) {
+    if (retarget_pending_.load() && apply_retarget()) {
+        return;
+    }
+    NetStats curr_stats;
+    if (!read_counters(curr_stats)) {
+        LOG_WARN("Interface counters not found", logging::field("iface", iface));
+        return;
+    }
+    if (tick.resumed) {
+        // Counters moved while the machine slept; start from a new baseline
+        engine_.rebaseline(curr_stats, tick.monotonic_ns);
+        if (all_interfaces_ && table_reader_->refresh()) {
+            table_.update(*table_reader_, 0.0);
+        }
+        if (nic_load_active_) {
+            nic_load_->sample(0.0);
+        }
+        adapt_period(1);
+        publish();
+        return;
+    }
+    const double nominal_seconds = std::chrono::duration<double>(scheduler_.period()).count();
+    if (!engine_.update(curr_stats, tick.monotonic_ns, nominal_seconds)) {
+        publish(); // first readable counters; rates start with the next tick
+        return;
+    }
+    const MetricsSnapshot& metrics = engine_.metrics();
+    const double elapsed_seconds = engine_.elapsedSeconds();
 
-    constexpr double alpha = 0.6; // smoothing factor for EMA
-    if (first_sample_) {
-        smoothed_download_speed_ = instant_download;
-        smoothed_upload_speed_ = instant_upload;
-        first_sample_ = false;
-    } else {
-        smoothed_download_speed_ = alpha * instant_download + (1.0 - alpha) * smoothed_download_speed_;
-        smoothed_upload_speed_ = alpha * instant_upload + (1.0 - alpha) * smoothed_upload_speed_;
+    record_rates(metrics.instant_rx_rate, metrics.instant_tx_rate, elapsed_seconds);
+    if (all_interfaces_) {
+        sample_interface_table(elapsed_seconds);
+    }
+    sample_nic_load(elapsed_seconds);
+    uint64_t moved = engine_.deltaBytes();
+    if (all_interfaces_ && (interfaces_total_.rx_rate > 0.0 || interfaces_total_.tx_rate > 0.0)) {
+        moved += 1; // another interface is busy; keep the fast period
+    }
+    adapt_period(moved);
+    if (process_traffic_) {
+        sample_processes(tick.monotonic_ns);
     }
+    sample_tcp_health(tick.monotonic_ns);
+#ifdef __linux__
+    if (history_) {
+        history_->record(metrics, elapsed_seconds, static_cast<int64_t>(std::time(nullptr)));
+    }
+#endif
+    publish();
 
-    current_download_speed.store(smoothed_download_speed_);
-    current_upload_speed.store(smoothed_upload_speed_);
+    LOG_DEBUG("Sample", logging::field("iface", metrics.iface),
+              logging::field("rx_rate", metrics.instant_rx_rate),
+              logging::field("tx_rate", metrics.instant_tx_rate),
+              logging::field("rx_smoothed", metrics.rx_rate),
+              logging::field("rx_packets", metrics.rx_packet_rate));
+}
 
-    std::ostringstream tooltip_oss;
-    tooltip_oss.precision(2);
-    tooltip_oss << std::fixed;
-    tooltip_oss << "Interface: " << iface << "\nTotal Download: "
-                << (total_rx / 1024.0 / 1024.0) << " MB\nTotal Upload: "
-                << (total_tx / 1024.0 / 1024.0) << " MB";
-    const std::string tooltip = tooltip_oss.str();
+void SpeedMeter::adapt_period(uint64_t delta_bytes) {
+    const std::chrono::milliseconds period = sampling_.next(delta_bytes);
+    if (period != scheduler_.period()) {
+        scheduler_.setPeriod(period);
+    }
+    engine_.setSampling(static_cast<int32_t>(period.count()), sampling_.idle());
+}
 
-    const std::string label = "↓ " + format_speed(smoothed_download_speed_) +
-                              " | ↑ " + format_speed(smoothed_upload_speed_);
+void SpeedMeter::publish() {
+    engine_.publish(snapshot_);
+#ifdef __linux__
+    if (ring_) {
+        ring_->publish(engine_.metrics());
+    }
+    const int fd = sample_event_fd_.load(std::memory_order_acquire);
+    if (fd >= 0) {
+        const uint64_t one = 1;
+        ssize_t ignored = ::write(fd, &one, sizeof(one));
+        (void)ignored;
+    }
+#endif
+}
 
-    {
-        std::lock_guard<std::mutex> lock(label_mutex_);
-        label_ = label;
-        tooltip_ = tooltip;
-    }
-
-    // Debug output
-    std::cout << "[DEBUG] Interface: " << iface
-              << " | RX: " << rx << " bytes | TX: " << tx << " bytes"
-              << " | Instant Down: " << instant_download << " B/s"
-              << " | Instant Up: " << instant_upload << " B/s"
-              << " | Smoothed Down: " << smoothed_download_speed_
-              << " B/s | Smoothed Up: " << smoothed_upload_speed_
-              << " B/s | Label: " << label << std::endl;
-}
-
-std::string SpeedMeter::format_speed(double bytes) const {
-    std::ostringstream oss;
-    double bits = bytes * 8.0;
-    double kbits = bits / 1024.0;
-    oss << std::fixed;
-    if (kbits < 1024.0) {
-        oss.precision(1);
-        oss << kbits << " Kb/s";
+void SpeedMeter::sample_interface_table(double elapsed_seconds) {
+    if (!table_reader_->refresh()) {
+        return;
+    }
+    table_.update(*table_reader_, elapsed_seconds);
+    table_.topN(TOP_INTERFACES, top_slots_);
+    const InterfaceRate total = table_.total();
+
+    std::lock_guard<std::mutex> lock(interfaces_mutex_);
+    interfaces_total_.rx_rate = total.rx_rate;
+    interfaces_total_.tx_rate = total.tx_rate;
+    top_interfaces_.resize(top_slots_.size());
+    for (size_t i = 0; i < top_slots_.size(); ++i) {
+        const uint32_t slot = top_slots_[i];
+        top_interfaces_[i].name = table_.name(slot);
+        top_interfaces_[i].rx_rate = table_.rate(InterfaceTable::RxBytes, slot);
+        top_interfaces_[i].tx_rate = table_.rate(InterfaceTable::TxBytes, slot);
+    }
+}
+
+void SpeedMeter::sample_processes(int64_t now_ns) {
+    if (now_ns - last_process_ns_ < process_interval_ns_) {
+        return;
+    }
+    const double elapsed_seconds = static_cast<double>(now_ns - last_process_ns_) / 1e9;
+    last_process_ns_ = now_ns;
+    const bool ok = process_traffic_->refresh(elapsed_seconds);
+    // The kernel walks every socket on each dump, so space the dumps out
+    // in proportion to what the last one cost
+    const int64_t cost_ns = SampleScheduler::monotonicNs() - now_ns;
+    process_interval_ns_ = std::max(process_min_interval_ns_, cost_ns * PROCESS_COST_RATIO);
+    if (!ok) {
+        return;
+    }
+    process_traffic_->top(TOP_PROCESSES, process_scratch_);
+
+    std::lock_guard<std::mutex> lock(processes_mutex_);
+    top_processes_.swap(process_scratch_);
+}
+
+void SpeedMeter::sample_tcp_health(int64_t now_ns) {
+#ifdef __linux__
+    if (!tcp_health_wanted_.load() || now_ns - last_tcp_health_ns_ < tcp_health_interval_ns_) {
+        return;
+    }
+    if (!tcp_health_) {
+        tcp_health_.reset(new TcpHealthTable());
+    }
+    last_tcp_health_ns_ = now_ns;
+    const bool ok = tcp_health_->refresh();
+    const int64_t cost_ns = SampleScheduler::monotonicNs() - now_ns;
+    tcp_health_interval_ns_ = std::max(process_min_interval_ns_, cost_ns * PROCESS_COST_RATIO);
+    if (!ok) {
+        return;
+    }
+    // The reader's previous buffer comes back here and is decoded into
+    // next time, so steady state allocates nothing
+    std::lock_guard<std::mutex> lock(tcp_health_mutex_);
+    tcp_health_->swapRows(tcp_health_rows_);
+    tcp_health_fresh_ = true;
+#else
+    (void)now_ns;
+#endif
+}
+
+void SpeedMeter::sample_nic_load(double elapsed_seconds) {
+    if (!nic_load_wanted_.load()) {
+        nic_load_active_ = false;
+        return;
+    }
+    if (!nic_load_) {
+        nic_load_.reset(new NicLoadSampler());
+    }
+    if (!nic_load_active_) {
+        // First tick after the panel opened: find the NIC's IRQs and queues
+        // and take a baseline
+        nic_load_->setInterface(iface);
+        nic_load_active_ = true;
+    }
+    if (!nic_load_->sample(elapsed_seconds)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(nic_load_mutex_);
+    nic_load_published_ = nic_load_->load();
+}
+
+void SpeedMeter::record_rates(double download, double upload, double elapsed_seconds) {
+    const double fast = std::chrono::duration<double>(sampling_.fast()).count();
+    const uint32_t weight = static_cast<uint32_t>(std::max(1.0, std::round(elapsed_seconds / fast)));
+    std::lock_guard<std::mutex> lock(rates_mutex_);
+    session_rates_.download.record(download, weight);
+    session_rates_.upload.record(upload, weight);
+    pending_rates_.download.record(download, weight);
+    pending_rates_.upload.record(upload, weight);
+}
+
+RateDigest SpeedMeter::get_session_rates() const {
+    std::lock_guard<std::mutex> lock(rates_mutex_);
+    return session_rates_;
+}
+
+RateDigest SpeedMeter::take_rate_samples() {
+    std::lock_guard<std::mutex> lock(rates_mutex_);
+    RateDigest samples = pending_rates_;
+    pending_rates_.clear();
+    return samples;
+}
+
+int SpeedMeter::sample_event_fd() {
+#ifdef __linux__
+    int fd = sample_event_fd_.load(std::memory_order_acquire);
+    if (fd >= 0) {
+        return fd;
+    }
+    const int created = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (created < 0) {
+        return -1;
+    }
+    if (!sample_event_fd_.compare_exchange_strong(fd, created, std::memory_order_acq_rel)) {
+        ::close(created); // another caller won the race
+        return fd;
+    }
+    return created;
+#else
+    return -1;
+#endif
+}
+
+NicLoad SpeedMeter::get_nic_load() const {
+    std::lock_guard<std::mutex> lock(nic_load_mutex_);
+    return nic_load_published_;
+}
+
+bool SpeedMeter::take_tcp_health(std::vector<TcpSocketInfo>& rows) {
+    std::lock_guard<std::mutex> lock(tcp_health_mutex_);
+    if (!tcp_health_fresh_) {
+        return false;
+    }
+    rows.swap(tcp_health_rows_);
+    tcp_health_fresh_ = false;
+    return true;
+}
+
+std::vector<ProcessRate> SpeedMeter::get_top_processes() const {
+    std::lock_guard<std::mutex> lock(processes_mutex_);
+    return top_processes_;
+}
+
+InterfaceRate SpeedMeter::get_all_interfaces_total() const {
+    std::lock_guard<std::mutex> lock(interfaces_mutex_);
+    return interfaces_total_;
+}
+
+std::vector<InterfaceRate> SpeedMeter::get_top_interfaces() const {
+    std::lock_guard<std::mutex> lock(interfaces_mutex_);
+    return top_interfaces_;
+}
+
+bool SpeedMeter::read_counters(NetStats& stats) {
+    if (backend_->read(stats)) {
+        return true;
+    }
+    // The interface may have been re-created under a new ifindex
+    if (backend_->setInterface(iface) && backend_->read(stats)) {
+        return true;
+    }
+    // rtnetlink stopped answering; continue through /proc/net/dev
+    if (std::strcmp(backend_->name(), "procfs") != 0) {
+        LOG_WARN("Counters unavailable, falling back to /proc/net/dev",
+                 logging::field("backend", backend_->name()));
+        backend_ = openCounterBackend(CounterSource::ProcNetDev, iface);
+        return backend_->read(stats);
+    }
+    return false;
+}
+
+bool SpeedMeter::render(LabelRenderer& renderer, const MetricsSnapshot& snapshot) const {
+    const bool label_changed = renderer.updateLabel(snapshot);
+    bool tooltip_changed;
+    if (all_interfaces_) {
+        std::lock_guard<std::mutex> lock(interfaces_mutex_);
+        tooltip_changed = renderer.updateTooltip(snapshot, &interfaces_total_, top_interfaces_);
     } else {
-        oss.precision(2);
-        oss << (kbits / 1024.0) << " Mb/s";
+        static const std::vector<InterfaceRate> none;
+        tooltip_changed = renderer.updateTooltip(snapshot, nullptr, none);
     }
-    return oss.str();
+    return label_changed || tooltip_changed;
 }
 
 std::string SpeedMeter::get_label() const {
-    std::lock_guard<std::mutex> lock(label_mutex_);
-    return label_;
+    LabelRenderer renderer;
+    renderer.updateLabel(get_snapshot());
+    return renderer.label();
 }
 
 std::string SpeedMeter::get_tooltip() const {
-    std::lock_guard<std::mutex> lock(label_mutex_);
-    return tooltip_;
+    LabelRenderer renderer;
+    render(renderer, get_snapshot());
+    return renderer.tooltip();
 }
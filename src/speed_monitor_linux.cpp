@@ -3,27 +3,17 @@
 #include <QNetworkInterface>
 #include <QHostAddress>
 #include <QDebug>
-#include <QFile>
-#include <QTextStream>
-#include <QMutexLocker>
-#include <cmath>
+#include <cstring>
+#include <stdexcept>
 
 SpeedMonitorLinux::SpeedMonitorLinux(QObject* parent)
     : SpeedMonitor(parent)
-    , monitorThread_(nullptr)
-    , totalDownloaded_(0)
-    , totalUploaded_(0)
-    , downloadRate_(0.0)
-    , uploadRate_(0.0)
-    , prevDownloaded_(0)
-    , prevUploaded_(0)
-    , timer_()
-    , firstSample_(true)
-    , smoothedDownload_(0.0)
-    , smoothedUpload_(0.0)
+    , standalone_(false)
+    , lastSeq_(0)
     , connected_(false)
-    , running_(false)
 {
+    std::memset(&clientSnapshot_, 0, sizeof(clientSnapshot_));
+    connect(&pollTimer_, &QTimer::timeout, this, &SpeedMonitorLinux::poll);
 }
 
 SpeedMonitorLinux::~SpeedMonitorLinux() {
@@ -31,7 +21,8 @@ SpeedMonitorLinux::~SpeedMonitorLinux() {
 }
 
 bool SpeedMonitorLinux::initialize() {
-    // Get network interface information
+    // SpeedMeter picks the default-route interface itself; only make sure
+    // there is something worth monitoring
     QList<QNetworkInterface> interfaces = QNetworkInterface::allInterfaces();
 
     for (const QNetworkInterface& iface : interfaces) {
@@ -45,7 +36,6 @@ bool SpeedMonitorLinux::initialize() {
                     interfaceName_ = iface.name();
                     ipAddress_ = addr.ip().toString();
                     connected_ = true;
-                    qDebug() << "Using interface:" << interfaceName_ << "IP:" << ipAddress_;
                     return true;
                 }
             }
@@ -57,181 +47,142 @@ bool SpeedMonitorLinux::initialize() {
 }
 
 void SpeedMonitorLinux::start() {
-    if (running_.load(std::memory_order_acquire)) {
+    if (meter_ || client_) {
         return;
     }
-
-    {
-        QMutexLocker locker(&dataMutex_);
-        totalDownloaded_.store(0, std::memory_order_relaxed);
-        totalUploaded_.store(0, std::memory_order_relaxed);
-        downloadRate_.store(0.0, std::memory_order_relaxed);
-        uploadRate_.store(0.0, std::memory_order_relaxed);
-        smoothedDownload_ = 0.0;
-        smoothedUpload_ = 0.0;
-        prevDownloaded_ = 0;
-        prevUploaded_ = 0;
+    if (!standalone_ && connectToDaemon()) {
+        pollTimer_.start(250);
+        return;
     }
-    firstSample_ = true;
-    timer_.invalidate();
-
-    running_.store(true, std::memory_order_release);
-
-    monitorThread_ = QThread::create([this]() {
-        monitorNetwork();
-    });
+    startLocal();
+}
 
-    monitorThread_->start();
+bool SpeedMonitorLinux::connectToDaemon() {
+    std::unique_ptr<MeterClient> client(new MeterClient());
+    if (!client->connect() || !client->subscribe()) {
+        return false;
+    }
+    client_ = std::move(client);
+    std::memset(&clientSnapshot_, 0, sizeof(clientSnapshot_));
+    lastSeq_ = 0;
+    qDebug() << "Showing speed-meterd samples from" << QString::fromStdString(meter_protocol::defaultSocketPath());
+    return true;
 }
 
-void SpeedMonitorLinux::stop() {
-    if (!running_.load(std::memory_order_acquire)) {
+void SpeedMonitorLinux::startLocal() {
+    try {
+        meter_.reset(new SpeedMeter());
+    } catch (const std::exception& e) {
+        qWarning() << "Cannot start sampling:" << e.what();
         return;
     }
+    lastSeq_ = 0;
+    interfaceName_ = QString::fromStdString(meter_->get_iface());
+    ipAddress_ = addressOf(interfaceName_);
+    connected_ = true;
+    qDebug() << "Using interface:" << interfaceName_ << "IP:" << ipAddress_;
 
-    running_.store(false, std::memory_order_release);
-
-    if (monitorThread_) {
-        monitorThread_->wait();
-        delete monitorThread_;
-        monitorThread_ = nullptr;
-    }
+    pollTimer_.start(250);
 }
 
-void SpeedMonitorLinux::monitorNetwork() {
-    constexpr double kSmoothingAlpha = 0.6;
-    constexpr int kPollIntervalMs = 500;
-
-    while (running_.load(std::memory_order_relaxed)) {
-        quint64 currentDownloaded = 0;
-        quint64 currentUploaded = 0;
-
-        if (readNetworkStats(currentDownloaded, currentUploaded)) {
-            if (firstSample_) {
-                {
-                    QMutexLocker locker(&dataMutex_);
-                    totalDownloaded_.store(currentDownloaded, std::memory_order_relaxed);
-                    totalUploaded_.store(currentUploaded, std::memory_order_relaxed);
-                    prevDownloaded_ = currentDownloaded;
-                    prevUploaded_ = currentUploaded;
-                    downloadRate_.store(0.0, std::memory_order_relaxed);
-                    uploadRate_.store(0.0, std::memory_order_relaxed);
-                    smoothedDownload_ = 0.0;
-                    smoothedUpload_ = 0.0;
-                }
-                timer_.start();
-                firstSample_ = false;
-            } else {
-                qint64 elapsedNs = timer_.nsecsElapsed();
-                if (elapsedNs <= 0) {
-                    elapsedNs = static_cast<qint64>(kPollIntervalMs) * 1000000;
-                }
-                timer_.restart();
-
-                double elapsedSeconds = static_cast<double>(elapsedNs) / 1'000'000'000.0;
-                if (elapsedSeconds <= 1e-6) {
-                    elapsedSeconds = static_cast<double>(kPollIntervalMs) / 1000.0;
-                }
-
-                quint64 deltaDown = (currentDownloaded >= prevDownloaded_)
-                                         ? (currentDownloaded - prevDownloaded_)
-                                         : 0;
-                quint64 deltaUp = (currentUploaded >= prevUploaded_)
-                                       ? (currentUploaded - prevUploaded_)
-                                       : 0;
-
-                double instantDown = static_cast<double>(deltaDown) / elapsedSeconds;
-                double instantUp = static_cast<double>(deltaUp) / elapsedSeconds;
-
-                double newDownload = kSmoothingAlpha * instantDown +
-                                     (1.0 - kSmoothingAlpha) * smoothedDownload_;
-                double newUpload = kSmoothingAlpha * instantUp +
-                                   (1.0 - kSmoothingAlpha) * smoothedUpload_;
-
-                if (!std::isfinite(newDownload) || newDownload < 0.0) {
-                    newDownload = 0.0;
-                }
-                if (!std::isfinite(newUpload) || newUpload < 0.0) {
-                    newUpload = 0.0;
-                }
-
-                {
-                    QMutexLocker locker(&dataMutex_);
-                    totalDownloaded_.store(currentDownloaded, std::memory_order_relaxed);
-                    totalUploaded_.store(currentUploaded, std::memory_order_relaxed);
-                    smoothedDownload_ = newDownload;
-                    smoothedUpload_ = newUpload;
-                    downloadRate_.store(smoothedDownload_, std::memory_order_relaxed);
-                    uploadRate_.store(smoothedUpload_, std::memory_order_relaxed);
-                    prevDownloaded_ = currentDownloaded;
-                    prevUploaded_ = currentUploaded;
-                }
-            }
+void SpeedMonitorLinux::stop() {
+    pollTimer_.stop();
+    client_.reset();
+    // Joins the sampler thread
+    meter_.reset();
+}
+
+// Runs on the GUI thread: announce new samples and follow the sampler
+// onto a new default-route interface
+void SpeedMonitorLinux::poll() {
+    if (client_) {
+        MetricsSnapshot sample;
+        while (client_->nextSample(sample, 0)) {
+            clientSnapshot_ = sample;
+        }
+        if (!client_->isConnected()) {
+            qWarning() << "Lost speed-meterd, sampling locally:" << QString::fromStdString(client_->error());
+            client_.reset();
+            pollTimer_.stop();
+            startLocal();
+            return;
         }
+    }
 
-        QThread::msleep(kPollIntervalMs);
+    const MetricsSnapshot current = snapshot();
+    if (current.seq == lastSeq_) {
+        return;
+    }
+    lastSeq_ = current.seq;
+
+    const QString name = QString::fromLatin1(current.iface);
+    if (name != interfaceName_) {
+        qDebug() << "Default route moved:" << interfaceName_ << "->" << name;
+        interfaceName_ = name;
+        ipAddress_ = addressOf(name);
+        connected_ = !name.isEmpty();
+        emit connectionChanged(connected_);
     }
+    emit dataUpdated();
 }
 
-bool SpeedMonitorLinux::readNetworkStats(quint64& rx, quint64& tx) {
-    if (interfaceName_.isEmpty()) {
-        return false;
+MetricsSnapshot SpeedMonitorLinux::snapshot() const {
+    if (client_) {
+        return clientSnapshot_;
     }
-
-    QString path = QString("/sys/class/net/%1/statistics/").arg(interfaceName_);
-    QFile rxFile(path + "rx_bytes");
-    QFile txFile(path + "tx_bytes");
-
-    if (!rxFile.open(QIODevice::ReadOnly) || !txFile.open(QIODevice::ReadOnly)) {
-        qWarning() << "Failed to open network statistics files for" << interfaceName_;
-        return false;
+    if (meter_) {
+        return meter_->get_snapshot();
     }
+    MetricsSnapshot none;
+    std::memset(&none, 0, sizeof(none));
+    return none;
+}
 
-    QTextStream rxStream(&rxFile);
-    QTextStream txStream(&txFile);
-
-    rx = rxStream.readAll().trimmed().toULongLong();
-    tx = txStream.readAll().trimmed().toULongLong();
-
-    rxFile.close();
-    txFile.close();
-
-    return true;
+QString SpeedMonitorLinux::addressOf(const QString& name) {
+    const QNetworkInterface iface = QNetworkInterface::interfaceFromName(name);
+    for (const QNetworkAddressEntry& addr : iface.addressEntries()) {
+        if (addr.ip().protocol() == QAbstractSocket::IPv4Protocol) {
+            return addr.ip().toString();
+        }
+    }
+    return QString();
 }
 
 QString SpeedMonitorLinux::getLabel() const {
-    QString download = formatSpeed(downloadRate_.load(std::memory_order_relaxed));
-    QString upload = formatSpeed(uploadRate_.load(std::memory_order_relaxed));
+    const MetricsSnapshot current = snapshot();
+    QString download = formatSpeed(current.rx_rate);
+    QString upload = formatSpeed(current.tx_rate);
     return QString("↓ %1 ↑ %2").arg(download, upload);
 }
 
 QString SpeedMonitorLinux::getTooltip() const {
-    QString download = formatSpeed(downloadRate_.load(std::memory_order_relaxed));
-    QString upload = formatSpeed(uploadRate_.load(std::memory_order_relaxed));
-    QString totalDown = formatBytes(static_cast<double>(totalDownloaded_.load(std::memory_order_relaxed)));
-    QString totalUp = formatBytes(static_cast<double>(totalUploaded_.load(std::memory_order_relaxed)));
+    const MetricsSnapshot current = snapshot();
+    QString download = formatSpeed(current.rx_rate);
+    QString upload = formatSpeed(current.tx_rate);
+    QString totalDown = formatBytes(static_cast<double>(current.total_rx_bytes));
+    QString totalUp = formatBytes(static_cast<double>(current.total_tx_bytes));
 
     return QString("Linux Speed Meter\n"
                    "Download: %1/s (%2 total)\n"
                    "Upload: %3/s (%4 total)\n"
                    "Interface: %5")
-                   .arg(download, totalDown, upload, totalUp, interfaceName_);
+                   .arg(download, totalDown, upload, totalUp, getInterfaceName());
 }
 
 QString SpeedMonitorLinux::getDownloadRate() const {
-    return formatSpeed(downloadRate_.load(std::memory_order_relaxed)) + "/s";
+    return formatSpeed(snapshot().rx_rate) + "/s";
 }
 
 QString SpeedMonitorLinux::getUploadRate() const {
-    return formatSpeed(uploadRate_.load(std::memory_order_relaxed)) + "/s";
+    return formatSpeed(snapshot().tx_rate) + "/s";
 }
 
 QString SpeedMonitorLinux::getTotalDownloaded() const {
-    return formatBytes(static_cast<double>(totalDownloaded_.load(std::memory_order_relaxed)));
+    return formatBytes(static_cast<double>(snapshot().total_rx_bytes));
 }
 
 QString SpeedMonitorLinux::getTotalUploaded() const {
-    return formatBytes(static_cast<double>(totalUploaded_.load(std::memory_order_relaxed)));
+    return formatBytes(static_cast<double>(snapshot().total_tx_bytes));
 }
 
 QString SpeedMonitorLinux::getInterfaceName() const {
@@ -247,8 +198,32 @@ bool SpeedMonitorLinux::isConnected() const {
 }
 
 bool SpeedMonitorLinux::isActive() const {
-    return (downloadRate_.load(std::memory_order_relaxed) > 0.0 ||
-            uploadRate_.load(std::memory_order_relaxed) > 0.0);
+    const MetricsSnapshot current = snapshot();
+    return current.rx_rate > 0.0 || current.tx_rate > 0.0;
+}
+
+int SpeedMonitorLinux::getSamplePeriodMs() const {
+    return snapshot().sample_period_ms;
+}
+
+bool SpeedMonitorLinux::isSamplingIdle() const {
+    return snapshot().sampling_idle;
+}
+
+PacketRates SpeedMonitorLinux::getPacketRates() const {
+    return packetRatesFromSnapshot(snapshot());
+}
+
+bool SpeedMonitorLinux::isAllInterfaces() const {
+    return meter_ && meter_->is_all_interfaces();
+}
+
+InterfaceRate SpeedMonitorLinux::getAllInterfacesTotal() const {
+    return meter_ ? meter_->get_all_interfaces_total() : InterfaceRate{"all", 0.0, 0.0};
+}
+
+std::vector<InterfaceRate> SpeedMonitorLinux::getTopInterfaces() const {
+    return meter_ ? meter_->get_top_interfaces() : std::vector<InterfaceRate>();
 }
 
 QString SpeedMonitorLinux::formatBytes(double bytes) const {
@@ -273,4 +248,4 @@ QString SpeedMonitorLinux::formatSpeed(double bytesPerSecond) const {
         bytesPerSecond = 0.0;
     }
     return formatBytes(bytesPerSecond);
-}
\ No newline at end of file
+}
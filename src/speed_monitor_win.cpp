@@ -1,4 +1,6 @@
 #include "speed_monitor_win.h"
+#include "net_stats.h"
+#include "sample_scheduler.h"
 #include <QDebug>
 #include <QNetworkInterface>
 #include <QHostAddress>
@@ -7,15 +9,10 @@
 SpeedMonitorWin::SpeedMonitorWin(QObject* parent)
     : SpeedMonitor(parent)
     , monitorThread_(nullptr)
-    , totalDownloaded_(0)
-    , totalUploaded_(0)
-    , downloadRate_(0)
-    , uploadRate_(0)
-    , prevDownloaded_(0)
-    , prevUploaded_(0)
     , connected_(false)
     , running_(false)
 {
+    engine_.setSampling(1000, false); // fixed one-second loop
 }
 
 SpeedMonitorWin::~SpeedMonitorWin() {
@@ -88,8 +85,7 @@ void SpeedMonitorWin::monitorNetwork() {
             continue;
         }
 
-        quint64 currentDownloaded = 0;
-        quint64 currentUploaded = 0;
+        NetStats stats = NetStats();
 
         // Sum up all active interfaces
         for (ULONG i = 0; i < ifTable->NumEntries; i++) {
@@ -98,22 +94,20 @@ void SpeedMonitorWin::monitorNetwork() {
             // Skip loopback and inactive interfaces
             if (row->InterfaceAndOperStatusFlags.HardwareInterface ||
                 row->OperStatus == IfOperStatusUp) {
-                currentDownloaded += row->InOctets;
-                currentUploaded += row->OutOctets;
+                stats.rx_bytes += row->InOctets;
+                stats.tx_bytes += row->OutOctets;
+                stats.rx_packets += row->InUcastPkts + row->InNUcastPkts;
+                stats.tx_packets += row->OutUcastPkts + row->OutNUcastPkts;
+                stats.rx_dropped += row->InDiscards;
+                stats.tx_dropped += row->OutDiscards;
+                stats.rx_errors += row->InErrors;
+                stats.tx_errors += row->OutErrors;
             }
         }
 
-        // Update totals
-        QMutexLocker locker(&dataMutex_);
-        totalDownloaded_ = currentDownloaded;
-        totalUploaded_ = currentUploaded;
-
-        // Calculate rates
-        downloadRate_ = currentDownloaded - prevDownloaded_;
-        uploadRate_ = currentUploaded - prevUploaded_;
-
-        prevDownloaded_ = currentDownloaded;
-        prevUploaded_ = currentUploaded;
+        // The first pass only sets the baseline
+        engine_.update(stats, SampleScheduler::monotonicNs(), 1.0);
+        engine_.publish(snapshot_);
 
         // Free the table
         FreeMibTable(ifTable);
@@ -129,16 +123,18 @@ void SpeedMonitorWin::monitorNetwork() {
 }
 
 QString SpeedMonitorWin::getLabel() const {
-    QString download = formatSpeed(downloadRate_);
-    QString upload = formatSpeed(uploadRate_);
+    const MetricsSnapshot current = snapshot_.load();
+    QString download = formatSpeed(static_cast<quint64>(current.rx_rate));
+    QString upload = formatSpeed(static_cast<quint64>(current.tx_rate));
     return QString("↓ %1 ↑ %2").arg(download, upload);
 }
 
 QString SpeedMonitorWin::getTooltip() const {
-    QString download = formatSpeed(downloadRate_);
-    QString upload = formatSpeed(uploadRate_);
-    QString totalDown = formatBytes(totalDownloaded_);
-    QString totalUp = formatBytes(totalUploaded_);
+    const MetricsSnapshot current = snapshot_.load();
+    QString download = formatSpeed(static_cast<quint64>(current.rx_rate));
+    QString upload = formatSpeed(static_cast<quint64>(current.tx_rate));
+    QString totalDown = formatBytes(current.total_rx_bytes);
+    QString totalUp = formatBytes(current.total_tx_bytes);
 
     return QString("Linux Speed Meter\n"
                    "Download: %1/s (%2 total)\n"
@@ -148,19 +144,19 @@ QString SpeedMonitorWin::getTooltip() const {
 }
 
 QString SpeedMonitorWin::getDownloadRate() const {
-    return formatSpeed(downloadRate_) + "/s";
+    return formatSpeed(static_cast<quint64>(snapshot_.load().rx_rate)) + "/s";
 }
 
 QString SpeedMonitorWin::getUploadRate() const {
-    return formatSpeed(uploadRate_) + "/s";
+    return formatSpeed(static_cast<quint64>(snapshot_.load().tx_rate)) + "/s";
 }
 
 QString SpeedMonitorWin::getTotalDownloaded() const {
-    return formatBytes(totalDownloaded_);
+    return formatBytes(snapshot_.load().total_rx_bytes);
 }
 
 QString SpeedMonitorWin::getTotalUploaded() const {
-    return formatBytes(totalUploaded_);
+    return formatBytes(snapshot_.load().total_tx_bytes);
 }
 
 QString SpeedMonitorWin::getInterfaceName() const {
@@ -176,7 +172,16 @@ bool SpeedMonitorWin::isConnected() const {
 }
 
 bool SpeedMonitorWin::isActive() const {
-    return (downloadRate_ > 0 || uploadRate_ > 0);
+    const MetricsSnapshot current = snapshot_.load();
+    return current.rx_rate > 0.0 || current.tx_rate > 0.0;
+}
+
+int SpeedMonitorWin::getSamplePeriodMs() const {
+    return snapshot_.load().sample_period_ms;
+}
+
+PacketRates SpeedMonitorWin::getPacketRates() const {
+    return packetRatesFromSnapshot(snapshot_.load());
 }
 
 QString SpeedMonitorWin::formatBytes(quint64 bytes) const {
@@ -2,10 +2,10 @@
 #include "../include/download_test.h"
 #include "../include/upload_test.h"
 #include "../include/ping_test.h"
+#include "../include/logger.h"
 #include <curl/curl.h>
 #include <cmath>
 #include <algorithm>
-#include <iostream>
 #include <cstring>
 
 SpeedTest::SpeedTest()
@@ -54,7 +54,7 @@ double SpeedTest::testDownloadSpeed(const TestServer& server, ProgressCallback c
         return downloadTest.run(server.downloadUrl, parallelConnections_, 
                                testDuration_, warmupTime_, callback);
     } catch (const std::exception& e) {
-        std::cerr << "Download test failed: " << e.what() << std::endl;
+        LOG_ERROR("Download test failed", logging::field("error", e.what()));
         return 0.0;
     }
 }
@@ -65,7 +65,7 @@ double SpeedTest::testUploadSpeed(const TestServer& server, ProgressCallback cal
         return uploadTest.run(server.uploadUrl, parallelConnections_, 
                              testDuration_, warmupTime_, callback);
     } catch (const std::exception& e) {
-        std::cerr << "Upload test failed: " << e.what() << std::endl;
+        LOG_ERROR("Upload test failed", logging::field("error", e.what()));
         return 0.0;
     }
 }
@@ -76,7 +76,7 @@ double SpeedTest::testPing(const TestServer& server, int count) {
         PingResults results = pingTest.run(server.host, 80, count);
         return results.avgMs;
     } catch (const std::exception& e) {
-        std::cerr << "Ping test failed: " << e.what() << std::endl;
+        LOG_ERROR("Ping test failed", logging::field("error", e.what()));
         return 0.0;
     }
 }
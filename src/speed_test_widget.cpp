@@ -648,6 +648,9 @@ void SpeedTestWidget::updateResults(const SpeedTestResult& result) {
             history_.pop_back();
         }
         refreshHistory();
+        if (resultListener_) {
+            resultListener_(result);
+        }
     }
     
     setTestRunning(false);
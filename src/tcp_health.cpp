@@ -0,0 +1,90 @@
+#include "../include/tcp_health.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#endif
+
+namespace {
+
+constexpr size_t kInitialRows = 1024;
+
+uint64_t sortValue(const TcpSocketInfo& info, TcpHealthTable::SortKey key) {
+    switch (key) {
+    case TcpHealthTable::SortKey::Rtt:
+        return info.rtt_us;
+    case TcpHealthTable::SortKey::Retransmits:
+        // Connections stuck in RTO backoff first, then by lifetime retransmits
+        return (static_cast<uint64_t>(info.retransmits) << 32) | info.total_retrans;
+    case TcpHealthTable::SortKey::Cwnd:
+        return info.snd_cwnd;
+    case TcpHealthTable::SortKey::DeliveryRate:
+    default:
+        return info.delivery_rate;
+    }
+}
+
+} // namespace
+
+TcpHealthTable::TcpHealthTable() {
+    rows_.reserve(kInitialRows);
+    order_.reserve(kInitialRows);
+}
+
+bool TcpHealthTable::isSupported() {
+    SockDiag probe;
+    return probe.isOpen();
+}
+
+bool TcpHealthTable::refresh() {
+#ifdef __linux__
+    if (!diag_) {
+        diag_.reset(new SockDiag());
+    }
+    rows_.clear();
+    return diag_->isOpen() && diag_->dumpTcp(tcpStateBit(TCP_ESTABLISHED), [this](const TcpSocketInfo& info) {
+        rows_.push_back(info);
+    });
+#else
+    return false;
+#endif
+}
+
+const std::vector<uint32_t>& TcpHealthTable::top(size_t k, SortKey key) {
+    order_.resize(rows_.size());
+    for (uint32_t i = 0; i < order_.size(); ++i) {
+        order_[i] = i;
+    }
+    const size_t count = std::min(k, order_.size());
+    std::partial_sort(order_.begin(), order_.begin() + count, order_.end(), [this, key](uint32_t a, uint32_t b) {
+        return sortValue(rows_[a], key) > sortValue(rows_[b], key);
+    });
+    order_.resize(count);
+    return order_;
+}
+
+char* TcpHealthTable::formatEndpoint(char* first, char* last, const TcpSocketInfo& info, bool remote) {
+    if (first >= last) {
+        return first;
+    }
+    const uint8_t* addr = remote ? info.remote_addr : info.local_addr;
+    const unsigned port = remote ? info.remote_port : info.local_port;
+    char host[48] = "?";
+#ifdef __linux__
+    inet_ntop(info.family == AF_INET6 ? AF_INET6 : AF_INET, addr, host, sizeof(host));
+    const bool bracket = info.family == AF_INET6;
+#else
+    (void)addr;
+    const bool bracket = false;
+#endif
+    const int written = std::snprintf(first, static_cast<size_t>(last - first), bracket ? "[%s]:%u" : "%s:%u",
+                                      host, port);
+    if (written < 0) {
+        return first;
+    }
+    return std::min(first + written, last - 1);
+}
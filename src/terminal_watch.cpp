@@ -0,0 +1,216 @@
+#include "../include/terminal_watch.h"
+#include "../include/helpers.h"
+#include "../include/label_renderer.h"
+#include "../include/speed_monitor.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <poll.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int kNameWidth = 16;
+constexpr int kRateWidth = 12;
+constexpr int kBytesWidth = 11;
+constexpr int kTableLines = 3 + static_cast<int>(WatchFrame::kTableRows);  // header, monitored, total, top
+
+// Appends into a fixed buffer; output past the end is dropped rather than
+// overflowing, which only a pathological terminal width could cause
+class Cursor {
+public:
+    Cursor(char* first, char* last) : first_(first), p_(first), last_(last) {}
+
+    void put(char c) {
+        if (p_ < last_) *p_++ = c;
+    }
+    void text(const char* s) {
+        while (*s) put(*s++);
+    }
+    // s padded with spaces to width, left- or right-aligned; truncated if longer
+    void field(const char* s, size_t length, int width, bool right) {
+        const size_t w = static_cast<size_t>(width);
+        if (length > w) length = w;
+        if (right) pad(w - length);
+        for (size_t i = 0; i < length; ++i) put(s[i]);
+        if (!right) pad(w - length);
+    }
+    void field(const char* s, int width, bool right) {
+        field(s, std::strlen(s), width, right);
+    }
+    void speed(double bytesPerSecond, int width) {
+        char tmp[32];
+        char* end = LabelRenderer::formatSpeed(tmp, tmp + sizeof(tmp), bytesPerSecond);
+        field(tmp, end ? static_cast<size_t>(end - tmp) : 0, width, true);
+    }
+    void bytes(uint64_t count, int width) {
+        static const char* const units[] = {"B", "KB", "MB", "GB", "TB"};
+        double value = static_cast<double>(count);
+        int unit = 0;
+        while (value >= 1024.0 && unit < 4) {
+            value /= 1024.0;
+            ++unit;
+        }
+        char tmp[32];
+        char* end = formatFixed(tmp, tmp + sizeof(tmp) - 4, value, unit == 0 ? 0 : 2);
+        if (!end) end = tmp;
+        *end++ = ' ';
+        for (const char* u = units[unit]; *u; ++u) *end++ = *u;
+        field(tmp, static_cast<size_t>(end - tmp), width, true);
+    }
+    void count(double value, int width) {
+        char tmp[32];
+        char* end = formatFixed(tmp, tmp + sizeof(tmp), value, 0);
+        field(tmp, end ? static_cast<size_t>(end - tmp) : 0, width, true);
+    }
+    size_t size() const { return static_cast<size_t>(p_ - first_); }
+
+private:
+    void pad(size_t n) {
+        while (n-- > 0) put(' ');
+    }
+
+    char* first_;
+    char* p_;
+    char* last_;
+};
+
+void rateRow(Cursor& out, const char* name, double rx, double tx) {
+    out.field(name, kNameWidth, false);
+    out.put(' ');
+    out.speed(rx, kRateWidth);
+    out.put(' ');
+    out.speed(tx, kRateWidth);
+    out.put('\n');
+}
+
+bool writeAll(const char* data, size_t size) {
+    while (size > 0) {
+        const ssize_t n = ::write(STDOUT_FILENO, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+WatchFrame::WatchFrame(bool terminal)
+    : terminal_(terminal), drawn_(false), table_(false) {
+    buffer_[0] = '\0';
+}
+
+size_t WatchFrame::render(const MetricsSnapshot& s, const InterfaceRate* total,
+                          const std::vector<InterfaceRate>& top) {
+    Cursor out(buffer_, buffer_ + kCapacity);
+    const bool table = total != nullptr;
+    if (terminal_ && drawn_) {
+        if (table_) {
+            // Back to the first line of the previous table
+            char up[16];
+            char* end = formatFixed(up + 2, up + sizeof(up), kTableLines, 0);
+            up[0] = '\033';
+            up[1] = '[';
+            *end++ = 'A';
+            for (char* c = up; c < end; ++c) out.put(*c);
+        }
+        out.put('\r');
+    }
+
+    if (!table) {
+        // iface  down  up  rx total  tx total  packets  [idle]
+        out.field(s.iface, strnlen(s.iface, sizeof(s.iface)), kNameWidth, false);
+        out.text(" down");
+        out.speed(s.rx_rate, kRateWidth);
+        out.text("  up");
+        out.speed(s.tx_rate, kRateWidth);
+        out.text("  rx");
+        out.bytes(s.total_rx_bytes, kBytesWidth);
+        out.text("  tx");
+        out.bytes(s.total_tx_bytes, kBytesWidth);
+        out.put(' ');
+        out.count(s.rx_packet_rate, 8);
+        out.put('/');
+        out.count(s.tx_packet_rate, 8);
+        out.text(" pps");
+        out.text(s.sampling_idle ? " idle" : "     ");
+        if (!terminal_) out.put('\n');
+    } else {
+        char name[kNameWidth + 1];
+        out.field("interface", kNameWidth, false);
+        out.put(' ');
+        out.field("download", kRateWidth, true);
+        out.put(' ');
+        out.field("upload", kRateWidth, true);
+        out.put('\n');
+        std::snprintf(name, sizeof(name), "%s*", s.iface);
+        rateRow(out, name, s.rx_rate, s.tx_rate);
+        rateRow(out, "all", total->rx_rate, total->tx_rate);
+        for (size_t i = 0; i < kTableRows; ++i) {
+            if (i < top.size()) {
+                rateRow(out, top[i].name.c_str(), top[i].rx_rate, top[i].tx_rate);
+            } else {
+                out.field("", kNameWidth + 2 * (kRateWidth + 1), false);
+                out.put('\n');
+            }
+        }
+    }
+    drawn_ = true;
+    table_ = table;
+    return out.size();
+}
+
+size_t WatchFrame::finish() {
+    if (terminal_ && drawn_ && !table_) {
+        buffer_[0] = '\n';
+        return 1;
+    }
+    return 0;
+}
+
+int runTerminalWatch(SpeedMeter& meter, const std::atomic<bool>& running) {
+    const int fd = meter.sample_event_fd();
+    WatchFrame frame(::isatty(STDOUT_FILENO) == 1);
+    const bool all = meter.is_all_interfaces();
+    std::vector<InterfaceRate> top;
+    InterfaceRate total;
+
+    auto draw = [&]() {
+        const MetricsSnapshot snapshot = meter.get_snapshot();
+        if (all) {
+            total = meter.get_all_interfaces_total();
+            top = meter.get_top_interfaces();
+        }
+        const size_t size = frame.render(snapshot, all ? &total : nullptr, top);
+        return writeAll(frame.data(), size);
+    };
+
+    // The first frame goes out as soon as the interface is known
+    bool ok = draw();
+    pollfd wait = pollfd();
+    wait.fd = fd;
+    wait.events = POLLIN;
+    while (ok && running.load()) {
+        const int ready = ::poll(&wait, 1, fd >= 0 ? 250 : 1000);
+        if (ready > 0) {
+            uint64_t count;
+            ssize_t ignored = ::read(fd, &count, sizeof(count));
+            (void)ignored;
+        } else if (ready == 0 && fd >= 0) {
+            continue; // no sample yet; recheck running
+        } else if (ready < 0 && errno != EINTR) {
+            break;
+        }
+        if (running.load()) {
+            ok = draw();
+        }
+    }
+    const size_t tail = frame.finish();
+    writeAll(frame.data(), tail);
+    return ok ? 0 : 1;
+}
@@ -14,8 +14,12 @@ void TrayIcon::createTrayIcon() {
 }
 
 void TrayIcon::set_label(const std::string& label, const std::string& tooltip) {
+    set_label(label.c_str(), tooltip.c_str());
+}
+
+void TrayIcon::set_label(const char* label, const char* tooltip) {
     if (indicator) {
-        app_indicator_set_label(indicator, label.c_str(), tooltip.c_str());
+        app_indicator_set_label(indicator, label, tooltip);
     }
 }
 
@@ -0,0 +1,91 @@
+#include "../include/usage_index.h"
+#include <algorithm>
+
+namespace {
+
+size_t lowbit(size_t i) {
+    return i & (~i + 1);
+}
+
+} // namespace
+
+void UsageIndex::resize(size_t count) {
+    if (count <= values_.size()) {
+        return;
+    }
+    values_.resize(count, ByteTotals());
+    tree_.reserve(count);
+    // New node i covers (i - lowbit(i), i]: everything before the new
+    // slots is already summed by the existing nodes
+    for (size_t i = tree_.size() + 1; i <= count; ++i) {
+        const ByteTotals upTo = prefix(i - 1);
+        const ByteTotals before = prefix(i - lowbit(i));
+        ByteTotals node = ByteTotals();
+        node.download_bytes = upTo.download_bytes - before.download_bytes;
+        node.upload_bytes = upTo.upload_bytes - before.upload_bytes;
+        tree_.push_back(node);
+    }
+}
+
+void UsageIndex::prepend(size_t count) {
+    if (count == 0) {
+        return;
+    }
+    values_.insert(values_.begin(), count, ByteTotals());
+    // Linear build: each node passes its sum on to its parent
+    tree_ = values_;
+    for (size_t i = 1; i <= tree_.size(); ++i) {
+        const size_t parent = i + lowbit(i);
+        if (parent <= tree_.size()) {
+            tree_[parent - 1].download_bytes += tree_[i - 1].download_bytes;
+            tree_[parent - 1].upload_bytes += tree_[i - 1].upload_bytes;
+        }
+    }
+}
+
+void UsageIndex::clear() {
+    values_.clear();
+    tree_.clear();
+}
+
+void UsageIndex::add(size_t slot, uint64_t download_bytes, uint64_t upload_bytes) {
+    if (slot >= values_.size()) {
+        return;
+    }
+    values_[slot].download_bytes += download_bytes;
+    values_[slot].upload_bytes += upload_bytes;
+    for (size_t i = slot + 1; i <= tree_.size(); i += lowbit(i)) {
+        tree_[i - 1].download_bytes += download_bytes;
+        tree_[i - 1].upload_bytes += upload_bytes;
+    }
+}
+
+void UsageIndex::set(size_t slot, const ByteTotals& value) {
+    if (slot >= values_.size()) {
+        return;
+    }
+    add(slot, value.download_bytes - values_[slot].download_bytes,
+        value.upload_bytes - values_[slot].upload_bytes);
+}
+
+ByteTotals UsageIndex::prefix(size_t count) const {
+    ByteTotals total = ByteTotals();
+    for (size_t i = std::min(count, tree_.size()); i > 0; i -= lowbit(i)) {
+        total.download_bytes += tree_[i - 1].download_bytes;
+        total.upload_bytes += tree_[i - 1].upload_bytes;
+    }
+    return total;
+}
+
+ByteTotals UsageIndex::sum(size_t from, size_t to) const {
+    to = std::min(to, values_.size());
+    if (from >= to) {
+        return ByteTotals();
+    }
+    const ByteTotals upTo = prefix(to);
+    const ByteTotals before = prefix(from);
+    ByteTotals total = ByteTotals();
+    total.download_bytes = upTo.download_bytes - before.download_bytes;
+    total.upload_bytes = upTo.upload_bytes - before.upload_bytes;
+    return total;
+}
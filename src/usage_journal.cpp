@@ -0,0 +1,197 @@
+#include "../include/usage_journal.h"
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace usage_journal;
+
+namespace {
+
+struct CrcTable {
+    uint32_t entries[256];
+
+    CrcTable() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            entries[i] = c;
+        }
+    }
+};
+
+FileHeader makeHeader(uint64_t generation) {
+    FileHeader header = FileHeader();
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.record_size = static_cast<uint16_t>(sizeof(Record));
+    header.generation = generation;
+    return header;
+}
+
+} // namespace
+
+uint32_t usage_journal::crc32(const void* data, size_t size) {
+    static const CrcTable table;
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint32_t c = 0xffffffffu;
+    for (size_t i = 0; i < size; ++i) {
+        c = table.entries[(c ^ p[i]) & 0xff] ^ (c >> 8);
+    }
+    return c ^ 0xffffffffu;
+}
+
+Record usage_journal::makeRecord(RecordType type, int32_t day) {
+    Record record;
+    std::memset(&record, 0, sizeof(record)); // padding included, for the CRC
+    record.type = static_cast<uint8_t>(type);
+    record.day = day;
+    return record;
+}
+
+void usage_journal::seal(Record& record) {
+    record.crc = crc32(reinterpret_cast<const char*>(&record) + sizeof(record.crc),
+                       sizeof(record) - sizeof(record.crc));
+}
+
+bool usage_journal::intact(const Record& record) {
+    return record.crc == crc32(reinterpret_cast<const char*>(&record) + sizeof(record.crc),
+                               sizeof(record) - sizeof(record.crc));
+}
+
+bool usage_journal::replaceFile(const std::string& source, const std::string& target) {
+#ifdef _WIN32
+    return MoveFileExA(source.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(source.c_str(), target.c_str()) == 0;
+#endif
+}
+
+bool usage_journal::syncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#elif defined(__linux__)
+    return ::fdatasync(fileno(file)) == 0;
+#else
+    return ::fsync(fileno(file)) == 0;
+#endif
+}
+
+void usage_journal::syncParentDirectory(const std::string& path) {
+#ifndef _WIN32
+    const size_t slash = path.find_last_of('/');
+    const std::string dir = slash == std::string::npos ? "." : path.substr(0, slash == 0 ? 1 : slash);
+    const int fd = ::open(dir.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+#else
+    (void)path; // MoveFileEx with MOVEFILE_WRITE_THROUGH already waits
+#endif
+}
+
+bool usage_journal::writeFileDurably(const std::string& path, const std::string& text) {
+    const std::string temp = path + ".tmp";
+    std::FILE* out = std::fopen(temp.c_str(), "wb");
+    if (!out) {
+        return false;
+    }
+    const bool written = std::fwrite(text.data(), 1, text.size(), out) == text.size() && syncFile(out);
+    if (std::fclose(out) != 0 || !written || !replaceFile(temp, path)) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    syncParentDirectory(path);
+    return true;
+}
+
+UsageJournal::UsageJournal() : file_(nullptr), records_(0), torn_(false) {
+}
+
+UsageJournal::~UsageJournal() {
+    close();
+}
+
+void UsageJournal::close() {
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+bool UsageJournal::open(const std::string& path, uint64_t generation,
+                        const std::function<void(const Record&)>& apply) {
+    close();
+    path_ = path;
+    records_ = 0;
+    torn_ = false;
+
+    std::FILE* in = std::fopen(path.c_str(), "rb");
+    if (in) {
+        FileHeader header;
+        const bool current = std::fread(&header, sizeof(header), 1, in) == 1 && header.magic == kMagic &&
+                             header.version == kVersion && header.record_size == sizeof(Record) &&
+                             header.generation == generation;
+        if (current) {
+            Record record;
+            size_t got;
+            while ((got = std::fread(&record, 1, sizeof(record), in)) == sizeof(record)) {
+                if (!intact(record)) {
+                    torn_ = true;
+                    break;
+                }
+                apply(record);
+                ++records_;
+            }
+            if (got != 0 && got != sizeof(record)) {
+                torn_ = true; // partial last record
+            }
+        }
+        std::fclose(in);
+        if (current) {
+            // After a torn tail the caller compacts, which resets the
+            // journal, before appending anything
+            file_ = std::fopen(path.c_str(), "ab");
+            return file_ != nullptr;
+        }
+    }
+    return reset(generation);
+}
+
+bool UsageJournal::append(const Record* records, size_t count) {
+    if (!file_ || count == 0) {
+        return file_ != nullptr;
+    }
+    const bool ok = std::fwrite(records, sizeof(Record), count, file_) == count && std::fflush(file_) == 0;
+    if (ok) {
+        records_ += count;
+    }
+    return ok;
+}
+
+bool UsageJournal::sync() {
+    return file_ != nullptr && syncFile(file_);
+}
+
+bool UsageJournal::reset(uint64_t generation) {
+    close();
+    const FileHeader header = makeHeader(generation);
+    if (!writeFileDurably(path_, std::string(reinterpret_cast<const char*>(&header), sizeof(header)))) {
+        return false;
+    }
+    records_ = 0;
+    torn_ = false;
+    file_ = std::fopen(path_.c_str(), "ab");
+    return file_ != nullptr;
+}
@@ -0,0 +1,205 @@
+#include "../include/usage_writer.h"
+#include "../include/logger.h"
+#include <algorithm>
+#include <cstdlib>
+
+using namespace usage_journal;
+
+UsageWriter::UsageWriter(std::chrono::milliseconds commit_interval)
+    : interval_(commit_interval),
+      generation_(0),
+      journal_records_(0),
+      snapshot_wanted_(false),
+      stopping_(false),
+      stats_() {
+}
+
+UsageWriter::~UsageWriter() {
+    stop();
+}
+
+bool UsageWriter::open(const std::string& snapshot_path, const std::string& journal_path, uint64_t generation,
+                       const std::function<void(const Record&)>& apply) {
+    snapshot_path_ = snapshot_path;
+    generation_ = generation;
+    const bool opened = journal_.open(journal_path, generation, apply);
+    std::lock_guard<std::mutex> lock(mutex_);
+    journal_records_ = journal_.records();
+    snapshot_wanted_ = !opened;
+    return opened;
+}
+
+void UsageWriter::start() {
+    if (!thread_.joinable()) {
+        stopping_ = false;
+        thread_ = std::thread(&UsageWriter::run, this);
+    }
+}
+
+void UsageWriter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void UsageWriter::append(const Record* records, size_t count) {
+    if (count == 0) {
+        return;
+    }
+    bool due;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.empty()) {
+            oldest_ = std::chrono::steady_clock::now();
+        }
+        queue_.insert(queue_.end(), records, records + count);
+        journal_records_ += count;
+        stats_.queue_depth = queue_.size();
+        due = interval_.count() == 0;
+    }
+    if (due) {
+        wake_.notify_one();
+    }
+}
+
+void UsageWriter::snapshot(Snapshot render) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_snapshot_ = std::move(render);
+        queue_.clear();
+        journal_records_ = 0;
+        snapshot_wanted_ = false;
+        stats_.queue_depth = 0;
+    }
+    wake_.notify_one();
+}
+
+void UsageWriter::writeFile(const std::string& path, std::string text) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        files_.emplace_back(path, std::move(text));
+    }
+    wake_.notify_one();
+}
+
+size_t UsageWriter::journalRecords() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return journal_records_;
+}
+
+bool UsageWriter::snapshotWanted() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return snapshot_wanted_;
+}
+
+PersistenceStats UsageWriter::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void UsageWriter::run() {
+    Snapshot render;
+    std::vector<Record> records;
+    std::vector<std::pair<std::string, std::string>> files;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        const bool urgent = pending_snapshot_ || !files_.empty() || stopping_;
+        if (queue_.empty() && !urgent) {
+            wake_.wait(lock);
+            continue;
+        }
+        if (!urgent && std::chrono::steady_clock::now() < oldest_ + interval_) {
+            // Group commit: let records gather until the oldest is due
+            wake_.wait_until(lock, oldest_ + interval_);
+            continue;
+        }
+        if (queue_.empty() && !pending_snapshot_ && files_.empty()) {
+            break; // stopping with nothing left
+        }
+
+        render.swap(pending_snapshot_);
+        pending_snapshot_ = nullptr;
+        records.swap(queue_);
+        files.swap(files_);
+        stats_.queue_depth = 0;
+        const bool journal_broken = snapshot_wanted_ && !render;
+        lock.unlock();
+
+        const auto started = std::chrono::steady_clock::now();
+        if (journal_broken) {
+            // Appending after a lost batch would leave a gap in the
+            // journal; the records stay in memory for the next snapshot
+            records.clear();
+        }
+        const size_t committed = records.size();
+        const bool snapshotted = static_cast<bool>(render);
+        const bool ok = commit(render, records, files);
+        const double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        render = nullptr;
+        records.clear();
+        files.clear();
+
+        lock.lock();
+        ++stats_.commits;
+        stats_.last_commit_seconds = seconds;
+        stats_.max_commit_seconds = std::max(stats_.max_commit_seconds, seconds);
+        stats_.commit_seconds_total += seconds;
+        if (ok) {
+            stats_.records += committed;
+            if (snapshotted) ++stats_.snapshots;
+        } else {
+            ++stats_.failures;
+            snapshot_wanted_ = true;
+        }
+    }
+}
+
+bool UsageWriter::commit(Snapshot& render, std::vector<Record>& records,
+                         std::vector<std::pair<std::string, std::string>>& files) {
+    for (const auto& file : files) {
+        if (!writeFileDurably(file.first, file.second)) {
+            LOG_WARN("Error writing file", logging::field("path", file.first));
+            // Not part of the usage history; the journal stays consistent
+        }
+    }
+
+    if (render) {
+        // Snapshot of generation g+1 first, then an empty journal of g+1;
+        // a crash in between leaves a stale journal that replay ignores
+        if (!writeFileDurably(snapshot_path_, render(generation_ + 1))) {
+            LOG_WARN("Error writing data file", logging::field("path", snapshot_path_));
+            return false;
+        }
+        ++generation_;
+        if (!journal_.reset(generation_)) {
+            LOG_WARN("Error resetting usage journal", logging::field("path", journal_.path()));
+            return false;
+        }
+    }
+
+    if (!records.empty() && !(journal_.append(records.data(), records.size()) && journal_.sync())) {
+        LOG_WARN("Error appending to usage journal", logging::field("path", journal_.path()));
+        return false;
+    }
+    return true;
+}
+
+std::chrono::milliseconds commitIntervalFromEnvironment(std::chrono::milliseconds fallback) {
+    const char* value = std::getenv("SPEED_METER_COMMIT_MS");
+    if (!value || !*value) {
+        return fallback;
+    }
+    char* end = nullptr;
+    const long ms = std::strtol(value, &end, 10);
+    if (*end != '\0' || ms < 0) {
+        return fallback;
+    }
+    return std::chrono::milliseconds(ms);
+}
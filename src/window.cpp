@@ -6,10 +6,16 @@
 #include <ctime>
 #include <fstream>
 #include <vector>
+#include <algorithm>
+#include <cstdio>
 
-Window::Window() : window(nullptr), uploadLabel(nullptr), downloadLabel(nullptr),
-                   totalLabel(nullptr), interfaceLabel(nullptr), ipLabel(nullptr),
-                   statusLabel(nullptr), startTime(std::chrono::system_clock::now()) {}
+Window::Window() : window(nullptr), uploadLabel(nullptr), downloadLabel(nullptr), packetsLabel(nullptr),
+                   totalLabel(nullptr), sessionRatesLabel(nullptr), interfaceLabel(nullptr), ipLabel(nullptr),
+                   statusLabel(nullptr), allInterfacesLabel(nullptr), processesLabel(nullptr), samplingLabel(nullptr),
+                   shownSamplePeriodMs(-1), tcpStore_(nullptr), tcpSummaryLabel_(nullptr),
+                   tcpSortKey_(TcpHealthTable::SortKey::DeliveryRate), notebook_(nullptr), nicLoadPage_(-1),
+                   cpuLoadStore_(nullptr), queueLoadStore_(nullptr), nicLoadSummaryLabel_(nullptr),
+                   dailyRatesLabel(nullptr), monthlyRatesLabel(nullptr), startTime(std::chrono::system_clock::now()) {}
 
 Window::~Window() {
     if (window) {
@@ -40,6 +46,7 @@ void Window::show() {
 
         // Create notebook for tabbed interface
         GtkWidget* notebook = gtk_notebook_new();
+        notebook_ = notebook;
         gtk_box_pack_start(GTK_BOX(mainVBox), notebook, TRUE, TRUE, 5);
         
         // Tab 1: Network Monitor
@@ -69,10 +76,28 @@ void Window::show() {
         
         // Tab 2: Speed Test
         speedTestWidget = std::make_unique<SpeedTestWidget>();
+        speedTestWidget->setResultListener([this](const SpeedTestResult& result) {
+            if (!dataManager) {
+                return;
+            }
+            SpeedTestRecord record = SpeedTestRecord();
+            record.unix_time = std::chrono::duration_cast<std::chrono::seconds>(
+                result.timestamp.time_since_epoch()).count();
+            record.download_mbps = result.downloadSpeedMbps;
+            record.upload_mbps = result.uploadSpeedMbps;
+            record.ping_ms = result.pingMs;
+            record.jitter_ms = result.jitterMs;
+            record.server = result.serverName;
+            dataManager->recordSpeedTest(record);
+        });
         GtkWidget* speedTestTab = speedTestWidget->create();
         gtk_notebook_append_page(GTK_NOTEBOOK(notebook), speedTestTab,
                                 gtk_label_new("Speed Test"));
 
+        // Tab 3: per-CPU softirq and NIC queue load
+        nicLoadPage_ = gtk_notebook_append_page(GTK_NOTEBOOK(notebook), createNicLoadTab(),
+                                                gtk_label_new("CPU & Queues"));
+
         // Connect the close event - prevent destruction, just hide
         g_signal_connect(window, "delete-event", G_CALLBACK(+[](GtkWidget*, GdkEvent*, gpointer self) {
             static_cast<Window*>(self)->handleClose();
@@ -137,6 +162,12 @@ void Window::createSpeedSection(GtkWidget* parent) {
     gtk_box_pack_start(GTK_BOX(uploadBox), uploadProgress_, TRUE, TRUE, 0);
     gtk_box_pack_start(GTK_BOX(vbox), uploadBox, FALSE, FALSE, 5);
 
+    // Packet rate, average size and drops; a flood of small packets or a
+    // dropping queue does not show in the byte rates
+    packetsLabel = GTK_LABEL(gtk_label_new("Packets: 0 /s down, 0 /s up"));
+    gtk_label_set_xalign(GTK_LABEL(packetsLabel), 0.0);
+    gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(packetsLabel), FALSE, FALSE, 2);
+
     // Peak speeds display
     GtkWidget* peakBox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 20);
     GtkWidget* peakDownloadLabel = gtk_label_new(NULL);
@@ -149,6 +180,227 @@ void Window::createSpeedSection(GtkWidget* parent) {
     gtk_box_pack_start(GTK_BOX(peakBox), peakDownloadLabel, TRUE, TRUE, 0);
     gtk_box_pack_start(GTK_BOX(peakBox), peakUploadLabel, TRUE, TRUE, 0);
     gtk_box_pack_start(GTK_BOX(vbox), peakBox, FALSE, FALSE, 10);
+
+    createTcpHealthTable(vbox);
+}
+
+namespace {
+
+constexpr size_t TCP_HEALTH_ROWS = 50;
+
+enum TcpColumn { TCP_COL_CONNECTION, TCP_COL_RTT, TCP_COL_RTTVAR, TCP_COL_CWND, TCP_COL_RETRANS,
+                 TCP_COL_PACING, TCP_COL_DELIVERY, TCP_COL_COUNT };
+
+struct TcpSortTarget {
+    Window* window;
+    TcpHealthTable::SortKey key;
+};
+
+} // namespace
+
+void Window::createTcpHealthTable(GtkWidget* parent) {
+    if (!TcpHealthTable::isSupported()) {
+        return; // no sock_diag (not Linux, or blocked); leave the section out
+    }
+    tcpHealth_.reset(new TcpHealthTable());
+
+    GtkWidget* expander = gtk_expander_new("TCP connections");
+    gtk_expander_set_expanded(GTK_EXPANDER(expander), TRUE);
+    gtk_box_pack_start(GTK_BOX(parent), expander, FALSE, FALSE, 5);
+
+    GtkWidget* box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 2);
+    gtk_container_add(GTK_CONTAINER(expander), box);
+
+    tcpSummaryLabel_ = GTK_LABEL(gtk_label_new(""));
+    gtk_label_set_xalign(GTK_LABEL(tcpSummaryLabel_), 0.0);
+    gtk_box_pack_start(GTK_BOX(box), GTK_WIDGET(tcpSummaryLabel_), FALSE, FALSE, 2);
+
+    tcpStore_ = gtk_list_store_new(TCP_COL_COUNT, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
+                                   G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING);
+    GtkWidget* view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(tcpStore_));
+    g_object_unref(tcpStore_); // the view holds the reference
+
+    struct ColumnSpec {
+        const char* title;
+        int column;
+        bool sortable;
+        TcpHealthTable::SortKey key;
+    };
+    static const ColumnSpec columns[] = {
+        {"Connection", TCP_COL_CONNECTION, false, TcpHealthTable::SortKey::DeliveryRate},
+        {"RTT", TCP_COL_RTT, true, TcpHealthTable::SortKey::Rtt},
+        {"RTT var", TCP_COL_RTTVAR, false, TcpHealthTable::SortKey::Rtt},
+        {"Cwnd", TCP_COL_CWND, true, TcpHealthTable::SortKey::Cwnd},
+        {"Retrans", TCP_COL_RETRANS, true, TcpHealthTable::SortKey::Retransmits},
+        {"Pacing", TCP_COL_PACING, false, TcpHealthTable::SortKey::DeliveryRate},
+        {"Delivery", TCP_COL_DELIVERY, true, TcpHealthTable::SortKey::DeliveryRate},
+    };
+    for (const ColumnSpec& spec : columns) {
+        GtkCellRenderer* renderer = gtk_cell_renderer_text_new();
+        if (spec.column != TCP_COL_CONNECTION) {
+            g_object_set(renderer, "xalign", 1.0, NULL);
+        }
+        GtkTreeViewColumn* column = gtk_tree_view_column_new_with_attributes(spec.title, renderer,
+                                                                             "text", spec.column, NULL);
+        gtk_tree_view_column_set_resizable(column, TRUE);
+        if (spec.sortable) {
+            // Clicking a header re-ranks the top rows by that metric
+            gtk_tree_view_column_set_clickable(column, TRUE);
+            TcpSortTarget* target = new TcpSortTarget{this, spec.key};
+            g_signal_connect_data(column, "clicked", G_CALLBACK(+[](GtkTreeViewColumn*, gpointer data) {
+                TcpSortTarget* target = static_cast<TcpSortTarget*>(data);
+                target->window->tcpSortKey_ = target->key;
+                target->window->renderTcpHealth();
+            }), target, +[](gpointer data, GClosure*) { delete static_cast<TcpSortTarget*>(data); },
+            G_CONNECT_AFTER);
+        }
+        gtk_tree_view_append_column(GTK_TREE_VIEW(view), column);
+    }
+
+    GtkWidget* scroll = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scroll), GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    gtk_widget_set_size_request(scroll, -1, 180);
+    gtk_container_add(GTK_CONTAINER(scroll), view);
+    gtk_box_pack_start(GTK_BOX(box), scroll, TRUE, TRUE, 0);
+}
+
+namespace {
+
+enum CpuLoadColumn { CPU_COL_NAME, CPU_COL_NET_RX, CPU_COL_NET_TX, CPU_COL_IRQS, CPU_COL_SHARE, CPU_COL_COUNT };
+enum QueueLoadColumn { QUEUE_COL_NAME, QUEUE_COL_RATE, QUEUE_COL_SHARE, QUEUE_COL_COUNT };
+
+GtkWidget* newLoadView(GtkListStore* store, const char* const* titles, int textColumns, int shareColumn) {
+    GtkWidget* view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(store));
+    g_object_unref(store); // the view holds the reference
+    for (int column = 0; column < textColumns; ++column) {
+        GtkCellRenderer* renderer = gtk_cell_renderer_text_new();
+        if (column > 0) {
+            g_object_set(renderer, "xalign", 1.0, NULL);
+        }
+        gtk_tree_view_append_column(GTK_TREE_VIEW(view),
+            gtk_tree_view_column_new_with_attributes(titles[column], renderer, "text", column, NULL));
+    }
+    GtkTreeViewColumn* share = gtk_tree_view_column_new_with_attributes(titles[shareColumn],
+        gtk_cell_renderer_progress_new(), "value", shareColumn, NULL);
+    gtk_tree_view_column_set_expand(share, TRUE);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(view), share);
+
+    GtkWidget* scroll = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scroll), GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    gtk_container_add(GTK_CONTAINER(scroll), view);
+    return scroll;
+}
+
+// Reuse the store's rows: step to the next one, appending when it runs out
+void nextStoreRow(GtkListStore* store, GtkTreeIter* iter, gboolean* haveRow) {
+    if (*haveRow) {
+        *haveRow = gtk_tree_model_iter_next(GTK_TREE_MODEL(store), iter);
+    }
+}
+
+void ensureStoreRow(GtkListStore* store, GtkTreeIter* iter, gboolean haveRow) {
+    if (!haveRow) {
+        gtk_list_store_append(store, iter);
+    }
+}
+
+void trimStore(GtkListStore* store, GtkTreeIter* iter, gboolean haveRow) {
+    while (haveRow) {
+        haveRow = gtk_list_store_remove(store, iter);
+    }
+}
+
+} // namespace
+
+GtkWidget* Window::createNicLoadTab() {
+    GtkWidget* tab = gtk_box_new(GTK_ORIENTATION_VERTICAL, 8);
+    gtk_container_set_border_width(GTK_CONTAINER(tab), 10);
+
+    nicLoadSummaryLabel_ = GTK_LABEL(gtk_label_new("Collecting..."));
+    gtk_label_set_xalign(GTK_LABEL(nicLoadSummaryLabel_), 0.0);
+    gtk_label_set_line_wrap(GTK_LABEL(nicLoadSummaryLabel_), TRUE);
+    gtk_box_pack_start(GTK_BOX(tab), GTK_WIDGET(nicLoadSummaryLabel_), FALSE, FALSE, 2);
+
+    // One row per CPU: network softirqs and the NIC's hardware interrupts
+    GtkWidget* cpuFrame = gtk_frame_new("Per-CPU network softirqs");
+    gtk_box_pack_start(GTK_BOX(tab), cpuFrame, TRUE, TRUE, 0);
+    static const char* const cpuTitles[] = {"CPU", "NET_RX/s", "NET_TX/s", "NIC IRQ/s", "Share of NET_RX"};
+    cpuLoadStore_ = gtk_list_store_new(CPU_COL_COUNT, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
+                                       G_TYPE_STRING, G_TYPE_INT);
+    gtk_container_add(GTK_CONTAINER(cpuFrame), newLoadView(cpuLoadStore_, cpuTitles, CPU_COL_SHARE, CPU_COL_SHARE));
+
+    // One row per hardware queue of the monitored interface
+    GtkWidget* queueFrame = gtk_frame_new("NIC queues");
+    gtk_box_pack_start(GTK_BOX(tab), queueFrame, TRUE, TRUE, 0);
+    static const char* const queueTitles[] = {"Queue", "Rate", "Share of direction"};
+    queueLoadStore_ = gtk_list_store_new(QUEUE_COL_COUNT, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_INT);
+    gtk_container_add(GTK_CONTAINER(queueFrame),
+                      newLoadView(queueLoadStore_, queueTitles, QUEUE_COL_SHARE, QUEUE_COL_SHARE));
+    return tab;
+}
+
+bool Window::isNicLoadVisible() const {
+    return window && notebook_ && nicLoadPage_ >= 0 && gtk_widget_get_visible(window) &&
+           gtk_notebook_get_current_page(GTK_NOTEBOOK(notebook_)) == nicLoadPage_;
+}
+
+void Window::updateNicLoad(const NicLoad& load) {
+    if (!cpuLoadStore_ || !queueLoadStore_) return;
+
+    double totalRx = 0.0;
+    size_t busiest = 0;
+    for (size_t i = 0; i < load.cpus.size(); ++i) {
+        totalRx += load.cpus[i].net_rx;
+        if (load.cpus[i].net_rx > load.cpus[busiest].net_rx) busiest = i;
+    }
+
+    GtkTreeIter iter;
+    gboolean haveRow = gtk_tree_model_get_iter_first(GTK_TREE_MODEL(cpuLoadStore_), &iter);
+    for (const CpuNetLoad& cpu : load.cpus) {
+        char name[16], rx[32], tx[32], irqs[32];
+        std::snprintf(name, sizeof(name), "CPU%d", cpu.cpu);
+        std::snprintf(rx, sizeof(rx), "%.0f", cpu.net_rx);
+        std::snprintf(tx, sizeof(tx), "%.0f", cpu.net_tx);
+        std::snprintf(irqs, sizeof(irqs), "%.0f", cpu.nic_irqs);
+        const int share = totalRx > 0.0 ? static_cast<int>(cpu.net_rx * 100.0 / totalRx + 0.5) : 0;
+        ensureStoreRow(cpuLoadStore_, &iter, haveRow);
+        gtk_list_store_set(cpuLoadStore_, &iter, CPU_COL_NAME, name, CPU_COL_NET_RX, rx, CPU_COL_NET_TX, tx,
+                           CPU_COL_IRQS, irqs, CPU_COL_SHARE, share, -1);
+        nextStoreRow(cpuLoadStore_, &iter, &haveRow);
+    }
+    trimStore(cpuLoadStore_, &iter, haveRow);
+
+    double totalQueueRx = 0.0, totalQueueTx = 0.0;
+    for (const NicQueueLoad& queue : load.queues) {
+        (queue.name[0] == 'r' ? totalQueueRx : totalQueueTx) += queue.bytes_per_sec;
+    }
+    haveRow = gtk_tree_model_get_iter_first(GTK_TREE_MODEL(queueLoadStore_), &iter);
+    for (const NicQueueLoad& queue : load.queues) {
+        const double total = queue.name[0] == 'r' ? totalQueueRx : totalQueueTx;
+        const int share = total > 0.0 ? static_cast<int>(queue.bytes_per_sec * 100.0 / total + 0.5) : 0;
+        ensureStoreRow(queueLoadStore_, &iter, haveRow);
+        gtk_list_store_set(queueLoadStore_, &iter, QUEUE_COL_NAME, queue.name,
+                           QUEUE_COL_RATE, formatSpeedSimple(queue.bytes_per_sec).c_str(),
+                           QUEUE_COL_SHARE, share, -1);
+        nextStoreRow(queueLoadStore_, &iter, &haveRow);
+    }
+    trimStore(queueLoadStore_, &iter, haveRow);
+
+    if (nicLoadSummaryLabel_) {
+        std::stringstream text;
+        if (totalRx > 0.0 && !load.cpus.empty()) {
+            text << "NET_RX: " << std::fixed << std::setprecision(0)
+                 << load.cpus[busiest].net_rx * 100.0 / totalRx << "% on CPU" << load.cpus[busiest].cpu
+                 << " of " << load.cpus.size() << " CPUs";
+        } else {
+            text << "No receive softirqs in the last sample";
+        }
+        text << " - " << load.nic_irq_lines << " NIC interrupt vector" << (load.nic_irq_lines == 1 ? "" : "s");
+        if (!load.queue_bytes_known) {
+            text << "\nThe driver reports no per-queue byte counters.";
+        }
+        gtk_label_set_text(nicLoadSummaryLabel_, text.str().c_str());
+    }
 }
 
 void Window::createSessionStatsSection(GtkWidget* parent) {
@@ -173,6 +425,11 @@ void Window::createSessionStatsSection(GtkWidget* parent) {
     avgSpeedLabel = GTK_LABEL(gtk_label_new("Average: 0 B/s down, 0 B/s up"));
     gtk_label_set_xalign(GTK_LABEL(avgSpeedLabel), 0.0);
     gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(avgSpeedLabel), FALSE, FALSE, 2);
+
+    // Percentiles of every raw sample; the average hides short stalls and bursts
+    sessionRatesLabel = GTK_LABEL(gtk_label_new("Rates: no samples yet"));
+    gtk_label_set_xalign(GTK_LABEL(sessionRatesLabel), 0.0);
+    gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(sessionRatesLabel), FALSE, FALSE, 2);
 }
 
 void Window::createInterfaceSection(GtkWidget* parent) {
@@ -197,6 +454,21 @@ void Window::createInterfaceSection(GtkWidget* parent) {
     statusLabel = GTK_LABEL(gtk_label_new("Status: Disconnected"));
     gtk_label_set_xalign(GTK_LABEL(statusLabel), 0.0);
     gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(statusLabel), FALSE, FALSE, 2);
+
+    // Current sampling period (longer while the link is idle)
+    samplingLabel = GTK_LABEL(gtk_label_new("Sampling: -"));
+    gtk_label_set_xalign(GTK_LABEL(samplingLabel), 0.0);
+    gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(samplingLabel), FALSE, FALSE, 2);
+
+    // Totals and busiest interfaces (all-interface mode only)
+    allInterfacesLabel = GTK_LABEL(gtk_label_new(""));
+    gtk_label_set_xalign(GTK_LABEL(allInterfacesLabel), 0.0);
+    gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(allInterfacesLabel), FALSE, FALSE, 2);
+
+    // Busiest processes (SPEED_METER_PROCESSES=1 only)
+    processesLabel = GTK_LABEL(gtk_label_new(""));
+    gtk_label_set_xalign(GTK_LABEL(processesLabel), 0.0);
+    gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(processesLabel), FALSE, FALSE, 2);
 }
 
 void Window::createMonthlyStatsSection(GtkWidget* parent) {
@@ -225,6 +497,15 @@ void Window::createMonthlyStatsSection(GtkWidget* parent) {
     monthlyPeakUploadLabel = GTK_LABEL(gtk_label_new("Peak Upload: 0 MB/s"));
     gtk_label_set_xalign(GTK_LABEL(monthlyPeakUploadLabel), 0.0);
     gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(monthlyPeakUploadLabel), FALSE, FALSE, 2);
+
+    // Rate percentiles from the saved daily digests
+    dailyRatesLabel = GTK_LABEL(gtk_label_new("Today: no samples yet"));
+    gtk_label_set_xalign(GTK_LABEL(dailyRatesLabel), 0.0);
+    gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(dailyRatesLabel), FALSE, FALSE, 2);
+
+    monthlyRatesLabel = GTK_LABEL(gtk_label_new("This month: no samples yet"));
+    gtk_label_set_xalign(GTK_LABEL(monthlyRatesLabel), 0.0);
+    gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(monthlyRatesLabel), FALSE, FALSE, 2);
 }
 
 void Window::createDataLimitSection(GtkWidget* parent) {
@@ -311,6 +592,10 @@ void Window::updateSpeeds(double uploadSpeed, double downloadSpeed, double total
     data.uploadSpeed = uploadSpeed;
     data.totalDownload = totalDownload;
     data.totalUpload = totalUpload;
+    data.rxPacketRate = 0.0;
+    data.txPacketRate = 0.0;
+    data.rxDropRate = 0.0;
+    data.txDropRate = 0.0;
     
     usageHistory.push_back(data);
     
@@ -339,6 +624,154 @@ void Window::updateSpeeds(double uploadSpeed, double downloadSpeed, double total
     updateMonthlyStats();
 }
 
+void Window::updatePacketRates(const MetricsSnapshot& snapshot) {
+    if (!usageHistory.empty()) {
+        UsageData& data = usageHistory.back();
+        data.rxPacketRate = snapshot.rx_packet_rate;
+        data.txPacketRate = snapshot.tx_packet_rate;
+        data.rxDropRate = snapshot.rx_drop_rate;
+        data.txDropRate = snapshot.tx_drop_rate;
+    }
+    if (!packetsLabel) return;
+
+    std::stringstream text;
+    text << std::fixed << std::setprecision(0)
+         << "Packets: " << snapshot.rx_packet_rate << " /s down, " << snapshot.tx_packet_rate << " /s up"
+         << "    Avg size: " << averagePacketSize(snapshot.rx_rate, snapshot.rx_packet_rate) << " B down, "
+         << averagePacketSize(snapshot.tx_rate, snapshot.tx_packet_rate) << " B up";
+    if (snapshot.total_rx_dropped != 0 || snapshot.total_tx_dropped != 0 ||
+        snapshot.total_rx_errors != 0 || snapshot.total_tx_errors != 0) {
+        text << std::setprecision(1)
+             << "\nDrops: " << snapshot.rx_drop_rate << " /s down, " << snapshot.tx_drop_rate << " /s up ("
+             << snapshot.total_rx_dropped << " / " << snapshot.total_tx_dropped << " total)"
+             << "    Errors: " << snapshot.total_rx_errors << " / " << snapshot.total_tx_errors;
+    }
+    gtk_label_set_text(packetsLabel, text.str().c_str());
+}
+
+void Window::updateSessionRates(const RateDigest& session) {
+    if (!sessionRatesLabel || session.download.count() == 0) return;
+
+    std::string text = "Rates:\n" + formatPercentiles(session.download) + " down\n" +
+                       formatPercentiles(session.upload) + " up";
+    gtk_label_set_text(sessionRatesLabel, text.c_str());
+}
+
+void Window::updateInterfaceTable(const InterfaceRate& total, const std::vector<InterfaceRate>& top) {
+    if (!allInterfacesLabel) return;
+
+    std::stringstream text;
+    text << "All interfaces: " << formatSpeedSimple(total.rx_rate) << " down, "
+         << formatSpeedSimple(total.tx_rate) << " up";
+    for (const auto& entry : top) {
+        text << "\n    " << entry.name << ": " << formatSpeedSimple(entry.rx_rate) << " down, "
+             << formatSpeedSimple(entry.tx_rate) << " up";
+    }
+    gtk_label_set_text(allInterfacesLabel, text.str().c_str());
+}
+
+void Window::updateProcessTable(const std::vector<ProcessRate>& top) {
+    if (!processesLabel) return;
+
+    std::stringstream text;
+    text << "Top processes (TCP):";
+    if (top.empty()) {
+        text << " none active";
+    }
+    for (const auto& entry : top) {
+        text << "\n    " << (entry.name.empty() ? "?" : entry.name) << " [" << entry.pid << "]: "
+             << formatSpeedSimple(entry.rx_rate) << " down, " << formatSpeedSimple(entry.tx_rate) << " up";
+    }
+    gtk_label_set_text(processesLabel, text.str().c_str());
+}
+
+bool Window::isTcpHealthVisible() const {
+    return tcpHealth_ && tcpStore_ && window && gtk_widget_get_visible(window);
+}
+
+void Window::updateTcpHealth(std::vector<TcpSocketInfo>& rows) {
+    if (!tcpHealth_) return;
+    tcpHealth_->swapRows(rows);
+    renderTcpHealth();
+}
+
+void Window::renderTcpHealth() {
+    if (!tcpHealth_ || !tcpStore_) return;
+
+    const std::vector<uint32_t>& order = tcpHealth_->top(TCP_HEALTH_ROWS, tcpSortKey_);
+
+    // Update rows in place so the scroll position survives a refresh
+    GtkTreeModel* model = GTK_TREE_MODEL(tcpStore_);
+    GtkTreeIter iter;
+    gboolean haveRow = gtk_tree_model_get_iter_first(model, &iter);
+    for (uint32_t index : order) {
+        const TcpSocketInfo& info = tcpHealth_->row(index);
+        char local[64], remote[64], connection[136];
+        TcpHealthTable::formatEndpoint(local, local + sizeof(local), info, false);
+        TcpHealthTable::formatEndpoint(remote, remote + sizeof(remote), info, true);
+        std::snprintf(connection, sizeof(connection), "%s → %s", local, remote);
+
+        char rtt[32], rttvar[32], cwnd[16], retrans[32];
+        std::snprintf(rtt, sizeof(rtt), "%.1f ms", info.rtt_us / 1000.0);
+        std::snprintf(rttvar, sizeof(rttvar), "%.1f ms", info.rttvar_us / 1000.0);
+        std::snprintf(cwnd, sizeof(cwnd), "%u", info.snd_cwnd);
+        std::snprintf(retrans, sizeof(retrans), info.retransmits ? "%u (%u RTO)" : "%u", info.total_retrans,
+                      info.retransmits);
+
+        if (!haveRow) {
+            gtk_list_store_append(tcpStore_, &iter);
+        }
+        gtk_list_store_set(tcpStore_, &iter,
+                           TCP_COL_CONNECTION, connection,
+                           TCP_COL_RTT, rtt,
+                           TCP_COL_RTTVAR, rttvar,
+                           TCP_COL_CWND, cwnd,
+                           TCP_COL_RETRANS, retrans,
+                           TCP_COL_PACING, formatSpeedSimple(static_cast<double>(info.pacing_rate)).c_str(),
+                           TCP_COL_DELIVERY, formatSpeedSimple(static_cast<double>(info.delivery_rate)).c_str(),
+                           -1);
+        haveRow = haveRow && gtk_tree_model_iter_next(model, &iter);
+    }
+    while (haveRow) {
+        haveRow = gtk_list_store_remove(tcpStore_, &iter);
+    }
+
+    if (tcpSummaryLabel_) {
+        static const char* const sortNames[] = {"delivery rate", "RTT", "retransmits", "cwnd"};
+        std::stringstream text;
+        text << tcpHealth_->size() << " established";
+        if (tcpHealth_->size() > order.size()) {
+            text << ", top " << order.size();
+        }
+        text << " by " << sortNames[static_cast<int>(tcpSortKey_)];
+        size_t retransmitting = 0;
+        for (uint32_t i = 0; i < tcpHealth_->size(); ++i) {
+            if (tcpHealth_->row(i).retransmits) ++retransmitting;
+        }
+        if (retransmitting) {
+            text << " - " << retransmitting << " in RTO backoff";
+        }
+        gtk_label_set_text(tcpSummaryLabel_, text.str().c_str());
+    }
+}
+
+void Window::updateSamplePeriod(int periodMs, bool idle) {
+    if (!samplingLabel || periodMs == shownSamplePeriodMs) return;
+    shownSamplePeriodMs = periodMs;
+
+    std::stringstream text;
+    text << "Sampling: every ";
+    if (periodMs >= 1000) {
+        text << std::fixed << std::setprecision(periodMs % 1000 ? 1 : 0) << periodMs / 1000.0 << " s";
+    } else {
+        text << periodMs << " ms";
+    }
+    if (idle) {
+        text << " (idle)";
+    }
+    gtk_label_set_text(samplingLabel, text.str().c_str());
+}
+
 void Window::updateSessionInfo(double totalUpload, double totalDownload) {
     if (!sessionTimeLabel || !avgSpeedLabel) return;
 
@@ -401,6 +834,21 @@ void Window::updateMonthlyStats() {
         gtk_label_set_text(monthlyPeakUploadLabel, text.str().c_str());
     }
 
+    if (monthlyRatesLabel && monthly.rates.download.count() > 0) {
+        std::string text = "This month:\n" + formatPercentiles(monthly.rates.download) + " down\n" +
+                           formatPercentiles(monthly.rates.upload) + " up";
+        gtk_label_set_text(monthlyRatesLabel, text.c_str());
+    }
+
+    if (dailyRatesLabel) {
+        DailyStats today = dataManager->getTodayStats();
+        if (today.rates.download.count() > 0) {
+            std::string text = "Today:\n" + formatPercentiles(today.rates.download) + " down\n" +
+                               formatPercentiles(today.rates.upload) + " up";
+            gtk_label_set_text(dailyRatesLabel, text.c_str());
+        }
+    }
+
     // Update data usage
     if (dataUsageLabel) {
         double usagePercent = dataManager->getDataUsagePercentage();
@@ -466,6 +914,53 @@ std::string Window::formatBytes(double bytes) {
     return ss.str();
 }
 
+std::string Window::formatPercentiles(const RateHistogram& rates) {
+    return "    p50 " + formatSpeedSimple(rates.percentile(0.50)) +
+           "  p95 " + formatSpeedSimple(rates.percentile(0.95)) +
+           "  p99 " + formatSpeedSimple(rates.percentile(0.99)) +
+           "  max " + formatSpeedSimple(rates.max());
+}
+
+std::string Window::formatPercentiles(const double* percentiles, double peak) {
+    return "    p50 " + formatSpeedSimple(percentiles[0]) +
+           "  p95 " + formatSpeedSimple(percentiles[1]) +
+           "  p99 " + formatSpeedSimple(percentiles[2]) +
+           "  max " + formatSpeedSimple(peak);
+}
+
+void Window::updateUsageHistory(const meter_protocol::HistoryRow* today, const meter_protocol::HistoryRow* month) {
+    if (month) {
+        if (monthlyDownloadLabel) {
+            const std::string text = "Monthly Download: " + formatBytes(month->download_bytes);
+            gtk_label_set_text(monthlyDownloadLabel, text.c_str());
+        }
+        if (monthlyUploadLabel) {
+            const std::string text = "Monthly Upload: " + formatBytes(month->upload_bytes);
+            gtk_label_set_text(monthlyUploadLabel, text.c_str());
+        }
+        if (monthlyPeakDownloadLabel) {
+            const std::string text = "Peak Download: " + formatSpeedSimple(month->peak_download);
+            gtk_label_set_text(monthlyPeakDownloadLabel, text.c_str());
+        }
+        if (monthlyPeakUploadLabel) {
+            const std::string text = "Peak Upload: " + formatSpeedSimple(month->peak_upload);
+            gtk_label_set_text(monthlyPeakUploadLabel, text.c_str());
+        }
+        if (monthlyRatesLabel && month->peak_download > 0.0) {
+            const std::string text = "This month:\n" +
+                                     formatPercentiles(month->download_percentiles, month->peak_download) + " down\n" +
+                                     formatPercentiles(month->upload_percentiles, month->peak_upload) + " up";
+            gtk_label_set_text(monthlyRatesLabel, text.c_str());
+        }
+    }
+    if (today && dailyRatesLabel && today->peak_download > 0.0) {
+        const std::string text = "Today:\n" +
+                                 formatPercentiles(today->download_percentiles, today->peak_download) + " down\n" +
+                                 formatPercentiles(today->upload_percentiles, today->peak_upload) + " up";
+        gtk_label_set_text(dailyRatesLabel, text.c_str());
+    }
+}
+
 void Window::resetStatistics() {
     // Reset session start time
     startTime = std::chrono::system_clock::now();
@@ -504,7 +999,9 @@ void Window::exportToCSV() {
         std::ofstream file(filename);
         if (file.is_open()) {
             // Write CSV header
-            file << "Timestamp,Download Speed (MB/s),Upload Speed (MB/s),Total Download (MB),Total Upload (MB)\n";
+            file << "Timestamp,Download Speed (MB/s),Upload Speed (MB/s),Total Download (MB),Total Upload (MB),"
+                    "Download Packets/s,Upload Packets/s,Avg Download Packet (B),Avg Upload Packet (B),"
+                    "Download Drops/s,Upload Drops/s\n";
             
             // Write data
             for (const auto& data : usageHistory) {
@@ -517,7 +1014,13 @@ void Window::exportToCSV() {
                      << std::fixed << std::setprecision(3) << (data.downloadSpeed / (1024.0 * 1024.0)) << ","
                      << std::fixed << std::setprecision(3) << (data.uploadSpeed / (1024.0 * 1024.0)) << ","
                      << std::fixed << std::setprecision(2) << (data.totalDownload / (1024.0 * 1024.0)) << ","
-                     << std::fixed << std::setprecision(2) << (data.totalUpload / (1024.0 * 1024.0)) << "\n";
+                     << std::fixed << std::setprecision(2) << (data.totalUpload / (1024.0 * 1024.0)) << ","
+                     << std::fixed << std::setprecision(1) << data.rxPacketRate << ","
+                     << data.txPacketRate << ","
+                     << averagePacketSize(data.downloadSpeed, data.rxPacketRate) << ","
+                     << averagePacketSize(data.uploadSpeed, data.txPacketRate) << ","
+                     << std::setprecision(2) << data.rxDropRate << ","
+                     << data.txDropRate << "\n";
             }
             
             file.close();
@@ -588,7 +1091,16 @@ void Window::exportToJSON() {
                 file << "      \"totalDownloadMB\": " << std::fixed << std::setprecision(2) 
                      << (data.totalDownload / (1024.0 * 1024.0)) << ",\n";
                 file << "      \"totalUploadMB\": " << std::fixed << std::setprecision(2) 
-                     << (data.totalUpload / (1024.0 * 1024.0)) << "\n";
+                     << (data.totalUpload / (1024.0 * 1024.0)) << ",\n";
+                file << "      \"downloadPacketsPerSec\": " << std::fixed << std::setprecision(1)
+                     << data.rxPacketRate << ",\n";
+                file << "      \"uploadPacketsPerSec\": " << data.txPacketRate << ",\n";
+                file << "      \"avgDownloadPacketBytes\": "
+                     << averagePacketSize(data.downloadSpeed, data.rxPacketRate) << ",\n";
+                file << "      \"avgUploadPacketBytes\": "
+                     << averagePacketSize(data.uploadSpeed, data.txPacketRate) << ",\n";
+                file << "      \"downloadDropsPerSec\": " << std::setprecision(2) << data.rxDropRate << ",\n";
+                file << "      \"uploadDropsPerSec\": " << data.txDropRate << "\n";
                 file << "    }" << (i < usageHistory.size() - 1 ? "," : "") << "\n";
             }
             